@@ -255,11 +255,11 @@ protected:
             // do the gravity correction: compute the hydrostatic pressure for the
             // external at the depth of the internal one
             const Evaluation& rhoIn = intQuantsIn.fluidState().density(phaseIdx);
-            Scalar rhoEx = Toolbox::value(intQuantsEx.fluidState().density(phaseIdx));
+            auto rhoEx = ElementContext::exteriorValue(intQuantsEx.fluidState().density(phaseIdx));
             Evaluation rhoAvg = (rhoIn + rhoEx)/2;
 
             const Evaluation& pressureInterior = intQuantsIn.fluidState().pressure(phaseIdx);
-            Evaluation pressureExterior = Toolbox::value(intQuantsEx.fluidState().pressure(phaseIdx));
+            Evaluation pressureExterior = ElementContext::exteriorValue(intQuantsEx.fluidState().pressure(phaseIdx));
             pressureExterior += rhoAvg*(distZ*g);
 
             pressureDifference_[phaseIdx] = pressureExterior - pressureInterior;
@@ -330,7 +330,7 @@ protected:
                     pressureDifference_[phaseIdx]*up.mobility(phaseIdx)*(-trans_/faceArea_);
             else
                 volumeFlux_[phaseIdx] =
-                    pressureDifference_[phaseIdx]*(Toolbox::value(up.mobility(phaseIdx))*(-trans_/faceArea_));
+                    pressureDifference_[phaseIdx]*(ElementContext::exteriorValue(up.mobility(phaseIdx))*(-trans_/faceArea_));
 
         }
     }
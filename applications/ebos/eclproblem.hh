@@ -366,6 +366,9 @@ public:
         // reload the current episode/report step from the deck
         beginEpisode(/*isOnRestart=*/true);
 
+        // deserialize the state of the base problem, e.g. the time step controller
+        ParentType::deserialize(res);
+
         // deserialize the wells
         wellManager_.deserialize(res);
     }
@@ -376,7 +379,10 @@ public:
      */
     template <class Restarter>
     void serialize(Restarter &res)
-    { wellManager_.serialize(res); }
+    {
+        ParentType::serialize(res);
+        wellManager_.serialize(res);
+    }
 
     /*!
      * \brief Called by the simulator before an episode begins.
@@ -1232,7 +1238,7 @@ private:
         if (!materialLawManager_->enableHysteresis())
             return false;
 
-        ElementContext elemCtx(this->simulator());
+        ElementContext& elemCtx = this->model().threadElementContext();
         const auto& gridManager = this->simulator().gridManager();
         auto elemIt = gridManager.gridView().template begin</*codim=*/0>();
         const auto& elemEndIt = gridManager.gridView().template end</*codim=*/0>();
@@ -65,15 +65,21 @@ SET_TYPE_PROP(AutoDiffLocalLinearizer, LocalLinearizer,
               Ewoms::FvBaseAdLocalLinearizer<TypeTag>);
 
 //! Set the function evaluation w.r.t. the primary variables
+//!
+//! If the face-based linearization is enabled, the derivatives with regard to the
+//! primary variables of the two degrees of freedom adjacent to a face are stored
+//! separately.
 SET_PROP(AutoDiffLocalLinearizer, Evaluation)
 {
 private:
-    static const int numEq = GET_PROP_VALUE(TypeTag, NumEq);
+    static const int numDerivs =
+        GET_PROP_VALUE(TypeTag, NumEq)
+        * (GET_PROP_VALUE(TypeTag, EnableFaceBasedLinearization) ? 2 : 1);
 
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
 
 public:
-    typedef Opm::DenseAd::Evaluation<Scalar, numEq> type;
+    typedef Opm::DenseAd::Evaluation<Scalar, numDerivs> type;
 };
 
 } // namespace Properties
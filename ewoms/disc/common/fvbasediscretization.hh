@@ -45,9 +45,11 @@
 #include "fvbaseprimaryvariables.hh"
 #include "fvbaseintensivequantities.hh"
 #include "fvbaseextensivequantities.hh"
+#include "fvbasetimestepcontroller.hh"
 
 #include <ewoms/parallel/gridcommhandles.hh>
 #include <ewoms/parallel/threadmanager.hh>
+#include <ewoms/parallel/threadedentityiterator.hh>
 #include <ewoms/linear/nullborderlistmanager.hh>
 #include <ewoms/common/simulator.hh>
 #include <ewoms/aux/baseauxiliarymodule.hh>
@@ -67,10 +69,13 @@
 #include <dune/fem/misc/capabilities.hh>
 #endif
 
+#include <algorithm>
 #include <limits>
 #include <list>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Ewoms {
@@ -123,6 +128,14 @@ public:
 //! Newton solver
 SET_INT_PROP(FvBaseDiscretization, MaxTimeStepDivisions, 10);
 
+//! Determine the size of the time steps using the number of Newton iterations by
+//! default
+SET_TYPE_PROP(FvBaseDiscretization, TimeStepController, Ewoms::FvBaseTimeStepController<TypeTag>);
+SET_STRING_PROP(FvBaseDiscretization, TimeStepControl, "IterationCount");
+SET_SCALAR_PROP(FvBaseDiscretization, TimeStepControlTolerance, 0.1);
+SET_SCALAR_PROP(FvBaseDiscretization, TimeStepControlMaxGrowthRate, 3.0);
+SET_BOOL_PROP(FvBaseDiscretization, TimeStepControlPredictNewtonFailure, false);
+
 /*!
  * \brief A vector of quanties, each for one equation.
  */
@@ -193,6 +206,26 @@ SET_TYPE_PROP(FvBaseDiscretization, ThreadManager, Ewoms::ThreadManager<TypeTag>
 SET_INT_PROP(FvBaseDiscretization, ThreadsPerProcess, 1);
 SET_BOOL_PROP(FvBaseDiscretization, UseLinearizationLock, true);
 
+//! do not color the elements of the grid for linearization by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableColoredLinearization, false);
+
+//! linearize all elements in each Newton iteration by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableIncrementalLinearization, false);
+
+//! the change of the primary variables of a degree of freedom, relative to the error of
+//! the Newton method, which causes its elements to be re-linearized if incremental
+//! linearization is enabled
+SET_SCALAR_PROP(FvBaseDiscretization, IncrementalLinearizationTolerance, 1e-3);
+
+//! do not check the incremental linearization against a full one by default
+SET_BOOL_PROP(FvBaseDiscretization, CheckIncrementalLinearization, false);
+
+//! compute the geometry of the stencils on the fly by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableStencilGeometryCache, false);
+
+//! linearize the system of equations element by element by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableFaceBasedLinearization, false);
+
 /*!
  * \brief Linearizer for the global system of equations.
  */
@@ -295,6 +328,8 @@ class FvBaseDiscretization
 
     typedef typename GridView::template Codim<0>::Entity Element;
     typedef typename GridView::template Codim<0>::Iterator ElementIterator;
+    typedef ThreadedEntityChunks<GridView, /*codim=*/0> ElementChunks;
+    typedef typename Stencil::GeometryCache StencilGeometryCache;
 
     typedef Opm::MathToolbox<Evaluation> Toolbox;
     typedef Dune::FieldVector<Evaluation, numEq> VectorBlock;
@@ -354,6 +389,7 @@ public:
         , space_( asImp_().numGridDof() )
 #endif
         , enableGridAdaptation_( EWOMS_GET_PARAM(TypeTag, bool, EnableGridAdaptation) )
+        , elementChunksSequenceNumber_(-1)
     {
 #if HAVE_DUNE_FEM
         if( enableGridAdaptation_ && ! Dune::Fem::Capabilities::isLocallyAdaptive< Grid >::v )
@@ -372,6 +408,7 @@ public:
                       "volume discretization (is: " << Dune::className<Discretization>() << ")");
 
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
+        initialSolutionLocation_ = InitialSolutionInCurrent;
 
         const unsigned nDofs = asImp_().numGridDof();
         for (int timeIdx = 0; timeIdx < historySize; ++timeIdx) {
@@ -398,6 +435,10 @@ public:
         for (; modIt != modEndIt; ++modIt)
             delete *modIt;
 
+        // delete the element contexts of the threads
+        for (size_t threadIdx = 0; threadIdx < elementContexts_.size(); ++threadIdx)
+            delete elementContexts_[threadIdx];
+
         delete linearizer_;
     }
 
@@ -422,6 +463,7 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStorageCache, "Store previous storage terms and avoid re-calculating them.");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStencilGeometryCache, "Precompute the geometry of the stencils of all elements instead of calculating it on the fly");
     }
 
     /*!
@@ -429,6 +471,19 @@ public:
      */
     void finishInit()
     {
+        // precompute the geometry of the stencils. since this method is also called if
+        // the grid has been changed, this keeps the cache consistent with the grid.
+        int gridSequenceNumber = simulator_.gridManager().gridSequenceNumber();
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableStencilGeometryCache)
+            && stencilGeometryCache_.sequenceNumber() != gridSequenceNumber)
+        {
+            stencilGeometryCache_.update(gridView_, asImp_().dofMapper(), gridSequenceNumber);
+            if (verbose_())
+                std::cout << "Geometry cache of the stencils occupies "
+                          << stencilGeometryCache_.memoryUsage()/(1024.0*1024.0)
+                          << " MiB on rank 0\n" << std::flush;
+        }
+
         // initialize the volume of the finite volumes to zero
         unsigned int nDofs = asImp_().numGridDof();
         dofTotalVolume_.resize(nDofs);
@@ -486,6 +541,8 @@ public:
         for (int threadId = 0; threadId < ThreadManager::maxThreads(); ++threadId)
             localLinearizer_[threadId].init(simulator_);
 
+        createElementContexts_();
+
         resizeAndResetIntensiveQuantitiesCache_();
         if (storeIntensiveQuantities()) {
             // invalidate all cached intensive quantities
@@ -497,6 +554,46 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns the element context which is reserved for the calling thread.
+     *
+     * There is one such context per thread and its storage is sized for the largest
+     * stencil of the grid, so using it does not cause any heap allocations. Since the
+     * object is shared, it must not be used by nested loops over the grid, i.e., code
+     * which loops over the elements using this context must not call any method which
+     * does the same.
+     */
+    ElementContext& threadElementContext() const
+    { return *elementContexts_[ThreadManager::threadId()]; }
+
+    /*!
+     * \brief Returns the precomputed geometric quantities of the stencils.
+     *
+     * The quantities are only computed if the EnableStencilGeometryCache parameter is
+     * set. A stencil only uses them if the cache is passed to its setGeometryCache()
+     * method.
+     */
+    const StencilGeometryCache *stencilGeometryCache() const
+    { return &stencilGeometryCache_; }
+
+    /*!
+     * \brief Returns the partition of the elements into the chunks which are handed to
+     *        the threads by ThreadedEntityIterator.
+     *
+     * The partition is only recomputed if the grid has changed. This method must be
+     * called in a sequential context.
+     */
+    std::shared_ptr<const ElementChunks> elementChunks() const
+    {
+        int curSequenceNumber = simulator_.gridManager().gridSequenceNumber();
+        if (!elementChunks_ || elementChunksSequenceNumber_ != curSequenceNumber) {
+            elementChunks_ = std::make_shared<ElementChunks>(gridView_, ThreadManager::maxThreads());
+            elementChunksSequenceNumber_ = curSequenceNumber;
+        }
+
+        return elementChunks_;
+    }
+
     /*!
      * \brief Returns whether the grid ought to be adapted to the solution during the simulation.
      */
@@ -783,7 +880,7 @@ public:
         dest = 0;
 
         OmpMutex mutex;
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_);
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(elementChunks());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -791,7 +888,7 @@ public:
             // Attention: the variables below are thread specific and thus cannot be
             // moved in front of the #pragma!
             int threadId = ThreadManager::threadId();
-            ElementContext elemCtx(simulator_);
+            ElementContext& elemCtx = threadElementContext();
             ElementIterator elemIt = threadedElemIt.beginParallel();
             LocalEvalBlockVector residual, storageTerm;
 
@@ -844,7 +941,7 @@ public:
         storage = 0;
 
         OmpMutex mutex;
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView());
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(elementChunks());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -1045,6 +1142,62 @@ public:
         return solution_[timeIdx]->blockVector();
     }
 
+    /*!
+     * \brief Returns a vector which exhibits the same layout as the current solution and
+     *        which can be used as scratch space by the non-linear solver.
+     *
+     * The contents of the buffer are unspecified before they have been written.
+     */
+    SolutionVector &solutionBuffer()
+    {
+        if (!solutionBuffer_)
+            solutionBuffer_.reset(new DiscreteFunction("solution buffer", space_));
+
+        // the size of the solution changes if auxiliary modules are added
+        SolutionVector &buffer = solutionBuffer_->blockVector();
+        if (buffer.size() != solution(/*timeIdx=*/0).size())
+            buffer.resize(solution(/*timeIdx=*/0).size());
+        return buffer;
+    }
+
+    /*!
+     * \brief Exchange the current solution with the contents of the solution buffer.
+     *
+     * Unless the grid is adapted using dune-fem, this does not copy any data. Note that
+     * this method does not invalidate the cached intensive quantities.
+     */
+    void swapSolutionBuffer()
+    {
+        solutionBuffer();
+        exchangeSolution_(solutionBuffer_);
+
+        // keep track of the location of the solution before the first Newton
+        // iteration
+        if (initialSolutionLocation_ == InitialSolutionInCurrent)
+            initialSolutionLocation_ = InitialSolutionInBuffer;
+        else if (initialSolutionLocation_ == InitialSolutionInBuffer)
+            initialSolutionLocation_ = InitialSolutionInCurrent;
+    }
+
+    /*!
+     * \brief Make sure that the solution before the first Newton iteration of the
+     *        current update is not lost if the solution buffer is overwritten.
+     *
+     * If the solution buffer contains this solution, it is exchanged with a separate
+     * vector, i.e., no data is copied. This vector is then used by updateFailed() to
+     * restore the solution.
+     */
+    void retainInitialSolution()
+    {
+        if (initialSolutionLocation_ != InitialSolutionInBuffer)
+            return;
+
+        if (!initialSolution_)
+            initialSolution_.reset(new DiscreteFunction("initial solution", space_));
+        std::swap(solutionBuffer_, initialSolution_);
+        initialSolutionLocation_ = InitialSolutionRetained;
+    }
+
   protected:
     /*!
      * \copydoc solution(int) const
@@ -1161,6 +1314,7 @@ public:
         prePostProcessTimer.stop();
         simulator_.addPrePostProcessTime(prePostProcessTimer.realTimeElapsed());
 
+        initialSolutionLocation_ = InitialSolutionInCurrent;
         bool converged = solver.apply();
 
         prePostProcessTimer.start();
@@ -1250,10 +1404,16 @@ public:
      */
     void updateFailed()
     {
-        // Reset the current solution to the one of the
-        // previous time step so that we can start the next
-        // update at a physically meaningful solution.
-        solution(/*timeIdx=*/0) = solution(/*timeIdx=*/1);
+        // Reset the current solution to the one before the first Newton iteration so
+        // that we can start the next update at a physically meaningful solution. This
+        // solution has been kept by the Newton method, so it only needs to be
+        // exchanged with the current one.
+        if (initialSolutionLocation_ == InitialSolutionInBuffer)
+            exchangeSolution_(solutionBuffer_);
+        else if (initialSolutionLocation_ == InitialSolutionRetained)
+            exchangeSolution_(initialSolution_);
+        initialSolutionLocation_ = InitialSolutionInCurrent;
+
         std::fill(intensiveQuantityCacheUpToDate_[0].begin(),
                   intensiveQuantityCacheUpToDate_[0].end(),
                   false);
@@ -1559,12 +1719,12 @@ public:
         }
 
         // iterate over grid
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView());
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(elementChunks());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
-            ElementContext elemCtx(simulator_);
+            ElementContext& elemCtx = threadElementContext();
             ElementIterator elemIt = threadedElemIt.beginParallel();
             for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
                 if (needFullContextUpdate)
@@ -1683,6 +1843,24 @@ public:
 #endif
 
 protected:
+    // exchange the current solution with a vector of the same layout. Unless the grid
+    // is adapted using dune-fem, this does not copy any data.
+    void exchangeSolution_(std::unique_ptr< DiscreteFunction >& other)
+    {
+#if HAVE_DUNE_FEM
+        if (restrictProlong_) {
+            // the grid adaptation operates on the discrete function of the current
+            // solution, so we must not exchange the discrete function objects here
+            SolutionVector tmp(solution(/*timeIdx=*/0));
+            solution(/*timeIdx=*/0) = other->blockVector();
+            other->blockVector() = tmp;
+            return;
+        }
+#endif
+
+        std::swap(solution_[/*timeIdx=*/0], other);
+    }
+
     void resizeAndResetIntensiveQuantitiesCache_()
     {
         // allocate the storage cache
@@ -1737,6 +1915,40 @@ protected:
     LocalResidual &localResidual_()
     { return localLinearizer_.localResidual(); }
 
+    /*!
+     * \brief Allocate one element context per thread which is able to hold the largest
+     *        stencil of the grid.
+     */
+    void createElementContexts_()
+    {
+        for (size_t threadIdx = 0; threadIdx < elementContexts_.size(); ++threadIdx)
+            delete elementContexts_[threadIdx];
+        elementContexts_.clear();
+
+        // determine the size of the largest stencil
+        unsigned maxDof = 0;
+        unsigned maxInteriorFaces = 0;
+        unsigned maxBoundaryFaces = 0;
+        Stencil stencil(gridView_, asImp_().dofMapper());
+        stencil.setGeometryCache(stencilGeometryCache());
+        ElementIterator elemIt = gridView_.template begin</*codim=*/0>();
+        const ElementIterator &elemEndIt = gridView_.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            stencil.update(*elemIt);
+            maxDof = std::max(maxDof, static_cast<unsigned>(stencil.numDof()));
+            maxInteriorFaces = std::max(maxInteriorFaces,
+                                        static_cast<unsigned>(stencil.numInteriorFaces()));
+            maxBoundaryFaces = std::max(maxBoundaryFaces,
+                                        static_cast<unsigned>(stencil.numBoundaryFaces()));
+        }
+
+        elementContexts_.resize(ThreadManager::maxThreads());
+        for (size_t threadIdx = 0; threadIdx < elementContexts_.size(); ++threadIdx) {
+            elementContexts_[threadIdx] = new ElementContext(simulator_);
+            elementContexts_[threadIdx]->reserve(maxDof, maxInteriorFaces, maxBoundaryFaces);
+        }
+    }
+
     /*!
      * \brief Returns whether messages should be printed
      */
@@ -1766,6 +1978,9 @@ protected:
     // local jacobian
     Linearizer *linearizer_;
 
+    // the element contexts which are reserved for the individual threads
+    std::vector<ElementContext*> elementContexts_;
+
     // cur is the current iterative solution, prev the converged
     // solution of the previous time step
     mutable IntensiveQuantitiesVector intensiveQuantityCache_[historySize];
@@ -1773,6 +1988,18 @@ protected:
 
     DiscreteFunctionSpace space_;
     mutable std::array< std::unique_ptr< DiscreteFunction >, historySize > solution_;
+    std::unique_ptr< DiscreteFunction > solutionBuffer_;
+
+    // the vector which holds the solution before the first Newton iteration of the
+    // current update once the solution buffer has been overwritten, and where this
+    // solution currently is
+    enum InitialSolutionLocation {
+        InitialSolutionInCurrent,
+        InitialSolutionInBuffer,
+        InitialSolutionRetained
+    };
+    std::unique_ptr< DiscreteFunction > initialSolution_;
+    InitialSolutionLocation initialSolutionLocation_;
 
 #if HAVE_DUNE_FEM
     std::unique_ptr< RestrictProlong  > restrictProlong_;
@@ -1787,6 +2014,14 @@ protected:
     std::vector<bool> isLocalDof_;
 
     bool enableGridAdaptation_;
+
+    // the partition of the elements which is used to iterate over them in parallel
+    mutable std::shared_ptr<const ElementChunks> elementChunks_;
+    mutable int elementChunksSequenceNumber_;
+
+    // the precomputed geometric quantities of the stencils of all elements
+    StencilGeometryCache stencilGeometryCache_;
+
     mutable GlobalEqVector storageCache_[historySize];
     bool enableStorageCache_;
 };
@@ -32,8 +32,12 @@
 
 #include <ewoms/common/alignedallocator.hh>
 
+#include <opm/material/common/MathToolbox.hpp>
+
 #include <dune/common/fvector.hh>
 
+#include <atomic>
+#include <type_traits>
 #include <vector>
 
 namespace Ewoms {
@@ -48,6 +52,7 @@ template<class TypeTag>
 class FvBaseElementContext
 {
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
     typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
     typedef typename GET_PROP_TYPE(TypeTag, IntensiveQuantities) IntensiveQuantities;
     typedef typename GET_PROP_TYPE(TypeTag, ExtensiveQuantities) ExtensiveQuantities;
@@ -77,6 +82,8 @@ class FvBaseElementContext
     static const int numEq = GET_PROP_VALUE(TypeTag, NumEq);
     static const int requireScvCenterGradients =
         GET_PROP_VALUE(TypeTag, RequireScvCenterGradients);
+    static const bool enableFaceBasedLinearization =
+        GET_PROP_VALUE(TypeTag, EnableFaceBasedLinearization);
 
     typedef typename GridView::ctype CoordScalar;
     typedef Dune::FieldVector<CoordScalar, dim> GlobalPosition;
@@ -86,6 +93,26 @@ class FvBaseElementContext
     {}
 
 public:
+    /*!
+     * \brief The type which is used for the quantities of the exterior degree of
+     *        freedom of a face by two-point flux approximations.
+     *
+     * With the element-wise linearization, the derivatives of these quantities are
+     * thrown away because the flux of a face is evaluated from both sides. If the
+     * face-based linearization is enabled, the derivatives with regard to the primary
+     * variables of the exterior degree of freedom are kept.
+     */
+    typedef typename std::conditional<enableFaceBasedLinearization,
+                                      Evaluation,
+                                      Scalar>::type ExteriorEvaluation;
+
+    /*!
+     * \brief Convert a quantity of the exterior degree of freedom of a face to the
+     *        type which is used by two-point flux approximations.
+     */
+    static ExteriorEvaluation exteriorValue(const Evaluation& value)
+    { return exteriorValue_(value, std::integral_constant<bool, enableFaceBasedLinearization>()); }
+
     /*!
      * \brief The constructor.
      */
@@ -93,10 +120,14 @@ public:
         : gridView_(simulator.gridView())
         , stencil_(gridView_, simulator.model().dofMapper() )
     {
+        stencil_.setGeometryCache(simulator.model().stencilGeometryCache());
+
         // remember the simulator object
         simulatorPtr_ = &simulator;
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
         stashedDofIdx_ = -1;
+
+        ++numAllocations_;
     }
 
     static void *operator new(size_t size) {
@@ -107,6 +138,44 @@ public:
         Ewoms::aligned_free(ptr);
     }
 
+    /*!
+     * \brief Allocate the storage for the quantities of stencils up to a given size.
+     *
+     * If this is called using the size of the largest stencil of the grid, updating the
+     * context does not require any heap allocations anymore.
+     *
+     * \param numDof The maximum number of degrees of freedom of a stencil
+     * \param numInteriorFaces The maximum number of interior faces of a stencil
+     * \param numBoundaryFaces The maximum number of boundary faces of a stencil
+     */
+    void reserve(unsigned numDof, unsigned numInteriorFaces, unsigned numBoundaryFaces)
+    {
+        size_t oldStencilCapacity = stencil_.capacity();
+        stencil_.reserve(numDof, numInteriorFaces, numBoundaryFaces);
+        countStencilAllocations_(oldStencilCapacity);
+
+        if (dofVars_.capacity() < numDof) {
+            ++numAllocations_;
+            dofVars_.reserve(numDof);
+        }
+
+        if (extensiveQuantities_.capacity() < numInteriorFaces) {
+            ++numAllocations_;
+            extensiveQuantities_.reserve(numInteriorFaces);
+        }
+    }
+
+    /*!
+     * \brief Returns the number of heap allocations which were caused by element contexts.
+     *
+     * This counts the number of contexts which have been created plus the number of
+     * times the storage of any context had to be enlarged. The counter is shared by all
+     * element contexts of a given type tag, i.e., it can be used to verify that no
+     * allocations are triggered between two points of a simulation run.
+     */
+    static unsigned long numAllocations()
+    { return numAllocations_; }
+
     /*!
      * \brief Construct all volume and extensive quantities of an element
      *        from scratch.
@@ -135,7 +204,9 @@ public:
         // update the stencil. the center gradients are quite expensive to calculate and
         // most models don't need them, so that we only do this if the model explicitly
         // enables them
+        size_t oldStencilCapacity = stencil_.capacity();
         stencil_.update(elem);
+        countStencilAllocations_(oldStencilCapacity);
 
         if (requireScvCenterGradients) {
 #if HAVE_DUNE_LOCALFUNCTIONS
@@ -147,8 +218,8 @@ public:
         }
 
         // resize the arrays containing the flux and the volume variables
-        dofVars_.resize(stencil_.numDof());
-        extensiveQuantities_.resize(stencil_.numInteriorFaces());
+        resizeDofVars_(stencil_.numDof());
+        resizeExtensiveQuantities_(stencil_.numInteriorFaces());
     }
 
     /*!
@@ -163,9 +234,11 @@ public:
         elemPtr_ = &elem;
 
         // update the finite element geometry
+        size_t oldStencilCapacity = stencil_.capacity();
         stencil_.updatePrimaryTopology(elem);
+        countStencilAllocations_(oldStencilCapacity);
 
-        dofVars_.resize(stencil_.numPrimaryDof());
+        resizeDofVars_(stencil_.numPrimaryDof());
     }
 
     /*!
@@ -180,7 +253,9 @@ public:
         elemPtr_ = &elem;
 
         // update the finite element geometry
+        size_t oldStencilCapacity = stencil_.capacity();
         stencil_.updateTopology(elem);
+        countStencilAllocations_(oldStencilCapacity);
     }
 
     /*!
@@ -245,6 +320,30 @@ public:
         }
     }
 
+    /*!
+     * \brief Compute the intensive quantities of a subset of the degrees of freedom of
+     *        the current element for a single time index.
+     *
+     * This is used if only some of the fluxes of the element are required, e.g., by
+     * the face-based linearization.
+     *
+     * \param dofIndices The local indices of the degrees of freedom which ought to be
+     *                   updated.
+     * \param timeIdx The index of the solution vector used by the time discretization.
+     */
+    void updateIntensiveQuantities(const std::vector<unsigned>& dofIndices, unsigned timeIdx)
+    {
+        for (unsigned i = 0; i < dofIndices.size(); ++i)
+            updateDofIntensiveQuantities_(dofIndices[i], timeIdx);
+
+        for (unsigned i = 0; i < dofIndices.size(); ++i) {
+            unsigned dofIdx = dofIndices[i];
+            dofVars_[dofIdx].intensiveQuantities[timeIdx].updateScvGradients(/*context=*/*this,
+                                                                             dofIdx,
+                                                                             timeIdx);
+        }
+    }
+
     /*!
      * \brief Compute the extensive quantities of all sub-control volume
      *        faces of the current element for all time indices.
@@ -272,6 +371,28 @@ public:
         }
     }
 
+    /*!
+     * \brief Compute the extensive quantities of a subset of the sub-control volume
+     *        faces of the current element for a single time index.
+     *
+     * The intensive quantities of the degrees of freedom adjacent to these faces must
+     * be up to date.
+     *
+     * \param faceIndices The local indices of the faces which ought to be updated.
+     * \param timeIdx The index of the solution vector used by the time discretization.
+     */
+    void updateExtensiveQuantities(const std::vector<unsigned>& faceIndices, unsigned timeIdx)
+    {
+        gradientCalculator_.prepare(/*context=*/*this, timeIdx);
+
+        for (unsigned i = 0; i < faceIndices.size(); ++i) {
+            unsigned fluxIdx = faceIndices[i];
+            extensiveQuantities_[fluxIdx].update(/*context=*/ *this,
+                                                 /*localIndex=*/fluxIdx,
+                                                 timeIdx);
+        }
+    }
+
     /*!
      * \brief Return a reference to the simulator.
      */
@@ -545,36 +666,88 @@ protected:
      */
     void updateIntensiveQuantities_(unsigned timeIdx, unsigned numDof)
     {
-        // update the intensive quantities for the whole history
-        const SolutionVector &globalSol = model().solution(timeIdx);
-
         // update the non-gradient quantities
+        for (unsigned dofIdx = 0; dofIdx < numDof; dofIdx++)
+            updateDofIntensiveQuantities_(dofIdx, timeIdx);
+
+        // update gradients
         for (unsigned dofIdx = 0; dofIdx < numDof; dofIdx++) {
-            unsigned globalIdx = globalSpaceIndex(dofIdx, timeIdx);
-            const PrimaryVariables& dofSol = globalSol[globalIdx];
-            dofVars_[dofIdx].priVars[timeIdx] = dofSol;
+            dofVars_[dofIdx].intensiveQuantities[timeIdx].updateScvGradients(/*context=*/*this,
+                                                                             dofIdx,
+                                                                             timeIdx);
+        }
+    }
+
+    /*!
+     * \brief Update the intensive quantities of a single degree of freedom from the
+     *        current solution.
+     *
+     * This method considers the intensive quantities cache.
+     */
+    void updateDofIntensiveQuantities_(unsigned dofIdx, unsigned timeIdx)
+    {
+        unsigned globalIdx = globalSpaceIndex(dofIdx, timeIdx);
+        const PrimaryVariables& dofSol = model().solution(timeIdx)[globalIdx];
+
+        dofVars_[dofIdx].thermodynamicHint[timeIdx] =
+            model().thermodynamicHint(globalIdx, timeIdx);
 
-            dofVars_[dofIdx].thermodynamicHint[timeIdx] =
-                model().thermodynamicHint(globalIdx, timeIdx);
+        // the cached intensive quantities use the derivatives of an interior degree of
+        // freedom, so they cannot be used for the neighbors if the face-based
+        // linearization is enabled
+        const IntensiveQuantities *cachedIntQuants = 0;
+        if (!hasExteriorDerivatives_(dofIdx, timeIdx))
+            cachedIntQuants = model().cachedIntensiveQuantities(globalIdx, timeIdx);
 
-            const auto *cachedIntQuants = model().cachedIntensiveQuantities(globalIdx, timeIdx);
-            if (cachedIntQuants) {
-                dofVars_[dofIdx].intensiveQuantities[timeIdx] = *cachedIntQuants;
-            }
-            else {
-                updateSingleIntQuants_(dofSol, dofIdx, timeIdx);
+        if (cachedIntQuants) {
+            dofVars_[dofIdx].priVars[timeIdx] = dofSol;
+            dofVars_[dofIdx].intensiveQuantities[timeIdx] = *cachedIntQuants;
+        }
+        else {
+            updateSingleIntQuants_(dofSol, dofIdx, timeIdx);
+            if (!hasExteriorDerivatives_(dofIdx, timeIdx))
                 model().updateCachedIntensiveQuantities(dofVars_[dofIdx].intensiveQuantities[timeIdx],
                                                         globalIdx,
                                                         timeIdx);
-            }
         }
+    }
 
-        // update gradients
-        for (unsigned dofIdx = 0; dofIdx < numDof; dofIdx++) {
-            dofVars_[dofIdx].intensiveQuantities[timeIdx].updateScvGradients(/*context=*/*this,
-                                                                             dofIdx,
-                                                                             timeIdx);
-        }
+    // returns true if the derivatives of the intensive quantities of a degree of
+    // freedom refer to the second half of the derivatives of the evaluations. This is
+    // the case for the neighbors of the element if the face-based linearization is
+    // enabled.
+    bool hasExteriorDerivatives_(unsigned dofIdx, unsigned timeIdx) const
+    {
+        return
+            enableFaceBasedLinearization
+            && timeIdx == 0
+            && dofIdx >= numPrimaryDof(timeIdx);
+    }
+
+    static ExteriorEvaluation exteriorValue_(const Evaluation& value, std::true_type)
+    { return value; }
+
+    static ExteriorEvaluation exteriorValue_(const Evaluation& value, std::false_type)
+    { return Opm::MathToolbox<Evaluation>::value(value); }
+
+    void countStencilAllocations_(size_t oldStencilCapacity)
+    {
+        if (stencil_.capacity() > oldStencilCapacity)
+            ++numAllocations_;
+    }
+
+    void resizeDofVars_(unsigned n)
+    {
+        if (dofVars_.capacity() < n)
+            ++numAllocations_;
+        dofVars_.resize(n);
+    }
+
+    void resizeExtensiveQuantities_(unsigned n)
+    {
+        if (extensiveQuantities_.capacity() < n)
+            ++numAllocations_;
+        extensiveQuantities_.resize(n);
     }
 
     void updateSingleIntQuants_(const PrimaryVariables &priVars, unsigned dofIdx, unsigned timeIdx)
@@ -587,6 +760,8 @@ protected:
 #endif
 
         dofVars_[dofIdx].priVars[timeIdx] = priVars;
+        if (enableFaceBasedLinearization)
+            dofVars_[dofIdx].priVars[timeIdx].setDerivativeOffset(hasExteriorDerivatives_(dofIdx, timeIdx) ? numEq : 0);
         dofVars_[dofIdx].intensiveQuantities[timeIdx].update(/*context=*/*this, dofIdx, timeIdx);
     }
 
@@ -605,8 +780,13 @@ protected:
     const Element *elemPtr_;
     const GridView gridView_;
     Stencil stencil_;
+
+    static std::atomic<unsigned long> numAllocations_;
 };
 
+template <class TypeTag>
+std::atomic<unsigned long> FvBaseElementContext<TypeTag>::numAllocations_(0);
+
 } // namespace Ewoms
 
 #endif
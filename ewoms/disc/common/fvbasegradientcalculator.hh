@@ -165,14 +165,14 @@ public:
         const auto& interiorPos = stencil.subControlVolume(face.interiorIndex()).center();
 
         // this is slightly hacky because the derivatives of the quantity for the
-        // exterior DOF are thrown away and this code thus assumes that the exterior DOF
-        // is not a primary degree of freedom. Basically this means that two-point flux
-        // approximation scheme is used. A way to fix this in a conceptionally elegant
-        // way would be to introduce the concept of extensive evaluations, but
-        // unfortunately this makes things quite a bit slower. (and also quite a bit
-        // harder to comprehend :/ )
+        // exterior DOF are thrown away (unless the face-based linearization is used)
+        // and this code thus assumes that the exterior DOF is not a primary degree of
+        // freedom. Basically this means that two-point flux approximation scheme is
+        // used. A way to fix this in a conceptionally elegant way would be to introduce
+        // the concept of extensive evaluations, but unfortunately this makes things
+        // quite a bit slower. (and also quite a bit harder to comprehend :/ )
         Evaluation deltay =
-            Toolbox::value(quantityCallback(face.exteriorIndex()))
+            ElementContext::exteriorValue(quantityCallback(face.exteriorIndex()))
             - quantityCallback(face.interiorIndex());
 
         Scalar distSquared = 0;
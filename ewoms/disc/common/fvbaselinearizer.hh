@@ -37,11 +37,16 @@
 
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
+#include <dune/common/version.hh>
 
 #include <type_traits>
+#include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <utility>
 #include <vector>
 #include <set>
+#include <stdexcept>
 
 namespace Ewoms {
 // forward declarations
@@ -65,12 +70,15 @@ class FvBaseLinearizer
     typedef typename GET_PROP_TYPE(TypeTag, Discretization) Discretization;
     typedef typename GET_PROP_TYPE(TypeTag, Problem) Problem;
     typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, Grid) Grid;
     typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
     typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
     typedef typename GET_PROP_TYPE(TypeTag, DofMapper) DofMapper;
     typedef typename GET_PROP_TYPE(TypeTag, ElementMapper) ElementMapper;
     typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef typename GET_PROP_TYPE(TypeTag, LocalResidual) LocalResidual;
+    typedef typename GET_PROP_TYPE(TypeTag, RateVector) RateVector;
 
     typedef typename GET_PROP_TYPE(TypeTag, SolutionVector) SolutionVector;
     typedef typename GET_PROP_TYPE(TypeTag, GlobalEqVector) GlobalEqVector;
@@ -86,9 +94,13 @@ class FvBaseLinearizer
 
     typedef typename GridView::template Codim<0>::Entity Element;
     typedef typename GridView::template Codim<0>::Iterator ElementIterator;
+    typedef typename Grid::template Codim<0>::EntitySeed ElementSeed;
+    typedef typename LocalResidual::LocalEvalBlockVector LocalEvalBlockVector;
 
     typedef GlobalEqVector Vector;
     typedef JacobianMatrix Matrix;
+    typedef std::pair<unsigned, Constraints> ConstraintsEntry;
+    typedef typename Matrix::block_type MatrixBlockType;
 
     enum { numEq = GET_PROP_VALUE(TypeTag, NumEq) };
     enum { historySize = GET_PROP_VALUE(TypeTag, TimeDiscHistorySize) };
@@ -97,6 +109,7 @@ class FvBaseLinearizer
     typedef Dune::FieldVector<Scalar, numEq> VectorBlock;
 
     static const bool linearizeNonLocalElements = GET_PROP_VALUE(TypeTag, LinearizeNonLocalElements);
+    static const bool enableFaceBasedLinearization = GET_PROP_VALUE(TypeTag, EnableFaceBasedLinearization);
 
     // copying the linearizer is not a good idea
     FvBaseLinearizer(const FvBaseLinearizer&);
@@ -108,22 +121,39 @@ public:
         simulatorPtr_ = 0;
 
         matrix_ = 0;
+
+        enableColoredLinearization_ = false;
+        coloringSequenceNumber_ = -1;
+
+        enableIncrementalLinearization_ = false;
+        incrementalTolerance_ = 0.0;
+        enableIncrementalLinearizationCheck_ = false;
     }
 
     ~FvBaseLinearizer()
     {
         delete matrix_;
-        auto it = elementCtx_.begin();
-        const auto &endIt = elementCtx_.end();
-        for (; it != endIt; ++it)
-            delete *it;
     }
 
     /*!
      * \brief Register all run-time parameters for the Jacobian linearizer.
      */
     static void registerParameters()
-    { }
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableColoredLinearization,
+                             "Linearize groups of elements which do not share any row of "
+                             "the Jacobian matrix in parallel without locking");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIncrementalLinearization,
+                             "Only re-linearize the elements affected by a change of the "
+                             "primary variables after the first Newton iteration");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, IncrementalLinearizationTolerance,
+                             "The minimum change of the primary variables of a degree of "
+                             "freedom, relative to the error of the Newton method, which "
+                             "causes the elements around it to be re-linearized");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, CheckIncrementalLinearization,
+                             "Compare each incremental linearization with a full one and "
+                             "abort if they deviate (slow, for debugging only)");
+    }
 
     /*!
      * \brief Initialize the linearizer.
@@ -139,6 +169,13 @@ public:
         simulatorPtr_ = &simulator;
         delete matrix_; // <- note that this even works for nullpointers!
         matrix_ = 0;
+
+        enableColoredLinearization_ = EWOMS_GET_PARAM(TypeTag, bool, EnableColoredLinearization);
+        coloringSequenceNumber_ = -1;
+
+        enableIncrementalLinearization_ = EWOMS_GET_PARAM(TypeTag, bool, EnableIncrementalLinearization);
+        incrementalTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, IncrementalLinearizationTolerance);
+        enableIncrementalLinearizationCheck_ = EWOMS_GET_PARAM(TypeTag, bool, CheckIncrementalLinearization);
     }
 
     /*!
@@ -152,6 +189,19 @@ public:
     {
         delete matrix_; // <- note that this even works for nullpointers!
         matrix_ = 0;
+
+        // the addresses of the matrix blocks are not valid anymore
+        elementBlockOffsets_.clear();
+        jacobianBlocks_.clear();
+        elementJacobians_.clear();
+        elementResiduals_.clear();
+        faceOffsets_.clear();
+        faceOwned_.clear();
+        faceBlocks_.clear();
+        foreignFaceOffsets_.clear();
+        foreignFaces_.clear();
+        faceResiduals_.clear();
+        faceJacobians_.clear();
     }
 
     /*!
@@ -192,6 +242,110 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns true if linearizeResidual() leaves the Jacobian matrix untouched.
+     *
+     * This is not the case if the matrix has not been created yet, e.g., before the
+     * first linearization or after the grid has changed. Also, the auxiliary modules can
+     * only be linearized as a whole, so if any are present, linearizeResidual() needs to
+     * linearize the full system.
+     */
+    bool canLinearizeResidualOnly() const
+    { return matrix_ && model_().numAuxiliaryModules() == 0; }
+
+    /*!
+     * \brief Evaluate the residual of the global non-linear system of equations, but do
+     *        not update the Jacobian matrix.
+     *
+     * The Jacobian matrix keeps the values of the last full linearization. If this is
+     * not possible (see canLinearizeResidualOnly()), this is equivalent to linearize().
+     */
+    void linearizeResidual()
+    {
+        if (!canLinearizeResidualOnly()) {
+            linearize();
+            return;
+        }
+
+        int succeeded;
+        try {
+            linearizeResidual_();
+            succeeded = 1;
+            succeeded = gridView_().comm().min(succeeded);
+        }
+        catch (Opm::NumericalProblem &e)
+        {
+            std::cout << "rank " << simulator_().gridView().comm().rank()
+                      << " caught an exception while evaluating the residual:" << e.what()
+                      << "\n"  << std::flush;
+            succeeded = 0;
+            succeeded = gridView_().comm().min(succeeded);
+        }
+
+        if (!succeeded) {
+            OPM_THROW(Opm::NumericalProblem,
+                       "A process did not succeed in evaluating the residual");
+        }
+    }
+
+    /*!
+     * \brief Multiply the Jacobian matrix of the elements of the local process with a
+     *        vector without assembling it.
+     *
+     * The derivatives of the residuals of an element's stencil with regard to the
+     * primary variables of the element are obtained from the local linearizer and are
+     * directly contracted with the vector, i.e., the result is the directional
+     * derivative of the residual. To avoid locking, the elements are processed color
+     * by color. The state of the linearizer is not modified and no communication takes
+     * place, so the entries of the result for the degrees of freedom on the process
+     * border only contain the local contributions.
+     *
+     * \param v The vector which ought to be multiplied with the Jacobian matrix
+     * \param dest The vector to which the product is written
+     */
+    void evalLocalJacobianProduct(const GlobalEqVector& v, GlobalEqVector &dest)
+    {
+        dest.resize(residual_.size());
+        dest = 0.0;
+
+        updateElementColoring_();
+
+        const Grid& grid = gridView_().grid();
+        unsigned numColors = elementColors_.size();
+        for (unsigned colorIdx = 0; colorIdx < numColors; ++colorIdx) {
+            const auto& colorSeeds = elementColors_[colorIdx];
+            int numColorElems = colorSeeds.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+            for (int i = 0; i < numColorElems; ++i) {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                const Element elem = grid.entity(colorSeeds[i]);
+#else
+                const auto elemPtr = grid.entityPointer(colorSeeds[i]);
+                const Element& elem = *elemPtr;
+#endif
+                int threadId = ThreadManager::threadId();
+                ElementContext& elemCtx = model_().threadElementContext();
+                auto& localLinearizer = model_().localLinearizer(threadId);
+
+                elemCtx.updateAll(elem);
+                localLinearizer.linearize(elemCtx);
+
+                unsigned numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+                unsigned numDof = elemCtx.numDof(/*timeIdx=*/0);
+                for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+                    const auto& vI = v[elemCtx.globalSpaceIndex(primaryDofIdx, /*timeIdx=*/0)];
+                    for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+                        int globJ = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                        localLinearizer.jacobian(dofIdx, primaryDofIdx).umv(vI, dest[globJ]);
+                    }
+                }
+            }
+        }
+    }
+
     /*!
      * \brief Return constant reference to global Jacobian matrix.
      */
@@ -211,12 +365,33 @@ public:
     { return residual_; }
 
     /*!
-     * \brief Returns the map of constraint degrees of freedom.
+     * \brief Returns the list of constraint degrees of freedom sorted by their index.
      *
      * (This object is only non-empty if the EnableConstraints property is true.)
      */
-    const std::map<int, Constraints>& constraintsMap() const
-    { return constraintsMap_; }
+    const std::vector<ConstraintsEntry>& constraintsList() const
+    { return constraintsList_; }
+
+    /*!
+     * \brief Returns true if a given degree of freedom is constraint.
+     */
+    bool isConstraintDof(unsigned dofIdx) const
+    {
+        return dofIdx < constraintsIndex_.size()
+            && constraintsIndex_[dofIdx] >= 0;
+    }
+
+    /*!
+     * \brief Returns the constraints of a given degree of freedom.
+     *
+     * This method may only be called for constraint degrees of freedom, i.e., if
+     * isConstraintDof() returns true.
+     */
+    const Constraints& constraints(unsigned dofIdx) const
+    {
+        assert(isConstraintDof(dofIdx));
+        return constraintsList_[constraintsIndex_[dofIdx]].second;
+    }
 
 private:
     Simulator &simulator_()
@@ -252,11 +427,6 @@ private:
         *matrix_ = 0;
         residual_.resize(model_().numTotalDof());
         residual_ = 0;
-
-        // create the per-thread context objects
-        elementCtx_.resize(ThreadManager::maxThreads());
-        for (int threadId = 0; threadId != ThreadManager::maxThreads(); ++ threadId)
-            elementCtx_[threadId] = new ElementContext(simulator_());
     }
 
     // Construct the BCRS matrix for the Jacobian of the residual function
@@ -267,50 +437,262 @@ private:
         // allocate raw matrix
         matrix_ = new Matrix(numAllDof, numAllDof, Matrix::random);
 
-        Stencil stencil(gridView_(), model_().dofMapper() );
-
         // for the main model, find out the global indices of the neighboring degrees of
-        // freedom of each primary degree of freedom
-        typedef std::set<int> NeighborSet;
-        std::vector<NeighborSet> neighbors(numAllDof);
-        ElementIterator elemIt = gridView_().template begin<0>();
-        const ElementIterator elemEndIt = gridView_().template end<0>();
-        for (; elemIt != elemEndIt; ++elemIt) {
-            const Element &elem = *elemIt;
-            stencil.update(elem);
+        // freedom of each primary degree of freedom. instead of maintaining a set of
+        // neighbors for each degree of freedom, each thread collects the (row, column)
+        // pairs of the elements it processes. these are sorted and made unique later.
+        typedef std::pair<unsigned, unsigned> Entry;
+        std::vector<std::vector<Entry> > threadEntries(ThreadManager::maxThreads());
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            auto& entries = threadEntries[ThreadManager::threadId()];
+            Stencil stencil(gridView_(), model_().dofMapper());
+            stencil.setGeometryCache(model_().stencilGeometryCache());
 
-            for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
-                unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element &elem = *elemIt;
+                stencil.updateTopology(elem);
+
+                unsigned numDof = stencil.numDof();
+                for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
+                    unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
 
-                for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx) {
-                    unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
-                    neighbors[myIdx].insert(neighborIdx);
+                    for (unsigned dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+                        unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
+                        entries.push_back(Entry(myIdx, neighborIdx));
+                    }
                 }
             }
         }
 
         // add the additional neighbors and degrees of freedom caused by the auxiliary
-        // equations
+        // equations. since their interface is specified in terms of neighbor sets, we
+        // let them fill an (initially empty) set for each degree of freedom and convert
+        // the result.
         const auto& model = model_();
         unsigned numAuxMod = model.numAuxiliaryModules();
-        for (unsigned auxModIdx = 0; auxModIdx < numAuxMod; ++auxModIdx)
-            model.auxiliaryModule(auxModIdx)->addNeighbors(neighbors);
+        if (numAuxMod > 0) {
+            typedef std::set<int> NeighborSet;
+            std::vector<NeighborSet> auxNeighbors(numAllDof);
+            for (unsigned auxModIdx = 0; auxModIdx < numAuxMod; ++auxModIdx)
+                model.auxiliaryModule(auxModIdx)->addNeighbors(auxNeighbors);
+
+            auto& entries = threadEntries[0];
+            for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx) {
+                typename NeighborSet::const_iterator nIt = auxNeighbors[dofIdx].begin();
+                typename NeighborSet::const_iterator nEndIt = auxNeighbors[dofIdx].end();
+                for (; nIt != nEndIt; ++nIt)
+                    entries.push_back(Entry(dofIdx, *nIt));
+            }
+        }
+
+        // bucket the column indices by row (CSR format). the rows may still contain
+        // duplicate column indices at this point.
+        std::vector<unsigned> rowOffsets(numAllDof + 1, 0);
+        for (unsigned threadId = 0; threadId < threadEntries.size(); ++threadId) {
+            const auto& entries = threadEntries[threadId];
+            for (unsigned i = 0; i < entries.size(); ++i)
+                ++rowOffsets[entries[i].first + 1];
+        }
+        for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx)
+            rowOffsets[dofIdx + 1] += rowOffsets[dofIdx];
+
+        std::vector<unsigned> columnIndices(rowOffsets[numAllDof]);
+        {
+            std::vector<unsigned> rowFill(rowOffsets.begin(), rowOffsets.end() - 1);
+            for (unsigned threadId = 0; threadId < threadEntries.size(); ++threadId) {
+                auto& entries = threadEntries[threadId];
+                for (unsigned i = 0; i < entries.size(); ++i)
+                    columnIndices[rowFill[entries[i].first]++] = entries[i].second;
+
+                // release the memory of the pairs as early as possible
+                std::vector<Entry>().swap(entries);
+            }
+        }
+
+        // sort the column indices of each row and get rid of the duplicates
+        std::vector<unsigned> rowSizes(numAllDof);
+        int numRows = numAllDof;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
+        for (int dofIdx = 0; dofIdx < numRows; ++ dofIdx) {
+            auto rowBegin = columnIndices.begin() + rowOffsets[dofIdx];
+            auto rowEnd = columnIndices.begin() + rowOffsets[dofIdx + 1];
+            std::sort(rowBegin, rowEnd);
+            rowSizes[dofIdx] = std::unique(rowBegin, rowEnd) - rowBegin;
+        }
 
         // allocate space for the rows of the matrix
         for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx)
-            matrix_->setrowsize(dofIdx, neighbors[dofIdx].size());
+            matrix_->setrowsize(dofIdx, rowSizes[dofIdx]);
         matrix_->endrowsizes();
 
         // fill the rows with indices. each degree of freedom talks to
         // all of its neighbors. (it also talks to itself since
         // degrees of freedom are sometimes quite egocentric.)
         for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx) {
-            typename NeighborSet::iterator nIt = neighbors[dofIdx].begin();
-            typename NeighborSet::iterator nEndIt = neighbors[dofIdx].end();
-            for (; nIt != nEndIt; ++nIt)
-                matrix_->addindex(dofIdx, *nIt);
+            const unsigned* colIdx = columnIndices.data() + rowOffsets[dofIdx];
+            for (unsigned i = 0; i < rowSizes[dofIdx]; ++i)
+                matrix_->addindex(dofIdx, colIdx[i]);
         }
         matrix_->endindices();
+
+        createJacobianBlockTable_();
+    }
+
+    // remember the addresses of the blocks of the Jacobian matrix which are touched by
+    // each element. this avoids having to search for the column index of each block
+    // whenever the local Jacobian of an element is added to the global matrix.
+    void createJacobianBlockTable_()
+    {
+        unsigned numElements = elementMapper_().size();
+        Stencil stencil(gridView_(), model_().dofMapper());
+        stencil.setGeometryCache(model_().stencilGeometryCache());
+
+        // count the number of blocks of each element. for a given element, the table
+        // stores the matrix block of the (primaryDofIdx, dofIdx) pair at the position
+        // primaryDofIdx*numDof + dofIdx relative to the element's offset.
+        elementBlockOffsets_.resize(numElements + 1);
+        elementBlockOffsets_[0] = 0;
+        ElementIterator elemIt = gridView_().template begin<0>();
+        const ElementIterator elemEndIt = gridView_().template end<0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+            stencil.updateTopology(elem);
+
+            unsigned elemIdx = elementIndex_(elem);
+            elementBlockOffsets_[elemIdx + 1] = stencil.numPrimaryDof()*stencil.numDof();
+        }
+
+        for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+            elementBlockOffsets_[elemIdx + 1] += elementBlockOffsets_[elemIdx];
+
+        // look up the addresses of the blocks
+        jacobianBlocks_.resize(elementBlockOffsets_[numElements]);
+        elemIt = gridView_().template begin<0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+            stencil.updateTopology(elem);
+
+            MatrixBlockType** elemBlocks = &jacobianBlocks_[elementBlockOffsets_[elementIndex_(elem)]];
+            unsigned numPrimaryDof = stencil.numPrimaryDof();
+            unsigned numDof = stencil.numDof();
+            for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++primaryDofIdx) {
+                unsigned globI = stencil.globalSpaceIndex(primaryDofIdx);
+                for (unsigned dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+                    unsigned globJ = stencil.globalSpaceIndex(dofIdx);
+                    elemBlocks[primaryDofIdx*numDof + dofIdx] = &(*matrix_)[globJ][globI];
+                }
+            }
+        }
+
+        if (useFaceBasedLinearization_())
+            createFaceTable_();
+    }
+
+    // determine the element which linearizes each face of the grid for the face-based
+    // linearization and the matrix blocks which are only touched by this face. A face
+    // belongs to the adjacent element with the lower index, unless the other element is
+    // not linearized at all. The contributions of a face to the row of the element
+    // which does not own it are stored separately and added by the owner of the row
+    // afterwards, so that no locking is required.
+    void createFaceTable_()
+    {
+        unsigned numElements = elementMapper_().size();
+        Stencil stencil(gridView_(), model_().dofMapper());
+        stencil.setGeometryCache(model_().stencilGeometryCache());
+
+        std::vector<char> elementLinearized(numElements, 0);
+        faceOffsets_.resize(numElements + 1);
+        faceOffsets_[0] = 0;
+        ElementIterator elemIt = gridView_().template begin<0>();
+        const ElementIterator elemEndIt = gridView_().template end<0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+            stencil.updateTopology(elem);
+
+            unsigned elemIdx = elementIndex_(elem);
+            if (stencil.numPrimaryDof() != 1 || stencil.globalSpaceIndex(0) != elemIdx)
+                OPM_THROW(std::logic_error,
+                          "The face-based linearization requires the element centered "
+                          "finite volume discretization");
+
+            elementLinearized[elemIdx] =
+                linearizeNonLocalElements || elem.partitionType() == Dune::InteriorEntity;
+            faceOffsets_[elemIdx + 1] = stencil.numInteriorFaces();
+        }
+
+        for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+            faceOffsets_[elemIdx + 1] += faceOffsets_[elemIdx];
+
+        unsigned numFaces = faceOffsets_[numElements];
+        faceOwned_.assign(numFaces, 0);
+        faceBlocks_.assign(numFaces, 0);
+        foreignFaceOffsets_.assign(numElements + 1, 0);
+        for (elemIt = gridView_().template begin<0>(); elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+            unsigned elemIdx = elementIndex_(elem);
+            if (!elementLinearized[elemIdx])
+                continue;
+
+            stencil.updateTopology(elem);
+            for (unsigned faceIdx = 0; faceIdx < stencil.numInteriorFaces(); ++faceIdx) {
+                unsigned neighborIdx =
+                    stencil.globalSpaceIndex(stencil.interiorFace(faceIdx).exteriorIndex());
+                if (elementLinearized[neighborIdx] && neighborIdx < elemIdx)
+                    continue;
+
+                // faces to neighbors which are not linearized only contribute to
+                // the row of the element
+                unsigned globalFaceIdx = faceOffsets_[elemIdx] + faceIdx;
+                faceOwned_[globalFaceIdx] = elementLinearized[neighborIdx] ? 2 : 1;
+                faceBlocks_[globalFaceIdx] = &(*matrix_)[elemIdx][neighborIdx];
+                if (elementLinearized[neighborIdx])
+                    ++ foreignFaceOffsets_[neighborIdx + 1];
+            }
+        }
+
+        for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+            foreignFaceOffsets_[elemIdx + 1] += foreignFaceOffsets_[elemIdx];
+
+        std::vector<unsigned> numForeignFaces(numElements, 0);
+        foreignFaces_.resize(foreignFaceOffsets_[numElements]);
+        for (elemIt = gridView_().template begin<0>(); elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+            unsigned elemIdx = elementIndex_(elem);
+            if (!elementLinearized[elemIdx])
+                continue;
+
+            stencil.updateTopology(elem);
+            for (unsigned faceIdx = 0; faceIdx < stencil.numInteriorFaces(); ++faceIdx) {
+                unsigned neighborIdx =
+                    stencil.globalSpaceIndex(stencil.interiorFace(faceIdx).exteriorIndex());
+                unsigned globalFaceIdx = faceOffsets_[elemIdx] + faceIdx;
+                if (faceOwned_[globalFaceIdx] != 2)
+                    continue;
+
+                unsigned pos = foreignFaceOffsets_[neighborIdx] + numForeignFaces[neighborIdx];
+                foreignFaces_[pos] = globalFaceIdx;
+                ++ numForeignFaces[neighborIdx];
+            }
+        }
+
+        faceResiduals_.resize(numFaces);
+        faceJacobians_.resize(numFaces);
+    }
+
+    unsigned elementIndex_(const Element& elem) const
+    {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        return elementMapper_().index(elem);
+#else
+        return elementMapper_().map(elem);
+#endif
     }
 
     // reset the global linear system of equations.
@@ -328,25 +710,30 @@ private:
             // constraints are not explictly enabled, so we don't need to consider them!
             return;
 
-        int threadId = ThreadManager::threadId();
-        constraintsMap_.clear();
+        // each thread collects the constraints of its elements in a separate buffer
+        std::vector<std::vector<ConstraintsEntry> > threadConstraints(ThreadManager::maxThreads());
 
         // loop over all elements...
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_());
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
+            // Attention: the variables below are thread specific and thus cannot be
+            // moved in front of the #pragma!
+            int threadId = ThreadManager::threadId();
+            ElementContext &elemCtx = model_().threadElementContext();
+            auto& threadBuffer = threadConstraints[threadId];
+
             ElementIterator elemIt = threadedElemIt.beginParallel();
             for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
                 // create an element context (the solution-based quantities are not
                 // available here!)
                 const Element &elem = *elemIt;
-                ElementContext &elemCtx = *elementCtx_[threadId];
                 elemCtx.updateStencil(elem);
 
                 // check if the problem wants to constrain any degree of the current
-                // element's freedom. if yes, add the constraint to the map.
+                // element's freedom. if yes, add the constraint to the buffer.
                 for (unsigned primaryDofIdx = 0;
                      primaryDofIdx < elemCtx.numPrimaryDof(/*timeIdx=*/0);
                      ++ primaryDofIdx)
@@ -358,18 +745,66 @@ private:
                                                   /*timeIdx=*/0);
                     if (constraints.isActive()) {
                         unsigned globI = elemCtx.globalSpaceIndex(primaryDofIdx, /*timeIdx=*/0);
-                        constraintsMap_[globI] = constraints;
-                        continue;
+                        threadBuffer.push_back(ConstraintsEntry(globI, constraints));
                     }
                 }
             }
         }
+
+        // merge the buffers of the threads into a single list which is sorted by the
+        // index of the degree of freedom. if the constraints of a degree of freedom have
+        // been specified by multiple elements, the one of the lowest numbered thread
+        // is used.
+        constraintsList_.clear();
+        for (unsigned threadId = 0; threadId < threadConstraints.size(); ++threadId)
+            constraintsList_.insert(constraintsList_.end(),
+                                    threadConstraints[threadId].begin(),
+                                    threadConstraints[threadId].end());
+
+        std::stable_sort(constraintsList_.begin(), constraintsList_.end(), ConstraintsDofLess_());
+        constraintsList_.erase(std::unique(constraintsList_.begin(),
+                                           constraintsList_.end(),
+                                           ConstraintsDofEqual_()),
+                               constraintsList_.end());
+
+        // create the index which maps a degree of freedom to its entry in the list
+        constraintsIndex_.assign(model_().numTotalDof(), -1);
+        for (unsigned i = 0; i < constraintsList_.size(); ++i)
+            constraintsIndex_[constraintsList_[i].first] = i;
     }
 
+    struct ConstraintsDofLess_
+    {
+        bool operator()(const ConstraintsEntry& a, const ConstraintsEntry& b) const
+        { return a.first < b.first; }
+    };
+
+    struct ConstraintsDofEqual_
+    {
+        bool operator()(const ConstraintsEntry& a, const ConstraintsEntry& b) const
+        { return a.first == b.first; }
+    };
+
     // linearize the whole system
     void linearize_()
     {
+        // after the first iteration of a time step, we only need to update the
+        // contributions of the elements for which the primary variables have changed
+        // (if this was requested)
+        if (canLinearizeIncrementally_()) {
+            linearizeIncrementally_();
+            return;
+        }
+
         resetSystem_();
+        if (enableIncrementalLinearization_) {
+            // all contributions of the elements will be recomputed
+            elementJacobians_.resize(jacobianBlocks_.size());
+            elementResiduals_.resize(jacobianBlocks_.size());
+            std::fill(elementJacobians_.begin(), elementJacobians_.end(), MatrixBlock(0.0));
+            std::fill(elementResiduals_.begin(), elementResiduals_.end(), VectorBlock(0.0));
+            linearizationSolution_ = model_().solution(/*timeIdx=*/0);
+        }
 
         // before the first iteration of each time step, we need to update the
         // constraints. (i.e., we assume that constraints can be time dependent, but they
@@ -380,7 +815,177 @@ private:
         applyConstraintsToSolution_();
 
         // relinearize the elements...
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_());
+        if (useFaceBasedLinearization_())
+            linearizeFaces_(std::integral_constant<bool, enableFaceBasedLinearization>());
+        else if (enableColoredLinearization_)
+            linearizeColoredElements_();
+        else
+            linearizeElements_();
+
+        applyConstraintsToLinearization_();
+
+        linearizeAuxiliaryEquations_();
+    }
+
+    // returns true if the system is linearized face by face. the incremental
+    // linearization needs the contributions of the individual elements, so it always
+    // linearizes element-wise. (this is still correct if the face-based linearization
+    // is enabled because the derivatives w.r.t. the neighbors are simply ignored.)
+    bool useFaceBasedLinearization_() const
+    { return enableFaceBasedLinearization && !enableIncrementalLinearization_; }
+
+    // returns true if the linearization of the previous Newton iteration can be
+    // patched instead of being recomputed from scratch
+    bool canLinearizeIncrementally_() const
+    {
+        // the storage terms and the time step size are only guaranteed to be constant
+        // within a time step, the constraints and the auxiliary modules overwrite or add
+        // to the linearization unconditionally. also, the problem may have changed in a
+        // way which is not reflected by the primary variables.
+        return enableIncrementalLinearization_
+            && model_().newtonMethod().numIterations() > 0
+            && !problem_().requiresFullLinearization()
+            && !enableConstraints_()
+            && model_().numAuxiliaryModules() == 0
+            && elementJacobians_.size() == jacobianBlocks_.size();
+    }
+
+    // re-linearize the elements for which the primary variables of at least one degree
+    // of freedom in their stencil have changed by more than the tolerance since they
+    // have been linearized. The contributions of these elements are then replaced in
+    // the global linear system.
+    void linearizeIncrementally_()
+    {
+        const auto& model = model_();
+        const SolutionVector& sol = model.solution(/*timeIdx=*/0);
+        int numDof = sol.size();
+
+        // the tolerance is relative to the error of the Newton method, so that the
+        // linearization gets more accurate as the Newton method converges
+        Scalar tolerance = incrementalTolerance_*model.newtonMethod().error();
+
+        // determine the degrees of freedom which have changed. if a degree of freedom
+        // is marked as changed, all elements around it get updated, so the reference
+        // values of its primary variables are updated as well.
+        dofChanged_.resize(numDof);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
+        for (int dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+            Scalar err = model.relativeDofError(dofIdx, linearizationSolution_[dofIdx], sol[dofIdx]);
+            dofChanged_[dofIdx] = (err > tolerance)?1:0;
+            if (dofChanged_[dofIdx])
+                linearizationSolution_[dofIdx] = sol[dofIdx];
+        }
+
+        // if the elements are colored, the elements of a color can be patched
+        // without locking, else we have to go through the elements as they come.
+        if (enableColoredLinearization_)
+            linearizeColoredElements_(/*onlyChangedElements=*/true);
+        else
+            linearizeChangedElements_();
+
+        if (enableIncrementalLinearizationCheck_)
+            checkIncrementalLinearization_();
+    }
+
+    // make sure that the patched linear system is equivalent to the one which results
+    // from linearizing all elements. the full linear system is assembled into separate
+    // objects, i.e., the state of the linearizer is not modified. since this is slow,
+    // it must be explicitly enabled using the CheckIncrementalLinearization parameter.
+    void checkIncrementalLinearization_()
+    {
+        Matrix fullMatrix(*matrix_);
+        GlobalEqVector fullResidual(residual_);
+        fullMatrix = 0.0;
+        fullResidual = 0.0;
+
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            int threadId = ThreadManager::threadId();
+            ElementContext &elemCtx = model_().threadElementContext();
+            auto &localLinearizer = model_().localLinearizer(threadId);
+
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element &elem = *elemIt;
+                if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
+                elemCtx.updateAll(elem);
+                localLinearizer.linearize(elemCtx);
+
+                globalMatrixMutex_.lock();
+                unsigned numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+                unsigned numDof = elemCtx.numDof(/*timeIdx=*/0);
+                for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+                    unsigned globI = elemCtx.globalSpaceIndex(primaryDofIdx, /*timeIdx=*/0);
+                    fullResidual[globI] += localLinearizer.residual(primaryDofIdx);
+                    for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+                        unsigned globJ = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                        fullMatrix[globJ][globI] += localLinearizer.jacobian(dofIdx, primaryDofIdx);
+                    }
+                }
+                globalMatrixMutex_.unlock();
+            }
+        }
+
+        Scalar matrixNorm = fullMatrix.infinity_norm();
+        Scalar residualNorm = fullResidual.infinity_norm();
+        fullMatrix -= *matrix_;
+        fullResidual -= residual_;
+        Scalar matrixDeviation = fullMatrix.infinity_norm()/std::max<Scalar>(1e-30, matrixNorm);
+        Scalar residualDeviation = fullResidual.infinity_norm()/std::max<Scalar>(1e-30, residualNorm);
+        if (std::max(matrixDeviation, residualDeviation) > std::max<Scalar>(incrementalTolerance_, 1e-8))
+            OPM_THROW(std::logic_error,
+                      "The incremental linearization deviates from the full one on rank "
+                      << gridView_().comm().rank() << " (relative deviations: matrix "
+                      << matrixDeviation << ", residual " << residualDeviation << ")");
+    }
+
+    // re-linearize the elements affected by a changed degree of freedom by handing
+    // them to the threads as they come
+    void linearizeChangedElements_()
+    {
+        bool useLock = GET_PROP_VALUE(TypeTag, UseLinearizationLock);
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Stencil stencil(gridView_(), model_().dofMapper());
+            stencil.setGeometryCache(model_().stencilGeometryCache());
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element &elem = *elemIt;
+                if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
+                if (elementChanged_(stencil, elem))
+                    linearizeElement_(elem, useLock);
+            }
+        }
+    }
+
+    // returns true if the primary variables of at least one degree of freedom in the
+    // stencil of an element have been marked as changed
+    bool elementChanged_(Stencil& stencil, const Element& elem) const
+    {
+        stencil.updateTopology(elem);
+        for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx)
+            if (dofChanged_[stencil.globalSpaceIndex(dofIdx)])
+                return true;
+        return false;
+    }
+
+    // linearize all elements by handing them to the threads as they come
+    void linearizeElements_()
+    {
+        bool useLock = GET_PROP_VALUE(TypeTag, UseLinearizationLock);
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -405,21 +1010,112 @@ private:
                 if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
                     continue;
 
-                linearizeElement_(elem);
+                linearizeElement_(elem, useLock);
             }
         }
+    }
 
-        applyConstraintsToLinearization_();
+    // linearize the elements color by color. Since no two elements of the same color
+    // contribute to the same row of the global linear system, the elements of a color
+    // can be linearized concurrently without any locking. If onlyChangedElements is
+    // true, the elements for which no degree of freedom has changed are skipped.
+    void linearizeColoredElements_(bool onlyChangedElements = false)
+    {
+        updateElementColoring_();
 
-        linearizeAuxiliaryEquations_();
+        const Grid& grid = gridView_().grid();
+        unsigned numColors = elementColors_.size();
+        for (unsigned colorIdx = 0; colorIdx < numColors; ++colorIdx) {
+            const auto& colorSeeds = elementColors_[colorIdx];
+            int numColorElems = colorSeeds.size();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            {
+                Stencil stencil(gridView_(), model_().dofMapper());
+                stencil.setGeometryCache(model_().stencilGeometryCache());
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+                for (int i = 0; i < numColorElems; ++i) {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                    const Element elem = grid.entity(colorSeeds[i]);
+#else
+                    const auto elemPtr = grid.entityPointer(colorSeeds[i]);
+                    const Element& elem = *elemPtr;
+#endif
+                    if (onlyChangedElements && !elementChanged_(stencil, elem))
+                        continue;
+
+                    linearizeElement_(elem, /*useLock=*/false);
+                }
+            }
+        }
     }
 
-    // linearize an element in the interior of the process' grid partition
-    void linearizeElement_(const Element &elem)
+    // partition the elements which need to be linearized into groups ("colors") such
+    // that no two elements of a group touch the same row of the Jacobian matrix. Since
+    // this only depends on the grid, this is done only once per grid sequence number.
+    void updateElementColoring_()
+    {
+        int curSequenceNumber = simulator_().gridManager().gridSequenceNumber();
+        if (coloringSequenceNumber_ == curSequenceNumber)
+            return;
+
+        coloringSequenceNumber_ = curSequenceNumber;
+        elementColors_.clear();
+
+        // greedy coloring: each element gets the lowest color which is not yet used by
+        // any of the elements which touch one of its rows. For this, we remember the
+        // colors of the elements which touch a given row and the index of the last
+        // element which was not allowed to use a given color.
+        Stencil stencil(gridView_(), model_().dofMapper());
+        stencil.setGeometryCache(model_().stencilGeometryCache());
+        std::vector<std::vector<unsigned> > rowColors(model_().numGridDof());
+        std::vector<int> colorBlockedBy;
+        int elemIdx = 0;
+
+        ElementIterator elemIt = gridView_().template begin<0>();
+        const ElementIterator elemEndIt = gridView_().template end<0>();
+        for (; elemIt != elemEndIt; ++elemIt, ++elemIdx) {
+            const Element& elem = *elemIt;
+            if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
+                continue;
+
+            stencil.updateTopology(elem);
+
+            unsigned numDof = stencil.numDof();
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+                const auto& usedColors = rowColors[stencil.globalSpaceIndex(dofIdx)];
+                for (unsigned i = 0; i < usedColors.size(); ++i)
+                    colorBlockedBy[usedColors[i]] = elemIdx;
+            }
+
+            unsigned color = 0;
+            while (color < colorBlockedBy.size() && colorBlockedBy[color] == elemIdx)
+                ++color;
+
+            if (color == elementColors_.size()) {
+                elementColors_.resize(color + 1);
+                colorBlockedBy.push_back(-1);
+            }
+
+            elementColors_[color].push_back(elem.seed());
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++dofIdx)
+                rowColors[stencil.globalSpaceIndex(dofIdx)].push_back(color);
+        }
+    }
+
+    // linearize an element in the interior of the process' grid partition. the lock
+    // may only be omitted if no other thread can touch the rows of the element at the
+    // same time, i.e., if the elements are processed color by color.
+    void linearizeElement_(const Element &elem, bool useLock)
     {
         int threadId = ThreadManager::threadId();
 
-        ElementContext *elementCtx = elementCtx_[threadId];
+        ElementContext *elementCtx = &model_().threadElementContext();
         auto &localLinearizer = model_().localLinearizer(threadId);
 
         // the actual work of linearization is done by the local linearizer class
@@ -427,28 +1123,257 @@ private:
         localLinearizer.linearize(*elementCtx);
 
         // update the right hand side and the Jacobian matrix
-        if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
+        if (useLock)
             globalMatrixMutex_.lock();
 
         unsigned numPrimaryDof = elementCtx->numPrimaryDof(/*timeIdx=*/0);
+        unsigned numDof = elementCtx->numDof(/*timeIdx=*/0);
+        unsigned elemIdx = elementIndex_(elem);
+        MatrixBlockType* const* elemBlocks = &jacobianBlocks_[elementBlockOffsets_[elemIdx]];
+        assert(elementBlockOffsets_[elemIdx + 1] - elementBlockOffsets_[elemIdx] == numPrimaryDof*numDof);
         for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
             int globI = elementCtx->globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
 
             // update the right hand side
             residual_[globI] += localLinearizer.residual(primaryDofIdx);
 
-            // update the global Jacobian matrix
-            for (unsigned dofIdx = 0; dofIdx < elementCtx->numDof(/*timeIdx=*/0); ++ dofIdx) {
-                int globJ = elementCtx->globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+            // update the global Jacobian matrix. the addresses of the matrix blocks
+            // have been determined when the matrix was created.
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+                *elemBlocks[primaryDofIdx*numDof + dofIdx] += localLinearizer.jacobian(dofIdx, primaryDofIdx);
+        }
 
-                (*matrix_)[globJ][globI] += localLinearizer.jacobian(dofIdx, primaryDofIdx);
+        if (enableIncrementalLinearization_) {
+            // remove the element's previous contribution from the linear system and
+            // remember the current one
+            unsigned offset = elementBlockOffsets_[elemIdx];
+            for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+                int globI = elementCtx->globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
+                residual_[globI] -= elementResiduals_[offset + primaryDofIdx];
+                elementResiduals_[offset + primaryDofIdx] = localLinearizer.residual(primaryDofIdx);
+
+                for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+                    unsigned blockIdx = offset + primaryDofIdx*numDof + dofIdx;
+                    *jacobianBlocks_[blockIdx] -= elementJacobians_[blockIdx];
+                    elementJacobians_[blockIdx] = localLinearizer.jacobian(dofIdx, primaryDofIdx);
+                }
             }
         }
 
-        if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
+        if (useLock)
             globalMatrixMutex_.unlock();
     }
 
+    // linearize the system by evaluating the flux over each face of the grid only once.
+    // this is only possible if the evaluations distinguish the derivatives of the
+    // element and of its neighbor.
+    void linearizeFaces_(std::false_type)
+    { OPM_THROW(std::logic_error, "The face-based linearization is not enabled"); }
+
+    void linearizeFaces_(std::true_type)
+    {
+        static_assert(!std::is_same<Evaluation, Scalar>::value,
+                      "The face-based linearization requires automatic differentiation");
+
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            // Attention: the variables below are thread specific and thus cannot be
+            // moved in front of the #pragma!
+            int threadId = ThreadManager::threadId();
+            ElementContext &elemCtx = model_().threadElementContext();
+            const LocalResidual &localResidual = model_().localResidual(threadId);
+            LocalEvalBlockVector volumeResidual;
+            std::vector<unsigned> ownedFaces;
+            std::vector<unsigned> neighborDofs;
+
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element &elem = *elemIt;
+                if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
+                linearizeElementFaces_(elemCtx, localResidual, elem,
+                                       volumeResidual, ownedFaces, neighborDofs);
+            }
+        }
+
+        // add the contributions of the faces to the rows of the elements which do not
+        // own them
+        int numElements = elementMapper_().size();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+            MatrixBlockType& diagBlock = *jacobianBlocks_[elementBlockOffsets_[elemIdx]];
+            for (unsigned i = foreignFaceOffsets_[elemIdx]; i < foreignFaceOffsets_[elemIdx + 1]; ++i) {
+                unsigned globalFaceIdx = foreignFaces_[i];
+                residual_[elemIdx] += faceResiduals_[globalFaceIdx];
+                diagBlock += faceJacobians_[globalFaceIdx];
+            }
+        }
+    }
+
+    // linearize the storage, source and boundary terms of an element and the fluxes of
+    // the faces which are owned by it.
+    void linearizeElementFaces_(ElementContext& elemCtx,
+                                const LocalResidual& localResidual,
+                                const Element& elem,
+                                LocalEvalBlockVector& volumeResidual,
+                                std::vector<unsigned>& ownedFaces,
+                                std::vector<unsigned>& neighborDofs)
+    {
+        unsigned elemIdx = elementIndex_(elem);
+
+        elemCtx.updateStencil(elem);
+        const auto& stencil = elemCtx.stencil(/*timeIdx=*/0);
+
+        ownedFaces.clear();
+        neighborDofs.clear();
+        unsigned faceOffset = faceOffsets_[elemIdx];
+        for (unsigned faceIdx = 0; faceIdx < stencil.numInteriorFaces(); ++faceIdx) {
+            if (faceOwned_[faceOffset + faceIdx]) {
+                ownedFaces.push_back(faceIdx);
+                neighborDofs.push_back(stencil.interiorFace(faceIdx).exteriorIndex());
+            }
+        }
+
+        // the element's own intensive quantities are needed for the storage term, those
+        // of the neighbors only for the fluxes over the owned faces
+        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+        if (!elemCtx.enableStorageCache())
+            for (unsigned timeIdx = 1; timeIdx < historySize; ++timeIdx)
+                elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
+        elemCtx.updateIntensiveQuantities(neighborDofs, /*timeIdx=*/0);
+        elemCtx.updateExtensiveQuantities(ownedFaces, /*timeIdx=*/0);
+
+        model_().updatePVWeights(elemCtx);
+
+        // storage, source and boundary terms. the derivatives of these only refer to
+        // the element itself.
+        volumeResidual.resize(elemCtx.numDof(/*timeIdx=*/0));
+        localResidual.evalVolumeAndBoundaryTerms(volumeResidual, elemCtx);
+
+        unsigned globI = elemIdx;
+        Scalar volI = elemCtx.dofTotalVolume(/*dofIdx=*/0, /*timeIdx=*/0);
+        MatrixBlockType* const* elemBlocks = &jacobianBlocks_[elementBlockOffsets_[elemIdx]];
+        MatrixBlockType& diagBlock = *elemBlocks[0];
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            const Evaluation& r = volumeResidual[0][eqIdx];
+            residual_[globI][eqIdx] += Toolbox::value(r)/volI;
+            for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                diagBlock[eqIdx][pvIdx] += r.derivative(pvIdx)/volI;
+        }
+
+        // fluxes over the owned faces. the first half of the derivatives refers to the
+        // primary variables of the element, the second one to the ones of the neighbor.
+        RateVector flux;
+        for (unsigned i = 0; i < ownedFaces.size(); ++i) {
+            unsigned faceIdx = ownedFaces[i];
+            unsigned dofJ = neighborDofs[i];
+            const auto& face = stencil.interiorFace(faceIdx);
+
+            localResidual.computeFlux(flux, elemCtx, faceIdx, /*timeIdx=*/0);
+
+            Scalar alpha =
+                elemCtx.extensiveQuantities(faceIdx, /*timeIdx=*/0).extrusionFactor()
+                * face.area();
+            Scalar volJ = elemCtx.dofTotalVolume(dofJ, /*timeIdx=*/0);
+
+            // the flux goes out of the element and into the neighbor. the blocks of
+            // the element's row for the neighbor and of the neighbor's row for the
+            // element are only touched by this face. the remaining contributions to
+            // the neighbor's row are added once all elements have been processed.
+            unsigned globalFaceIdx = faceOffset + faceIdx;
+            MatrixBlockType& blockIJ = *faceBlocks_[globalFaceIdx];
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                const Evaluation& f = flux[eqIdx];
+                residual_[globI][eqIdx] += alpha*Toolbox::value(f)/volI;
+                for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                    diagBlock[eqIdx][pvIdx] += alpha*f.derivative(pvIdx)/volI;
+                    blockIJ[eqIdx][pvIdx] += alpha*f.derivative(numEq + pvIdx)/volI;
+                }
+            }
+
+            if (faceOwned_[globalFaceIdx] != 2)
+                continue;
+
+            MatrixBlockType& blockJI = *elemBlocks[dofJ];
+            VectorBlock& residualJ = faceResiduals_[globalFaceIdx];
+            MatrixBlock& blockJJ = faceJacobians_[globalFaceIdx];
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                const Evaluation& f = flux[eqIdx];
+                residualJ[eqIdx] = - alpha*Toolbox::value(f)/volJ;
+                for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                    blockJI[eqIdx][pvIdx] -= alpha*f.derivative(pvIdx)/volJ;
+                    blockJJ[eqIdx][pvIdx] = - alpha*f.derivative(numEq + pvIdx)/volJ;
+                }
+            }
+        }
+    }
+
+    // evaluate the residual of all elements without touching the Jacobian matrix
+    void linearizeResidual_()
+    {
+        // the element contributions stored by the incremental linearization do not
+        // match the residual anymore, so the next linearization must be a full one
+        elementJacobians_.clear();
+        elementResiduals_.clear();
+
+        evalResidual_(residual_);
+    }
+
+    // add up the residuals of all elements of the local process
+    void evalResidual_(GlobalEqVector &dest)
+    {
+        dest = 0.0;
+
+        bool useLock = GET_PROP_VALUE(TypeTag, UseLinearizationLock);
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model_().elementChunks());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            // Attention: the variables below are thread specific and thus cannot be
+            // moved in front of the #pragma!
+            int threadId = ThreadManager::threadId();
+            ElementContext &elemCtx = model_().threadElementContext();
+            auto &localResidual = model_().localLinearizer(threadId).localResidual();
+
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element &elem = *elemIt;
+                if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
+                elemCtx.updateAll(elem);
+                localResidual.eval(elemCtx);
+                const auto &elemResidual = localResidual.residual();
+
+                if (useLock)
+                    globalMatrixMutex_.lock();
+
+                unsigned numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+                for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+                    int globI = elemCtx.globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
+                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                        dest[globI][eqIdx] += Toolbox::value(elemResidual[primaryDofIdx][eqIdx]);
+                }
+
+                if (useLock)
+                    globalMatrixMutex_.unlock();
+            }
+        }
+
+        // the equations of constraint degrees of freedom are already satisfied
+        auto it = constraintsList_.begin();
+        const auto& endIt = constraintsList_.end();
+        for (; it != endIt; ++it)
+            dest[it->first] = 0.0;
+    }
+
     void linearizeAuxiliaryEquations_()
     {
         auto& model = model_();
@@ -467,8 +1392,8 @@ private:
         auto& sol = model_().solution(/*timeIdx=*/0);
         auto& oldSol = model_().solution(/*timeIdx=*/1);
 
-        auto it = constraintsMap_.begin();
-        const auto& endIt = constraintsMap_.end();
+        auto it = constraintsList_.begin();
+        const auto& endIt = constraintsList_.end();
         for (; it != endIt; ++it) {
             sol[it->first] = it->second;
             oldSol[it->first] = it->second;
@@ -486,8 +1411,8 @@ private:
         for (int i = 0; i < numEq; ++i)
             idBlock[i][i] = 1.0;
 
-        auto it = constraintsMap_.begin();
-        const auto& endIt = constraintsMap_.end();
+        auto it = constraintsList_.begin();
+        const auto& endIt = constraintsList_.end();
         for (; it != endIt; ++it) {
             int constraintDofIdx = it->first;
 
@@ -509,11 +1434,12 @@ private:
     { return GET_PROP_VALUE(TypeTag, EnableConstraints); }
 
     Simulator *simulatorPtr_;
-    std::vector<ElementContext*> elementCtx_;
 
-    // The constraint equations (only non-empty if the
+    // The constraint equations sorted by degree of freedom and the position of each
+    // degree of freedom in this list (-1 if unconstrained). (only non-empty if the
     // EnableConstraints property is true)
-    std::map<int, Constraints> constraintsMap_;
+    std::vector<ConstraintsEntry> constraintsList_;
+    std::vector<int> constraintsIndex_;
 
     // the jacobian matrix
     Matrix *matrix_;
@@ -522,6 +1448,39 @@ private:
 
 
     OmpMutex globalMatrixMutex_;
+
+    // the addresses of the Jacobian matrix blocks touched by each element
+    std::vector<unsigned> elementBlockOffsets_;
+    std::vector<MatrixBlockType*> jacobianBlocks_;
+
+    // the contributions of each element to the linear system and the degrees of freedom
+    // which have changed since their last linearization (only used for incremental
+    // linearization)
+    bool enableIncrementalLinearization_;
+    Scalar incrementalTolerance_;
+    bool enableIncrementalLinearizationCheck_;
+    std::vector<MatrixBlock> elementJacobians_;
+    std::vector<VectorBlock> elementResiduals_;
+    SolutionVector linearizationSolution_;
+    std::vector<char> dofChanged_;
+
+    // the faces of each element, the faces which are owned by it (1: only the element's
+    // row is linearized, 2: the neighbor's row as well), the matrix block of the
+    // element's row for the neighbor of each owned face, the faces which contribute
+    // to each element without being owned by it and the contributions of each face to
+    // the row of the neighbor (only used for face-based linearization)
+    std::vector<unsigned> faceOffsets_;
+    std::vector<char> faceOwned_;
+    std::vector<MatrixBlockType*> faceBlocks_;
+    std::vector<unsigned> foreignFaceOffsets_;
+    std::vector<unsigned> foreignFaces_;
+    std::vector<VectorBlock> faceResiduals_;
+    std::vector<MatrixBlock> faceJacobians_;
+
+    // the elements of the grid grouped by color (only used for colored linearization)
+    bool enableColoredLinearization_;
+    std::vector<std::vector<ElementSeed> > elementColors_;
+    int coloringSequenceNumber_;
 };
 
 } // namespace Ewoms
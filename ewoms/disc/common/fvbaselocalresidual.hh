@@ -185,6 +185,30 @@ public:
         }
     }
 
+    /*!
+     * \brief Compute the storage, source and boundary terms of the local residual, but
+     *        not the fluxes over the interior faces of the element.
+     *
+     * This is required if the fluxes are dealt with separately, e.g., by the face-based
+     * linearization. In contrast to eval(), the residual is not made volume specific.
+     *
+     * \copydetails Doxygen::residualParam
+     * \copydetails Doxygen::ecfvElemCtxParam
+     */
+    void evalVolumeAndBoundaryTerms(LocalEvalBlockVector &residual,
+                                    const ElementContext &elemCtx) const
+    {
+        assert(residual.size() == elemCtx.numDof(/*timeIdx=*/0));
+
+        residual = 0.0;
+
+        // evaluate the storage and the source terms
+        asImp_().evalVolumeTerms_(residual, elemCtx);
+
+        // evaluate the boundary conditions
+        asImp_().evalBoundary_(residual, elemCtx, /*timeIdx=*/0);
+    }
+
     /*!
      * \brief Calculate the amount of all conservation quantities stored in all element's
      *        sub-control volumes for a given history index.
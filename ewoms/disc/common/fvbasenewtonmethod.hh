@@ -152,6 +152,27 @@ protected:
         ParentType::beginIteration_();
     }
 
+    /*!
+     * \copydoc NewtonMethod::preSolve_
+     *
+     * In addition, the time step controller of the problem gets the chance to abort
+     * the Newton method early if it diverges or stagnates.
+     */
+    void preSolve_(const SolutionVector &currentSolution,
+                   const GlobalEqVector &currentResidual)
+    {
+        ParentType::preSolve_(currentSolution, currentResidual);
+
+        auto &timeStepController = this->problem().timeStepController();
+        if (timeStepController.newtonWillFail(this->numIterations(),
+                                              this->error_,
+                                              this->lastError_,
+                                              this->tolerance()))
+            OPM_THROW(Opm::NumericalProblem,
+                      "Newton: Error " << this->error_
+                      << " did not decrease significantly in the last two iterations");
+    }
+
     /*!
      * \brief Returns a reference to the model.
      */
@@ -32,8 +32,48 @@
 
 #include "fvbaseproperties.hh"
 
+#include <cassert>
+
 namespace Ewoms {
 
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief Stores the index of the first derivative which is used by a set of primary
+ *        variables.
+ *
+ * A non-zero offset is only required by the face-based linearization, so the offset
+ * takes up no memory if it is disabled.
+ */
+template <bool enableOffset>
+class FvBaseDerivativeOffset
+{
+public:
+    FvBaseDerivativeOffset()
+        : derivativeOffset_(0)
+    { }
+
+    unsigned derivativeOffset() const
+    { return derivativeOffset_; }
+
+    void setDerivativeOffset(unsigned offset)
+    { derivativeOffset_ = offset; }
+
+private:
+    unsigned derivativeOffset_;
+};
+
+template <>
+class FvBaseDerivativeOffset<false>
+{
+public:
+    unsigned derivativeOffset() const
+    { return 0; }
+
+    void setDerivativeOffset(unsigned offset)
+    { assert(offset == 0); }
+};
+
 /*!
  * \ingroup FiniteVolumeDiscretizations
  *
@@ -43,6 +83,7 @@ template <class TypeTag>
 class FvBasePrimaryVariables
     : public Dune::FieldVector<typename GET_PROP_TYPE(TypeTag, Scalar),
                                GET_PROP_VALUE(TypeTag, NumEq)>
+    , public FvBaseDerivativeOffset<GET_PROP_VALUE(TypeTag, EnableFaceBasedLinearization)>
 {
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
     typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
@@ -51,11 +92,12 @@ class FvBasePrimaryVariables
 
     typedef Opm::MathToolbox<Evaluation> Toolbox;
     typedef Dune::FieldVector<Scalar, numEq> ParentType;
+    typedef FvBaseDerivativeOffset<GET_PROP_VALUE(TypeTag, EnableFaceBasedLinearization)> OffsetType;
 
 public:
     FvBasePrimaryVariables()
         : ParentType()
-    { Valgrind::SetUndefined(*this); }
+    { Valgrind::SetUndefined(*static_cast<ParentType*>(this)); }
 
     /*!
      * \brief Construction from a scalar value
@@ -69,6 +111,7 @@ public:
      */
     FvBasePrimaryVariables(const FvBasePrimaryVariables &value)
         : ParentType(value)
+        , OffsetType(value)
     { }
 
     /*!
@@ -77,11 +120,15 @@ public:
      * i.e., the result represents the function f = x_i if the time index is zero, else
      * it represents the a constant f = x_i. (the difference is that in the first case,
      * the derivative w.r.t. x_i is 1, while it is 0 in the second case.
+     *
+     * The derivative which corresponds to x_i is shifted by the derivative offset of
+     * the object. This is only non-zero for the neighbors of an element if the
+     * face-based linearization is used.
      */
     Evaluation makeEvaluation(int varIdx, int timeIdx) const
     {
         if (timeIdx == 0)
-            return Toolbox::createVariable((*this)[varIdx], varIdx);
+            return Toolbox::createVariable((*this)[varIdx], this->derivativeOffset() + varIdx);
         else
             return Toolbox::createConstant((*this)[varIdx]);
     }
@@ -66,6 +66,7 @@ private:
     typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
     typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
     typedef typename GET_PROP_TYPE(TypeTag, NewtonMethod) NewtonMethod;
+    typedef typename GET_PROP_TYPE(TypeTag, TimeStepController) TimeStepController;
 
     typedef typename GET_PROP_TYPE(TypeTag, VertexMapper) VertexMapper;
     typedef typename GET_PROP_TYPE(TypeTag, ElementMapper) ElementMapper;
@@ -111,6 +112,7 @@ public:
         , boundingBoxMax_(-std::numeric_limits<double>::max())
         , simulator_(simulator)
         , defaultVtkWriter_(0)
+        , timeStepController_(simulator)
     {
         // calculate the bounding box of the local partition of the grid view
         VertexIterator vIt = gridView_.template begin<dim>();
@@ -146,6 +148,7 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, MaxTimeStepDivisions,
                              "The maximum number of divisions by two of the timestep size "
                              "before the simulation bails out");
+        TimeStepController::registerParameters();
     }
 
     /*!
@@ -314,6 +317,20 @@ public:
     void endIteration()
     { }
 
+    /*!
+     * \brief Returns true if all elements must be linearized in the current
+     *        Newton-Raphson iteration.
+     *
+     * If incremental linearization is enabled, only the elements around degrees of
+     * freedom with changed primary variables are re-linearized after the first
+     * iteration of a time step. Problems whose terms depend on a state which is not
+     * described by the primary variables, e.g., the state of a well which may be
+     * switched in beginIteration(), must return true if this state has changed since
+     * the previous iteration.
+     */
+    bool requiresFullLinearization() const
+    { return false; }
+
     /*!
      * \brief Called by the simulator after each time integration.
      *
@@ -411,11 +428,13 @@ public:
             solveTime_ += newtonMethod().solveTime();
             updateTime_ += newtonMethod().updateTime();
 
-            if (converged)
+            if (converged) {
+                timeStepController_.timeStepSucceeded();
                 return;
+            }
 
             Scalar dt = simulator().timeStepSize();
-            Scalar nextDt = dt / 2;
+            Scalar nextDt = timeStepController_.suggestRetryTimeStepSize(dt);
             if (nextDt < minTimeStepSize)
                 break; // give up: we can't make the time step smaller anymore!
             simulator().setTimeStepSize(nextDt);
@@ -441,7 +460,7 @@ public:
     Scalar nextTimeStepSize()
     {
         Scalar dtNext = std::min(EWOMS_GET_PARAM(TypeTag, Scalar, MaxTimeStepSize),
-                                 newtonMethod().suggestTimeStepSize(simulator().timeStepSize()));
+                                 timeStepController_.suggestTimeStepSize(simulator().timeStepSize()));
 
         if (dtNext < simulator().maxTimeStepSize()
             && simulator().maxTimeStepSize() < dtNext*2)
@@ -562,6 +581,18 @@ public:
      */
     const NewtonMethod &newtonMethod() const
     { return model().newtonMethod(); }
+
+    /*!
+     * \brief Returns the object which determines the size of the time steps.
+     */
+    TimeStepController &timeStepController()
+    { return timeStepController_; }
+
+    /*!
+     * \copydoc timeStepController()
+     */
+    const TimeStepController &timeStepController() const
+    { return timeStepController_; }
     // \}
 
     /*!
@@ -603,6 +634,8 @@ public:
     {
         if (enableVtkOutput_())
             defaultVtkWriter_->serialize(res);
+
+        timeStepController_.serialize(res);
     }
 
     /*!
@@ -620,6 +653,8 @@ public:
     {
         if (enableVtkOutput_())
             defaultVtkWriter_->deserialize(res);
+
+        timeStepController_.deserialize(res);
     }
 
     /*!
@@ -678,6 +713,9 @@ private:
     Simulator &simulator_;
     mutable VtkMultiWriter *defaultVtkWriter_;
 
+    // determines the size of the time steps
+    TimeStepController timeStepController_;
+
     // CPU time keeping
     Scalar linearizeTime_;
     Scalar solveTime_;
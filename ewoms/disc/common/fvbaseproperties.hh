@@ -168,6 +168,34 @@ NEW_PROP_TAG(ThreadsPerProcess);
 //! discretizations do not need this.)
 NEW_PROP_TAG(UseLinearizationLock);
 
+//! linearize the elements of the grid in groups ("colors") which do not share any row
+//! of the Jacobian matrix. The elements of a given color can thus be linearized by
+//! multiple threads without the need for locking.
+NEW_PROP_TAG(EnableColoredLinearization);
+
+//! only re-linearize the elements for which the primary variables of a degree of freedom
+//! have changed since the previous Newton iteration
+NEW_PROP_TAG(EnableIncrementalLinearization);
+
+//! the minimum change of the primary variables of a degree of freedom, relative to the
+//! error of the Newton method, for which the elements around it get re-linearized in
+//! the incremental linearization mode
+NEW_PROP_TAG(IncrementalLinearizationTolerance);
+
+//! compare each incremental linearization with a full one and abort if they deviate.
+//! (this is slow and only intended for debugging.)
+NEW_PROP_TAG(CheckIncrementalLinearization);
+
+//! Precompute the geometric quantities of the stencils of all elements of the grid
+NEW_PROP_TAG(EnableStencilGeometryCache);
+
+//! linearize the system of equations by visiting each face of the grid only once. this
+//! requires the element-centered finite volume discretization and automatic
+//! differentiation, and it doubles the number of derivatives of each evaluation: the
+//! first half refers to the primary variables of the element, the second half to those
+//! of its neighbor.
+NEW_PROP_TAG(EnableFaceBasedLinearization);
+
 // high-level simulation control
 
 //! Manages the simulation time
@@ -223,6 +251,27 @@ NEW_PROP_TAG(MinTimeStepSize);
  */
 NEW_PROP_TAG(MaxTimeStepDivisions);
 
+//! The class which determines the size of the next time step
+NEW_PROP_TAG(TimeStepController);
+
+/*!
+ * \brief The algorithm used by the time step controller.
+ *
+ * Valid choices are "IterationCount" and "PID".
+ */
+NEW_PROP_TAG(TimeStepControl);
+
+//! The relative change of the primary variables per time step targeted by the PID
+//! time step controller
+NEW_PROP_TAG(TimeStepControlTolerance);
+
+//! The maximum factor by which the time step controller increases the step size
+NEW_PROP_TAG(TimeStepControlMaxGrowthRate);
+
+//! Specify whether the Newton method should be aborted if its error does not decrease
+//! significantly in two consecutive iterations
+NEW_PROP_TAG(TimeStepControlPredictNewtonFailure);
+
 /*!
  * \brief Specify whether all intensive quantities for the grid should be
  *        cached in the discretization.
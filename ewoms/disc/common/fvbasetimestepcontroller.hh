@@ -0,0 +1,434 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::FvBaseTimeStepController
+ */
+#ifndef EWOMS_FV_BASE_TIME_STEP_CONTROLLER_HH
+#define EWOMS_FV_BASE_TIME_STEP_CONTROLLER_HH
+
+#include "fvbaseproperties.hh"
+
+#include <ewoms/parallel/locks.hh>
+#include <ewoms/parallel/threadmanager.hh>
+#include <ewoms/parallel/threadedentityiterator.hh>
+
+#include <opm/material/common/MathToolbox.hpp>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace Ewoms {
+namespace Properties {
+// forward definition of property tags
+NEW_PROP_TAG(NumPhases);
+} // namespace Properties
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief Determines the size of the next time step of a simulation.
+ *
+ * The algorithm which is used is selected by the TimeStepControl parameter:
+ *
+ * - "IterationCount": The old step size is scaled by the ratio of the target number of
+ *   Newton iterations to the number of iterations which were required for the last
+ *   time step (see NewtonMethod::suggestTimeStepSize()).
+ * - "PID": A PID controller on the relative change of the phase pressures and
+ *   saturations during the last time steps. The relative change is determined for
+ *   each quantity and phase separately. Since these quantities are taken from the
+ *   fluid state, the controller also works for models where the meaning of the
+ *   primary variables may change between time steps, e.g., the black-oil model.
+ *
+ * If a time step fails, the step size is cut by a factor between 1/4 and 1/2,
+ * depending on how far the Newton method got towards its tolerance. Optionally, the
+ * controller can be asked to abort a Newton method which diverges or stagnates. This
+ * allows to cut the time step early.
+ */
+template <class TypeTag>
+class FvBaseTimeStepController
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+
+    typedef typename GridView::template Codim<0>::Iterator ElementIterator;
+
+    typedef Opm::MathToolbox<Evaluation> Toolbox;
+
+    enum { numPhases = GET_PROP_VALUE(TypeTag, NumPhases) };
+
+    // the number of quantities for which the relative change is determined: the
+    // pressure and the saturation of each phase
+    enum { numQuantities = 2*numPhases };
+
+    // the number of relative changes of the previous time steps which are taken into
+    // account by the PID controller
+    enum { historySize = 3 };
+
+public:
+    FvBaseTimeStepController(Simulator &simulator)
+        : simulator_(simulator)
+    {
+        const std::string &algorithm = EWOMS_GET_PARAM(TypeTag, std::string, TimeStepControl);
+        if (algorithm == "IterationCount")
+            usePid_ = false;
+        else if (algorithm == "PID")
+            usePid_ = true;
+        else
+            OPM_THROW(std::runtime_error,
+                      "Unknown time step control algorithm '" << algorithm << "'. "
+                      "Valid choices are 'IterationCount' and 'PID'");
+
+        tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlTolerance);
+        maxGrowthRate_ = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepControlMaxGrowthRate);
+        predictNewtonFailure_ = EWOMS_GET_PARAM(TypeTag, bool, TimeStepControlPredictNewtonFailure);
+        numNonContractingIterations_ = 0;
+        resetNewtonErrors_();
+
+        // as long as no time step has been done, the relative changes are assumed to
+        // exactly meet the tolerance
+        for (unsigned i = 0; i < historySize; ++i)
+            relativeChanges_[i] = tolerance_;
+    }
+
+    /*!
+     * \brief Register all run-time parameters of the time step controller.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, TimeStepControl,
+                             "The algorithm used to determine the size of the next "
+                             "time step. Possible values: 'IterationCount', 'PID'");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlTolerance,
+                             "The relative change of the phase pressures and "
+                             "saturations per time step targeted by the PID time "
+                             "step controller");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepControlMaxGrowthRate,
+                             "The maximum factor by which the PID time step controller "
+                             "increases the time step size");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, TimeStepControlPredictNewtonFailure,
+                             "Abort the Newton method if its error did not decrease "
+                             "significantly in two consecutive iterations");
+    }
+
+    /*!
+     * \brief Called by the problem after a time step was successfully solved.
+     *
+     * This method must be called before the model advances its time level because the
+     * solutions at the beginning and at the end of the time step are required.
+     */
+    void timeStepSucceeded()
+    {
+        resetNewtonErrors_();
+
+        if (!usePid_)
+            return;
+
+        for (unsigned i = 0; i < historySize - 1; ++i)
+            relativeChanges_[i] = relativeChanges_[i + 1];
+        relativeChanges_[historySize - 1] = relativeChange_();
+    }
+
+    /*!
+     * \brief Returns the size of the time step which ought to be used after a time step
+     *        of a given size was successful.
+     *
+     * \param dt The size of the last time step \f$\mathrm{[s]}\f$
+     */
+    Scalar suggestTimeStepSize(Scalar dt) const
+    {
+        if (!usePid_)
+            return simulator_.model().newtonMethod().suggestTimeStepSize(dt);
+
+        const Scalar e0 = relativeChanges_[0];
+        const Scalar e1 = relativeChanges_[1];
+        const Scalar e2 = relativeChanges_[2];
+
+        // the primary variables did not change at all. grow the time step as fast as
+        // allowed
+        if (e2 <= 0.0)
+            return dt*maxGrowthRate_;
+
+        // if the change is larger than the tolerance, the step size gets reduced
+        // proportionally
+        if (e2 > tolerance_)
+            return dt*tolerance_/e2;
+
+        // the coefficients of the PID controller, see
+        //
+        // Soederlind: "Digital Filters in Adaptive Time-Stepping", ACM Transactions on
+        // Mathematical Software, 29(1), pp. 1-26, 2003
+        static const Scalar kP = 0.075;
+        static const Scalar kI = 0.175;
+        static const Scalar kD = 0.01;
+
+        Scalar factor =
+            std::pow(e1/e2, kP)
+            * std::pow(tolerance_/e2, kI)
+            * std::pow(e1*e1/(e2*e0), kD);
+
+        return dt*std::min(factor, maxGrowthRate_);
+    }
+
+    /*!
+     * \brief Returns the size of the time step which ought to be tried after a time
+     *        step of a given size failed.
+     *
+     * The step size is cut more aggressively the less progress the Newton method made
+     * towards its tolerance: If its error was reduced by the same number of orders of
+     * magnitude as required to converge, the step size is halved. If the error was not
+     * reduced at all, if it diverged or if the Newton method failed before its error
+     * could be determined, it is cut to a quarter.
+     *
+     * \param dt The size of the failed time step \f$\mathrm{[s]}\f$
+     */
+    Scalar suggestRetryTimeStepSize(Scalar dt)
+    {
+        Scalar progress = 0.0;
+        if (std::isfinite(newtonInitialError_) && std::isfinite(newtonError_)
+            && newtonInitialError_ > 0.0 && newtonError_ > 0.0)
+        {
+            if (newtonInitialError_ <= newtonTolerance_)
+                progress = 1.0;
+            else
+                progress =
+                    std::log(newtonInitialError_/newtonError_)
+                    / std::log(newtonInitialError_/newtonTolerance_);
+        }
+        progress = std::max<Scalar>(0.0, std::min<Scalar>(1.0, progress));
+
+        // the next attempt starts with a new Newton method
+        resetNewtonErrors_();
+
+        return dt*(0.25 + 0.25*progress);
+    }
+
+    /*!
+     * \brief Returns true if the Newton method is not expected to converge anymore.
+     *
+     * This method is called once per Newton iteration. Since the Newton method
+     * converges faster than linearly once it is close to the solution, a slow
+     * reduction of the error in a single iteration does not say much. Instead, the
+     * Newton method is considered to fail only if the error was not reduced
+     * significantly in at least two consecutive iterations, i.e., if it diverges or
+     * stagnates.
+     *
+     * The errors are also recorded to determine the size of the next attempt if the
+     * time step fails (see suggestRetryTimeStepSize()).
+     *
+     * \param numIterations The number of iterations done so far
+     * \param error The error of the current solution
+     * \param lastError The error of the solution of the previous iteration
+     * \param tolerance The error below which the Newton method is considered to be
+     *                  converged
+     */
+    bool newtonWillFail(int numIterations,
+                        Scalar error,
+                        Scalar lastError,
+                        Scalar tolerance)
+    {
+        // remember the progress of the Newton method in case the time step fails
+        if (numIterations < 1)
+            newtonInitialError_ = error;
+        newtonError_ = error;
+        newtonTolerance_ = tolerance;
+
+        if (!predictNewtonFailure_)
+            return false;
+
+        // the error of the initial solution cannot be compared to anything
+        if (numIterations < 1) {
+            numNonContractingIterations_ = 0;
+            return false;
+        }
+
+        if (error <= tolerance)
+            return false;
+
+        // the error of an iteration must be reduced by at least 10% to count as
+        // progress
+        if (error > 0.9*lastError)
+            ++ numNonContractingIterations_;
+        else
+            numNonContractingIterations_ = 0;
+
+        return numNonContractingIterations_ >= 2;
+    }
+
+    /*!
+     * \brief Write the state of the time step controller to a restart file.
+     *
+     * \tparam Restarter The type of the object which takes care to serialize data
+     * \param restarter The serializer object
+     */
+    template <class Restarter>
+    void serialize(Restarter &restarter)
+    {
+        restarter.serializeSectionBegin("TimeStepController");
+        for (unsigned i = 0; i < historySize; ++i)
+            restarter.serializeStream() << relativeChanges_[i] << " ";
+        restarter.serializeSectionEnd();
+    }
+
+    /*!
+     * \brief Read the state of the time step controller from a restart file.
+     *
+     * Restart files which were written before the time step controller was
+     * serialized do not contain its section. In this case, the controller keeps its
+     * initial state.
+     *
+     * \tparam Restarter The type of the object which takes care to deserialize data
+     * \param restarter The deserializer object
+     */
+    template <class Restarter>
+    void deserialize(Restarter &restarter)
+    {
+        if (!restarter.deserializeOptionalSectionBegin("TimeStepController"))
+            return;
+
+        for (unsigned i = 0; i < historySize; ++i)
+            restarter.deserializeStream() >> relativeChanges_[i];
+        restarter.deserializeSectionEnd();
+    }
+
+private:
+    void resetNewtonErrors_()
+    {
+        newtonInitialError_ = -1.0;
+        newtonError_ = -1.0;
+        newtonTolerance_ = 0.0;
+    }
+
+    // returns the largest relative change of a phase pressure or saturation during
+    // the last time step. the relative change is the ratio of the norm of the change
+    // of the quantity and the norm of its new values. the primary variables cannot be
+    // used directly because their meaning may be different at the beginning and at
+    // the end of the time step.
+    Scalar relativeChange_() const
+    {
+        const auto &model = simulator_.model();
+
+        Scalar changeNorm2[numQuantities] = { 0.0 };
+        Scalar valueNorm2[numQuantities] = { 0.0 };
+
+        OmpMutex mutex;
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(model.elementChunks());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            // Attention: the variables below are thread specific and thus cannot be
+            // moved in front of the #pragma!
+            ElementContext& elemCtx = model.threadElementContext();
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            Scalar threadChangeNorm2[numQuantities] = { 0.0 };
+            Scalar threadValueNorm2[numQuantities] = { 0.0 };
+
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const auto& elem = *elemIt;
+                if (elem.partitionType() != Dune::InteriorEntity)
+                    continue; // ignore ghost and overlap elements
+
+                elemCtx.updateStencil(elem);
+                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/1);
+
+                for (unsigned dofIdx = 0; dofIdx < elemCtx.numPrimaryDof(/*timeIdx=*/0); ++dofIdx) {
+                    // with vertex-centered discretizations, a degree of freedom is
+                    // shared by multiple elements and processes. its contributions are
+                    // thus weighted by the fraction of its volume which is located
+                    // within the current element.
+                    Scalar weight =
+                        elemCtx.dofVolume(dofIdx, /*timeIdx=*/0)
+                        / elemCtx.dofTotalVolume(dofIdx, /*timeIdx=*/0);
+
+                    const auto &newFs = elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/0).fluidState();
+                    const auto &oldFs = elemCtx.intensiveQuantities(dofIdx, /*timeIdx=*/1).fluidState();
+                    for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                        Scalar newP = Toolbox::value(newFs.pressure(phaseIdx));
+                        Scalar oldP = Toolbox::value(oldFs.pressure(phaseIdx));
+                        threadChangeNorm2[2*phaseIdx] += weight*(newP - oldP)*(newP - oldP);
+                        threadValueNorm2[2*phaseIdx] += weight*newP*newP;
+
+                        Scalar newS = Toolbox::value(newFs.saturation(phaseIdx));
+                        Scalar oldS = Toolbox::value(oldFs.saturation(phaseIdx));
+                        threadChangeNorm2[2*phaseIdx + 1] += weight*(newS - oldS)*(newS - oldS);
+                        threadValueNorm2[2*phaseIdx + 1] += weight*newS*newS;
+                    }
+                }
+            }
+
+            ScopedLock addLock(mutex);
+            for (unsigned qIdx = 0; qIdx < numQuantities; ++qIdx) {
+                changeNorm2[qIdx] += threadChangeNorm2[qIdx];
+                valueNorm2[qIdx] += threadValueNorm2[qIdx];
+            }
+            addLock.unlock();
+        }
+
+        const auto &comm = simulator_.gridView().comm();
+        comm.sum(changeNorm2, numQuantities);
+        comm.sum(valueNorm2, numQuantities);
+
+        Scalar result = 0.0;
+        for (unsigned qIdx = 0; qIdx < numQuantities; ++qIdx) {
+            if (valueNorm2[qIdx] <= std::numeric_limits<Scalar>::min())
+                continue;
+            result = std::max(result, std::sqrt(changeNorm2[qIdx]/valueNorm2[qIdx]));
+        }
+
+        return result;
+    }
+
+    const Simulator &simulator_;
+
+    bool usePid_;
+    bool predictNewtonFailure_;
+    int numNonContractingIterations_;
+    Scalar tolerance_;
+    Scalar maxGrowthRate_;
+
+    // the errors of the first and of the most recent iteration of the Newton method
+    // for the current time step, and its tolerance. negative errors mean that they
+    // are not known.
+    Scalar newtonInitialError_;
+    Scalar newtonError_;
+    Scalar newtonTolerance_;
+
+    // the relative changes of the primary variables of the last time steps. the most
+    // recent one is the last entry.
+    Scalar relativeChanges_[historySize];
+};
+
+} // namespace Ewoms
+
+#endif
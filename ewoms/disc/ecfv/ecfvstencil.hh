@@ -37,6 +37,7 @@
 #include <dune/common/version.hh>
 
 #include <vector>
+#include <cstddef>
 
 namespace Ewoms {
 /*!
@@ -99,6 +100,20 @@ public:
 #endif
         { update(); }
 
+        // construct a sub-control volume using precomputed geometric quantities
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        SubControlVolume(const Element &element, const GlobalPosition &centerPos, Scalar volume)
+            : centerPos_(centerPos)
+            , volume_(volume)
+            , element_(element)
+#else
+        SubControlVolume(const ElementPointer &elementPtr, const GlobalPosition &centerPos, Scalar volume)
+            : centerPos_(centerPos)
+            , volume_(volume)
+            , elementPtr_(elementPtr)
+#endif
+        { }
+
 #if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
         void update(const Element &element)
         { element_ = element; }
@@ -178,6 +193,17 @@ public:
             area_ = geometry.volume();
         }
 
+        // construct a face using precomputed geometric quantities
+        SubControlVolumeFace(unsigned localNeighborIdx,
+                             const GlobalPosition &integrationPos,
+                             const WorldVector &normal,
+                             Scalar area)
+            : exteriorIdx_(localNeighborIdx)
+            , area_(area)
+            , integrationPos_(integrationPos)
+            , normal_(normal)
+        { }
+
         /*!
          * \brief Returns the local index of the degree of freedom to
          *        the face's interior.
@@ -232,10 +258,47 @@ public:
     EcfvStencil(const GridView &gridView, const Mapper& mapper)
         : gridView_(gridView)
         , elementMapper_(mapper)
+        , geometryCache_(0)
     { }
 
+    /*!
+     * \brief Allocate the storage for stencils up to a given size.
+     *
+     * \param numDof The maximum number of degrees of freedom of a stencil
+     * \param numInteriorFaces The maximum number of interior faces of a stencil
+     * \param numBoundaryFaces The maximum number of boundary faces of a stencil
+     */
+    void reserve(unsigned numDof, unsigned numInteriorFaces, unsigned numBoundaryFaces)
+    {
+        elements_.reserve(numDof);
+        subControlVolumes_.reserve(numDof);
+        interiorFaces_.reserve(numInteriorFaces);
+        boundaryFaces_.reserve(numBoundaryFaces);
+    }
+
+    /*!
+     * \brief Returns the total number of objects for which the stencil has allocated
+     *        storage.
+     *
+     * Since this number never decreases, it can be used to detect whether updating the
+     * stencil required a heap allocation.
+     */
+    size_t capacity() const
+    {
+        return
+            elements_.capacity()
+            + subControlVolumes_.capacity()
+            + interiorFaces_.capacity()
+            + boundaryFaces_.capacity();
+    }
+
     void updateTopology(const Element &element)
     {
+        if (useGeometryCache_()) {
+            updateTopologyFromCache_(element);
+            return;
+        }
+
         auto isIt = gridView_.ibegin(element);
         const auto &endIsIt = gridView_.iend(element);
 
@@ -275,6 +338,25 @@ public:
 
     void updatePrimaryTopology(const Element &element)
     {
+        if (useGeometryCache_()) {
+            unsigned elemIdx = elementIndex_(element);
+            subControlVolumes_.clear();
+            elements_.clear();
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            subControlVolumes_.emplace_back(element,
+                                            geometryCache_->elemCenter[elemIdx],
+                                            geometryCache_->elemVolume[elemIdx]);
+            elements_.emplace_back(element);
+#else
+            ElementPointer ePtr(element);
+            subControlVolumes_.emplace_back(ePtr,
+                                            geometryCache_->elemCenter[elemIdx],
+                                            geometryCache_->elemVolume[elemIdx]);
+            elements_.emplace_back(ePtr);
+#endif
+            return;
+        }
+
 #if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
         // add the "center" element of the stencil
         subControlVolumes_.clear();
@@ -414,9 +496,251 @@ public:
     const SubControlVolumeFace &boundaryFace(unsigned bfIdx) const
     { return boundaryFaces_[bfIdx]; }
 
+    /*!
+     * \brief The geometric quantities of all elements of a grid view and of their
+     *        intersections.
+     *
+     * The quantities are stored in flat arrays. The intersections of an element are
+     * stored in the order in which they are visited by the grid view's intersection
+     * iterator, and for each of them the index of the neighboring element is stored, so
+     * that the stencils do not need to iterate over the intersections at all. The cache
+     * is owned by the discretization, which rebuilds it whenever the sequence number of
+     * the grid changes.
+     */
+    class GeometryCache
+    {
+    public:
+        GeometryCache()
+            : sequenceNumber_(-1)
+        { }
+
+        /*!
+         * \brief Compute the geometric quantities for a grid view.
+         *
+         * \param gridView The grid view for which the quantities are computed
+         * \param mapper The mapper for the elements of the grid view
+         * \param sequenceNumber The sequence number of the grid
+         */
+        void update(const GridView &gridView, const Mapper &mapper, int sequenceNumber)
+        {
+            clear();
+
+            unsigned numElements = gridView.size(/*codim=*/0);
+            elemVolume.resize(numElements);
+            elemCenter.resize(numElements);
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            elements.resize(numElements);
+#endif
+            intersectionOffset.resize(numElements + 1, 0);
+
+            // count the intersections of each element
+            auto elemIt = gridView.template begin</*codim=*/0>();
+            const auto &elemEndIt = gridView.template end</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt) {
+                const Element &elem = *elemIt;
+                unsigned numIntersections = 0;
+                auto isIt = gridView.ibegin(elem);
+                const auto &endIsIt = gridView.iend(elem);
+                for (; isIt != endIsIt; ++isIt)
+                    ++numIntersections;
+
+                intersectionOffset[elementIndex_(mapper, elem) + 1] = numIntersections;
+            }
+            for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+                intersectionOffset[elemIdx + 1] += intersectionOffset[elemIdx];
+
+            // compute the geometric quantities
+            unsigned numIntersections = intersectionOffset[numElements];
+            intersectionNeighbor.resize(numIntersections);
+            intersectionArea.resize(numIntersections);
+            intersectionCenter.resize(numIntersections);
+            intersectionNormal.resize(numIntersections);
+            elemIt = gridView.template begin</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt) {
+                const Element &elem = *elemIt;
+                unsigned elemIdx = elementIndex_(mapper, elem);
+
+                const auto &geometry = elem.geometry();
+                elemVolume[elemIdx] = geometry.volume();
+                elemCenter[elemIdx] = geometry.center();
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                elements[elemIdx] = elem;
+#endif
+
+                unsigned isIdx = intersectionOffset[elemIdx];
+                auto isIt = gridView.ibegin(elem);
+                const auto &endIsIt = gridView.iend(elem);
+                for (; isIt != endIsIt; ++isIt, ++isIdx) {
+                    const auto &intersection = *isIt;
+                    if (intersection.neighbor()) {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                        intersectionNeighbor[isIdx] = elementIndex_(mapper, intersection.outside());
+#else
+                        intersectionNeighbor[isIdx] = elementIndex_(mapper, *intersection.outside());
+#endif
+                    }
+                    else
+                        intersectionNeighbor[isIdx] = -1;
+
+                    const auto &isGeometry = intersection.geometry();
+                    intersectionArea[isIdx] = isGeometry.volume();
+                    intersectionCenter[isIdx] = isGeometry.center();
+                    intersectionNormal[isIdx] = intersection.centerUnitOuterNormal();
+                }
+            }
+
+            sequenceNumber_ = sequenceNumber;
+        }
+
+        /*!
+         * \brief Discard the precomputed geometric quantities.
+         */
+        void clear()
+        {
+            sequenceNumber_ = -1;
+            std::vector<Scalar>().swap(elemVolume);
+            std::vector<GlobalPosition>().swap(elemCenter);
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            std::vector<Element>().swap(elements);
+#endif
+            std::vector<unsigned>().swap(intersectionOffset);
+            std::vector<int>().swap(intersectionNeighbor);
+            std::vector<Scalar>().swap(intersectionArea);
+            std::vector<GlobalPosition>().swap(intersectionCenter);
+            std::vector<WorldVector>().swap(intersectionNormal);
+        }
+
+        /*!
+         * \brief Returns true if the geometric quantities have been computed.
+         */
+        bool isValid() const
+        { return sequenceNumber_ >= 0; }
+
+        /*!
+         * \brief Returns the sequence number of the grid for which the quantities have
+         *        been computed or -1 if they have not been computed.
+         */
+        int sequenceNumber() const
+        { return sequenceNumber_; }
+
+        /*!
+         * \brief Returns the number of bytes occupied by the cache.
+         */
+        std::size_t memoryUsage() const
+        {
+            return
+                elemVolume.capacity()*sizeof(Scalar)
+                + elemCenter.capacity()*sizeof(GlobalPosition)
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                + elements.capacity()*sizeof(Element)
+#endif
+                + intersectionOffset.capacity()*sizeof(unsigned)
+                + intersectionNeighbor.capacity()*sizeof(int)
+                + intersectionArea.capacity()*sizeof(Scalar)
+                + intersectionCenter.capacity()*sizeof(GlobalPosition)
+                + intersectionNormal.capacity()*sizeof(WorldVector);
+        }
+
+        std::vector<Scalar> elemVolume;
+        std::vector<GlobalPosition> elemCenter;
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        std::vector<Element> elements;
+#endif
+
+        std::vector<unsigned> intersectionOffset;
+        std::vector<int> intersectionNeighbor;
+        std::vector<Scalar> intersectionArea;
+        std::vector<GlobalPosition> intersectionCenter;
+        std::vector<WorldVector> intersectionNormal;
+
+    private:
+        int sequenceNumber_;
+    };
+
+    /*!
+     * \brief Specify the precomputed geometric quantities to be used by the stencil.
+     *
+     * If the cache has been computed, the stencil looks up the volumes, centers, face
+     * normals, face areas and neighbors of the elements instead of querying the grid.
+     * The cache object must stay alive as long as it is used by the stencil.
+     */
+    void setGeometryCache(const GeometryCache *cache)
+    { geometryCache_ = cache; }
+
 protected:
+    bool useGeometryCache_() const
+    { return geometryCache_ && geometryCache_->isValid(); }
+
+    // same as updateTopology(), but take the geometric quantities and the neighbors
+    // from the cache
+    void updateTopologyFromCache_(const Element &element)
+    {
+        const GeometryCache &cache = *geometryCache_;
+        unsigned elemIdx = elementIndex_(element);
+
+        // add the "center" element of the stencil
+        subControlVolumes_.clear();
+        elements_.clear();
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        subControlVolumes_.emplace_back(element, cache.elemCenter[elemIdx], cache.elemVolume[elemIdx]);
+        elements_.emplace_back(element);
+#else
+        ElementPointer ePtr(element);
+        subControlVolumes_.emplace_back(ePtr, cache.elemCenter[elemIdx], cache.elemVolume[elemIdx]);
+        elements_.emplace_back(ePtr);
+
+        // the element pointers of the neighbors can only be obtained from the
+        // intersections for old versions of DUNE
+        auto isIt = gridView_.ibegin(element);
+#endif
+
+        interiorFaces_.clear();
+        boundaryFaces_.clear();
+
+        unsigned isEndIdx = cache.intersectionOffset[elemIdx + 1];
+        for (unsigned isIdx = cache.intersectionOffset[elemIdx]; isIdx < isEndIdx; ++isIdx) {
+            int neighborIdx = cache.intersectionNeighbor[isIdx];
+            if (neighborIdx >= 0) {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                elements_.emplace_back(cache.elements[neighborIdx]);
+#else
+                elements_.emplace_back(isIt->outside());
+#endif
+                subControlVolumes_.emplace_back(elements_.back(),
+                                                cache.elemCenter[neighborIdx],
+                                                cache.elemVolume[neighborIdx]);
+                interiorFaces_.emplace_back(subControlVolumes_.size() - 1,
+                                            cache.intersectionCenter[isIdx],
+                                            cache.intersectionNormal[isIdx],
+                                            cache.intersectionArea[isIdx]);
+            }
+            else {
+                boundaryFaces_.emplace_back(/*localNeighborIdx=*/-10000,
+                                            cache.intersectionCenter[isIdx],
+                                            cache.intersectionNormal[isIdx],
+                                            cache.intersectionArea[isIdx]);
+            }
+#if ! DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            ++isIt;
+#endif
+        }
+    }
+
+    unsigned elementIndex_(const Element &element) const
+    { return elementIndex_(elementMapper_, element); }
+
+    static unsigned elementIndex_(const Mapper &mapper, const Element &element)
+    {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        return mapper.index(element);
+#else
+        return mapper.map(element);
+#endif
+    }
+
     const GridView&       gridView_;
     const ElementMapper&  elementMapper_;
+    const GeometryCache*  geometryCache_;
 
 #if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
     std::vector<Element> elements_;
@@ -44,6 +44,9 @@
 #include <dune/common/version.hh>
 
 #include <vector>
+#include <memory>
+#include <utility>
+#include <cstddef>
 
 namespace Ewoms {
 
@@ -823,6 +826,7 @@ public:
 #else
         , elementPtr_(gridView.template begin</*codim=*/0>())
 #endif
+        , geometryCache_(0)
     {
         static bool localGeometriesInitialized = false;
         if (!localGeometriesInitialized) {
@@ -882,6 +886,11 @@ public:
     {
         updateTopology(e);
 
+        if (geometryCache_ && geometryCache_->isValid()) {
+            updateFromCache_(e);
+            return;
+        }
+
         const Geometry& geometry = e.geometry();
         geometryType_ = geometry.type();
 
@@ -1081,6 +1090,25 @@ public:
     }
 #endif
 
+    /*!
+     * \brief Allocate the storage for stencils up to a given size.
+     *
+     * The storage of this stencil is statically sized, so this is a no-op.
+     */
+    void reserve(unsigned /*numDof*/,
+                 unsigned /*numInteriorFaces*/,
+                 unsigned /*numBoundaryFaces*/)
+    { }
+
+    /*!
+     * \brief Returns the total number of objects for which the stencil has allocated
+     *        heap storage.
+     *
+     * The storage of this stencil is statically sized, so this is always 0.
+     */
+    size_t capacity() const
+    { return 0; }
+
     unsigned numDof() const
     { return numVertices; }
 
@@ -1146,7 +1174,207 @@ public:
 #endif
     }
 
+    /*!
+     * \brief The geometric quantities of the sub-control volumes and their faces for
+     *        all elements of a grid view.
+     *
+     * The data for the sub-control volumes and the interior faces are stored using a
+     * fixed stride per element (maxNC and maxNE), the one of the boundary faces is
+     * stored compressed. The cache is owned by the discretization, which rebuilds it
+     * whenever the sequence number of the grid changes.
+     */
+    class GeometryCache
+    {
+        typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView,
+                                                          Dune::MCMGElementLayout> ElementMapper;
+
+    public:
+        GeometryCache()
+            : sequenceNumber_(-1)
+        { }
+
+        /*!
+         * \brief Compute the geometric quantities for a grid view.
+         *
+         * \param gridView The grid view for which the quantities are computed
+         * \param vertexMapper The mapper for the vertices of the grid view
+         * \param sequenceNumber The sequence number of the grid
+         */
+        void update(const GridView &gridView, const VertexMapper &vertexMapper, int sequenceNumber)
+        {
+            clear();
+
+            elementMapper_.reset(new ElementMapper(gridView));
+            unsigned numElements = gridView.size(/*codim=*/0);
+            scvVolume.resize(numElements*maxNC);
+            faceIndices.resize(numElements*maxNE);
+            faceLocalPos.resize(numElements*maxNE);
+            faceGlobalPos.resize(numElements*maxNE);
+            faceNormal.resize(numElements*maxNE);
+            faceArea.resize(numElements*maxNE);
+            boundaryOffset.resize(numElements + 1, 0);
+
+            // compute the geometric quantities using the regular code path of a
+            // stencil which does not use any cache
+            VcfvStencil stencil(gridView, vertexMapper);
+            auto elemIt = gridView.template begin</*codim=*/0>();
+            const auto &elemEndIt = gridView.template end</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt) {
+                const Element &elem = *elemIt;
+                stencil.update(elem);
+
+                unsigned elemIdx = elementIndex(elem);
+                for (unsigned scvIdx = 0; scvIdx < stencil.numVertices; ++scvIdx)
+                    scvVolume[elemIdx*maxNC + scvIdx] = stencil.subContVol[scvIdx].volume_;
+
+                for (unsigned faceIdx = 0; faceIdx < stencil.numEdges; ++faceIdx) {
+                    const auto &face = stencil.subContVolFace[faceIdx];
+                    unsigned cacheIdx = elemIdx*maxNE + faceIdx;
+                    faceIndices[cacheIdx] = std::make_pair(face.i, face.j);
+                    faceLocalPos[cacheIdx] = face.ipLocal_;
+                    faceGlobalPos[cacheIdx] = face.ipGlobal_;
+                    faceNormal[cacheIdx] = face.normal_;
+                    faceArea[cacheIdx] = face.area_;
+                }
+
+                boundaryOffset[elemIdx + 1] = stencil.numBoundarySegments_;
+            }
+
+            // the boundary segments are stored in a compressed way because only few
+            // elements are located on the boundary
+            for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+                boundaryOffset[elemIdx + 1] += boundaryOffset[elemIdx];
+            boundaryFaces.resize(boundaryOffset[numElements]);
+            elemIt = gridView.template begin</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt) {
+                const Element &elem = *elemIt;
+                unsigned elemIdx = elementIndex(elem);
+                unsigned offset = boundaryOffset[elemIdx];
+                unsigned numBoundarySegments = boundaryOffset[elemIdx + 1] - offset;
+                if (numBoundarySegments == 0)
+                    continue;
+
+                stencil.update(elem);
+                for (unsigned bfIdx = 0; bfIdx < numBoundarySegments; ++bfIdx)
+                    boundaryFaces[offset + bfIdx] = stencil.boundaryFace_[bfIdx];
+            }
+
+            sequenceNumber_ = sequenceNumber;
+        }
+
+        /*!
+         * \brief Discard the precomputed geometric quantities.
+         */
+        void clear()
+        {
+            sequenceNumber_ = -1;
+            elementMapper_.reset();
+            std::vector<Scalar>().swap(scvVolume);
+            std::vector<std::pair<unsigned, unsigned> >().swap(faceIndices);
+            std::vector<LocalPosition>().swap(faceLocalPos);
+            std::vector<GlobalPosition>().swap(faceGlobalPos);
+            std::vector<DimVector>().swap(faceNormal);
+            std::vector<Scalar>().swap(faceArea);
+            std::vector<unsigned>().swap(boundaryOffset);
+            std::vector<BoundaryFace>().swap(boundaryFaces);
+        }
+
+        /*!
+         * \brief Returns true if the geometric quantities have been computed.
+         */
+        bool isValid() const
+        { return sequenceNumber_ >= 0; }
+
+        /*!
+         * \brief Returns the sequence number of the grid for which the quantities have
+         *        been computed or -1 if they have not been computed.
+         */
+        int sequenceNumber() const
+        { return sequenceNumber_; }
+
+        /*!
+         * \brief Returns the index of an element in the cache.
+         */
+        unsigned elementIndex(const Element &elem) const
+        {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            return elementMapper_->index(elem);
+#else
+            return elementMapper_->map(elem);
+#endif
+        }
+
+        /*!
+         * \brief Returns the number of bytes occupied by the cache.
+         */
+        std::size_t memoryUsage() const
+        {
+            return
+                scvVolume.capacity()*sizeof(Scalar)
+                + faceIndices.capacity()*sizeof(std::pair<unsigned, unsigned>)
+                + faceLocalPos.capacity()*sizeof(LocalPosition)
+                + faceGlobalPos.capacity()*sizeof(GlobalPosition)
+                + faceNormal.capacity()*sizeof(DimVector)
+                + faceArea.capacity()*sizeof(Scalar)
+                + boundaryOffset.capacity()*sizeof(unsigned)
+                + boundaryFaces.capacity()*sizeof(BoundaryFace);
+        }
+
+        std::vector<Scalar> scvVolume;
+
+        std::vector<std::pair<unsigned, unsigned> > faceIndices;
+        std::vector<LocalPosition> faceLocalPos;
+        std::vector<GlobalPosition> faceGlobalPos;
+        std::vector<DimVector> faceNormal;
+        std::vector<Scalar> faceArea;
+
+        std::vector<unsigned> boundaryOffset;
+        std::vector<BoundaryFace> boundaryFaces;
+
+    private:
+        std::shared_ptr<ElementMapper> elementMapper_;
+        int sequenceNumber_;
+    };
+
+    /*!
+     * \brief Specify the precomputed geometric quantities to be used by the stencil.
+     *
+     * If the cache has been computed, update() looks up the volumes, face normals, face
+     * areas and integration points of the sub-control volumes instead of recomputing
+     * them. The cache object must stay alive as long as it is used by the stencil.
+     */
+    void setGeometryCache(const GeometryCache *cache)
+    { geometryCache_ = cache; }
+
 private:
+    // the part of update() after updateTopology() if the geometry cache is available
+    void updateFromCache_(const Element &e)
+    {
+        const GeometryCache &cache = *geometryCache_;
+        unsigned elemIdx = cache.elementIndex(e);
+
+        for (unsigned scvIdx = 0; scvIdx < numVertices; ++scvIdx)
+            subContVol[scvIdx].volume_ = cache.scvVolume[elemIdx*maxNC + scvIdx];
+
+        for (unsigned faceIdx = 0; faceIdx < numEdges; ++faceIdx) {
+            auto &face = subContVolFace[faceIdx];
+            unsigned cacheIdx = elemIdx*maxNE + faceIdx;
+            face.i = cache.faceIndices[cacheIdx].first;
+            face.j = cache.faceIndices[cacheIdx].second;
+            face.ipLocal_ = cache.faceLocalPos[cacheIdx];
+            face.ipGlobal_ = cache.faceGlobalPos[cacheIdx];
+            face.normal_ = cache.faceNormal[cacheIdx];
+            face.area_ = cache.faceArea[cacheIdx];
+        }
+
+        unsigned offset = cache.boundaryOffset[elemIdx];
+        numBoundarySegments_ = cache.boundaryOffset[elemIdx + 1] - offset;
+        for (unsigned bfIdx = 0; bfIdx < numBoundarySegments_; ++bfIdx)
+            boundaryFace_[bfIdx] = cache.boundaryFaces[offset + bfIdx];
+
+        updateScvGeometry(e);
+    }
+
     void fillSubContVolData_()
     {
         if (dim == 1) {
@@ -1373,6 +1601,8 @@ private:
     static LocalFiniteElementCache feCache_;
 #endif // HAVE_DUNE_LOCALFUNCTIONS
 
+    const GeometryCache *geometryCache_;
+
     //! local coordinate of element center
     LocalPosition elementLocal;
     //! global coordinate of element center
@@ -212,6 +212,29 @@ public:
                       "Could not start section '" << cookie << "'");
     }
 
+    /*!
+     * \brief Start reading a section of the restart file which may not exist.
+     *
+     * If the next section of the file is not the requested one, the read position
+     * is left unchanged and false is returned. This allows to read restart files
+     * which were written before a section was introduced.
+     */
+    bool deserializeOptionalSectionBegin(const std::string &cookie)
+    {
+        if (!inStream_.good())
+            return false;
+
+        std::streampos pos = inStream_.tellg();
+        std::string buf;
+        std::getline(inStream_, buf);
+        if (buf == cookie)
+            return true;
+
+        inStream_.clear();
+        inStream_.seekg(pos);
+        return false;
+    }
+
     /*!
      * \brief End of a section in the serialized output.
      */
@@ -406,11 +406,16 @@ public:
 
     /*!
      * \brief Read the multi-writer's state from a restart file.
+     *
+     * If the restart file does not contain the state of the writer, e.g., because it
+     * was written by a simulator which did not serialize it, the writer is left
+     * untouched.
      */
     template <class Restarter>
     void deserialize(Restarter &res)
     {
-        res.deserializeSectionBegin("VTKMultiWriter");
+        if (!res.deserializeOptionalSectionBegin("VTKMultiWriter"))
+            return;
         res.deserializeStream() >> curWriterNum_;
 
         if (commRank_ == 0) {
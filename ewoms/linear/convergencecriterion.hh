@@ -86,6 +86,25 @@ public:
      */
     virtual void setInitial(const Vector &curSol, const Vector &curResid) = 0;
 
+    /*!
+     * \brief Set the initial solution of the linear system of equations.
+     *
+     * This version of the method takes the two-norm of the residual as
+     * argument. Criteria which are based on this norm can use it instead of
+     * computing it themselves, which saves a global reduction in parallel
+     * computations. By default, the norm is ignored.
+     *
+     * \param curSol The current iterative solution of the linear system
+     *               of equations
+     * \param curResid The residual vector of the current iterative
+     *                 solution of the linear system of equations
+     * \param curResidNorm The two-norm of the residual vector
+     */
+    virtual void setInitial(const Vector &curSol,
+                            const Vector &curResid,
+                            Scalar curResidNorm)
+    { setInitial(curSol, curResid); }
+
     /*!
      * \brief Update the internal members of the convergence criterion
      *        with the current solution.
@@ -102,6 +121,84 @@ public:
      */
     virtual void update(const Vector &curSol, const Vector &curResid) = 0;
 
+    /*!
+     * \brief Update the internal members of the convergence criterion
+     *        with the current solution.
+     *
+     * This version of the method takes the two-norm of the residual as
+     * argument. By default, the norm is ignored.
+     *
+     * \param curSol The current iterative solution of the linear system
+     *               of equations
+     * \param curResid The residual vector of the current iterative
+     *                 solution of the linear system of equations
+     * \param curResidNorm The two-norm of the residual vector
+     */
+    virtual void update(const Vector &curSol,
+                        const Vector &curResid,
+                        Scalar curResidNorm)
+    { update(curSol, curResid); }
+
+    /*!
+     * \brief Returns true if the criterion uses the two-norm of the residual
+     *        which is passed to setInitial() and update().
+     *
+     * Linear solvers may use this to avoid computing the norm if it is not
+     * required.
+     */
+    virtual bool usesResidualNorm() const
+    { return false; }
+
+    /*!
+     * \brief Returns the number of maxima over all processes which the criterion
+     *        needs to be updated.
+     *
+     * If this is non-zero, the criterion computes the process-local values of these
+     * maxima in localMaxima(). Linear solvers can then determine the global maxima
+     * using the same reduction as their scalar products and pass them to the
+     * version of update() which takes them as argument. By default, the criterion
+     * does all of its communication itself.
+     */
+    virtual int numLocalMaxima() const
+    { return 0; }
+
+    /*!
+     * \brief Compute the process-local values of the maxima required by the
+     *        criterion.
+     *
+     * \param curSol The current iterative solution of the linear system
+     *               of equations
+     * \param curResid The residual vector of the current iterative
+     *                 solution of the linear system of equations
+     * \param result The array of size numLocalMaxima() to which the values are
+     *               written
+     */
+    virtual void localMaxima(const Vector &curSol,
+                             const Vector &curResid,
+                             Scalar *result) const
+    {}
+
+    /*!
+     * \brief Update the internal members of the convergence criterion
+     *        with the current solution.
+     *
+     * This version of the method takes the two-norm of the residual and the
+     * maxima over all processes of the values computed by localMaxima() as
+     * arguments. By default, the maxima are ignored.
+     *
+     * \param curSol The current iterative solution of the linear system
+     *               of equations
+     * \param curResid The residual vector of the current iterative
+     *                 solution of the linear system of equations
+     * \param curResidNorm The two-norm of the residual vector
+     * \param globalMaxima The global maxima of the values of localMaxima()
+     */
+    virtual void update(const Vector &curSol,
+                        const Vector &curResid,
+                        Scalar curResidNorm,
+                        const Scalar *globalMaxima)
+    { update(curSol, curResid, curResidNorm); }
+
     /*!
      * \brief Returns true if and only if the convergence criterion is
      *        met.
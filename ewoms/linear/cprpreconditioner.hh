@@ -0,0 +1,338 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::CprPreconditioner
+ */
+#ifndef EWOMS_CPR_PRECONDITIONER_HH
+#define EWOMS_CPR_PRECONDITIONER_HH
+
+#include <ewoms/linear/paralleliterativebackend.hh>
+#include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <memory>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+template <class TypeTag>
+class PreconditionerWrapperCpr;
+}
+
+namespace Properties {
+//! The index of the primary variable which is used as the pressure by the CPR
+//! preconditioner
+NEW_PROP_TAG(CprPressureIndex);
+
+//! The target number of DOFs per processor for the AMG on the pressure system of the
+//! CPR preconditioner
+NEW_PROP_TAG(CprAmgCoarsenTarget);
+
+SET_INT_PROP(ParallelIterativeLinearSolver, CprAmgCoarsenTarget, 5000);
+} // namespace Properties
+
+namespace Linear {
+/*!
+ * \ingroup Linear
+ *
+ * \brief A two-stage constrained pressure residual (CPR) preconditioner.
+ *
+ * The first stage decouples the pressure from the remaining primary variables using
+ * the quasi-IMPES method, i.e., the equations of each row are combined such that the
+ * derivatives of the diagonal block with regard to all primary variables except the
+ * pressure vanish. The resulting scalar pressure system is approximately solved by a
+ * single V-cycle of an algebraic multi-grid (AMG) method. In the second stage, the
+ * full system is smoothed by an ILU(0) preconditioner.
+ *
+ * The weights and the pressure system are recomputed each time the preconditioner is
+ * set up, i.e., for every linearization. Besides the fact that the derivatives change
+ * between Newton iterations, the primary variable used as pressure may also change its
+ * meaning: for the black-oil model it is the oil pressure in most cells but the gas
+ * pressure in cells where only gas is present.
+ *
+ * Like the other preconditioners of the ParallelIterativeSolverBackend, this is a
+ * sequential preconditioner which operates on the overlapping matrix of a process,
+ * i.e., both the AMG for the pressure system and the smoother stage only see the
+ * local part of the linear system including the overlap. The backend wraps it into an
+ * OverlappingPreconditioner which takes care of the communication.
+ */
+template <class TypeTag>
+class CprPreconditioner
+    : public Dune::Preconditioner<typename GET_PROP_TYPE(TypeTag, OverlappingVector),
+                                  typename GET_PROP_TYPE(TypeTag, OverlappingVector)>
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) JacobianMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+
+    enum { numEq = GET_PROP_VALUE(TypeTag, NumEq) };
+    enum { pressureIdx = GET_PROP_VALUE(TypeTag, CprPressureIndex) };
+
+    typedef Dune::FieldVector<Scalar, numEq> EqWeights;
+    typedef Dune::FieldMatrix<Scalar, numEq, numEq> MatrixBlock;
+
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<Scalar, 1, 1> > PressureMatrix;
+    typedef Dune::BlockVector<Dune::FieldVector<Scalar, 1> > PressureVector;
+
+    typedef Dune::MatrixAdapter<PressureMatrix, PressureVector, PressureVector> PressureOperator;
+    typedef Dune::SeqSOR<PressureMatrix, PressureVector, PressureVector> PressureSmoother;
+    typedef Dune::Amg::AMG<PressureOperator, PressureVector, PressureSmoother> PressureAmg;
+
+    // the vectors of the smoother stage are only used locally, so they do not need to
+    // be able to communicate with the peer processes
+    typedef Dune::BlockVector<typename OverlappingVector::block_type> Vector;
+    typedef Dune::SeqILU0<JacobianMatrix, Vector, Vector> Smoother;
+
+public:
+    typedef OverlappingVector domain_type;
+    typedef OverlappingVector range_type;
+    typedef typename OverlappingVector::field_type field_type;
+
+    enum { category = Dune::SolverCategory::sequential };
+
+    CprPreconditioner(const OverlappingMatrix &matrix, Scalar relaxationFactor)
+        : matrix_(matrix)
+        , residual_(matrix.N())
+        , correction_(matrix.N())
+    {
+        setupPressureSystem_();
+        setupPressureAmg_();
+
+        smoother_.reset(new Smoother(matrix_, relaxationFactor));
+    }
+
+    /*!
+     * \brief Prepare the preconditioner.
+     *
+     * The iterate and the right hand side of the full system are not needed. However,
+     * the AMG allocates the vectors of its level hierarchy in pre(), so it must be
+     * called before the first V-cycle. Its arguments are only used as templates for
+     * these vectors, so the pressure vectors are passed after they have been zeroed.
+     */
+    void pre(domain_type &x, range_type &b)
+    {
+        pressureUpdate_ = 0.0;
+        pressureResidual_ = 0.0;
+        pressureAmg_->pre(pressureUpdate_, pressureResidual_);
+    }
+
+    void apply(domain_type &x, const range_type &d)
+    {
+        unsigned numRows = matrix_.N();
+
+        // first stage: restrict the residual to the pressure equation and do a
+        // V-cycle for the pressure system
+        for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            pressureResidual_[rowIdx] = weights_[rowIdx]*d[rowIdx];
+
+        pressureUpdate_ = 0.0;
+        pressureAmg_->apply(pressureUpdate_, pressureResidual_);
+
+        x = 0.0;
+        for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            x[rowIdx][pressureIdx] = pressureUpdate_[rowIdx];
+
+        // second stage: smooth the residual of the full system which remains after
+        // the pressure correction
+        residual_ = d;
+        matrix_.mmv(x, residual_);
+
+        correction_ = 0.0;
+        smoother_->apply(correction_, residual_);
+        x += correction_;
+    }
+
+    //! \brief Release the level hierarchy of the AMG which was allocated by pre().
+    void post(domain_type &x)
+    { pressureAmg_->post(pressureUpdate_); }
+
+private:
+    // compute the quasi-IMPES weights of the equations of each row and assemble the
+    // pressure system
+    void setupPressureSystem_()
+    {
+        unsigned numRows = matrix_.N();
+        weights_.resize(numRows);
+
+        EqWeights unitPressure(0.0);
+        unitPressure[pressureIdx] = 1.0;
+        for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            // the weights are chosen such that the weighted sum of the equations of
+            // the diagonal block only depends on the pressure, i.e., D^T w = e_p
+            const MatrixBlock &diagBlock = matrix_[rowIdx][rowIdx];
+            MatrixBlock diagBlockTransposed;
+            for (unsigned i = 0; i < numEq; ++i)
+                for (unsigned j = 0; j < numEq; ++j)
+                    diagBlockTransposed[i][j] = diagBlock[j][i];
+
+            try {
+                diagBlockTransposed.solve(weights_[rowIdx], unitPressure);
+            }
+            catch (const Dune::FMatrixError &) {
+                // the diagonal block is singular. fall back to simply adding up the
+                // equations
+                weights_[rowIdx] = 1.0;
+            }
+        }
+
+        // create the pressure matrix. it exhibits the same sparsity pattern as the
+        // matrix of the full system
+        pressureMatrix_.reset(new PressureMatrix(numRows, numRows,
+                                                 matrix_.nonzeroes(),
+                                                 PressureMatrix::row_wise));
+        auto createIt = pressureMatrix_->createbegin();
+        const auto &createEndIt = pressureMatrix_->createend();
+        for (; createIt != createEndIt; ++createIt) {
+            const auto &row = matrix_[createIt.index()];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt; ++colIt)
+                createIt.insert(colIt.index());
+        }
+
+        for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto &row = matrix_[rowIdx];
+            auto &pressureRow = (*pressureMatrix_)[rowIdx];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt; ++colIt) {
+                Scalar value = 0.0;
+                for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    value += weights_[rowIdx][eqIdx]*(*colIt)[eqIdx][pressureIdx];
+                pressureRow[colIt.index()] = value;
+            }
+        }
+
+        pressureResidual_.resize(numRows);
+        pressureUpdate_.resize(numRows);
+    }
+
+    void setupPressureAmg_()
+    {
+        pressureOperator_.reset(new PressureOperator(*pressureMatrix_));
+
+        typedef typename Dune::Amg::SmootherTraits<PressureSmoother>::Arguments
+        SmootherArgs;
+
+        SmootherArgs smootherArgs;
+        smootherArgs.iterations = 1;
+        smootherArgs.relaxationFactor = 1.0;
+
+        typedef Dune::Amg::
+            CoarsenCriterion<Dune::Amg::SymmetricCriterion<PressureMatrix, Dune::Amg::FirstDiagonal> >
+            CoarsenCriterion;
+        int coarsenTarget = EWOMS_GET_PARAM(TypeTag, int, CprAmgCoarsenTarget);
+        CoarsenCriterion coarsenCriterion(/*maxLevel=*/15, coarsenTarget);
+        coarsenCriterion.setDefaultValuesIsotropic(GridView::dimension,
+                                                   /*aggregateSizePerDim=*/3);
+        coarsenCriterion.setDebugLevel(0);
+        coarsenCriterion.setMinCoarsenRate(1.05);
+        coarsenCriterion.setAccumulate(Dune::Amg::atOnceAccu);
+        coarsenCriterion.setSkipIsolated(false);
+
+        pressureAmg_.reset(new PressureAmg(*pressureOperator_, coarsenCriterion,
+                                           smootherArgs));
+    }
+
+    const OverlappingMatrix &matrix_;
+
+    // the quasi-IMPES weights of the equations for each row
+    std::vector<EqWeights> weights_;
+
+    std::unique_ptr<PressureMatrix> pressureMatrix_;
+    std::unique_ptr<PressureOperator> pressureOperator_;
+    std::unique_ptr<PressureAmg> pressureAmg_;
+    PressureVector pressureResidual_;
+    PressureVector pressureUpdate_;
+
+    std::unique_ptr<Smoother> smoother_;
+    Vector residual_;
+    Vector correction_;
+};
+
+/*!
+ * \ingroup Linear
+ *
+ * \brief Makes the CPR preconditioner available to the
+ *        ParallelIterativeSolverBackend.
+ *
+ * To use it, set
+ *
+ * \code
+ * SET_TYPE_PROP(YourTypeTag, PreconditionerWrapper,
+ *               Ewoms::Linear::PreconditionerWrapperCpr<TypeTag>);
+ * \endcode
+ *
+ * The model must specify the CprPressureIndex property.
+ */
+template <class TypeTag>
+class PreconditionerWrapperCpr
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+
+public:
+    typedef Ewoms::Linear::CprPreconditioner<TypeTag> SequentialPreconditioner;
+
+    PreconditionerWrapperCpr()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the "
+                             "preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, CprAmgCoarsenTarget,
+                             "The coarsening target for the agglomerations of the "
+                             "AMG used for the pressure system of the CPR "
+                             "preconditioner");
+    }
+
+    void prepare(OverlappingMatrix &matrix)
+    {
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        seqPreCond_ = new SequentialPreconditioner(matrix, relaxationFactor);
+    }
+
+    SequentialPreconditioner &get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    { delete seqPreCond_; }
+
+private:
+    SequentialPreconditioner *seqPreCond_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
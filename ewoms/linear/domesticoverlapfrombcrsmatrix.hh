@@ -28,15 +28,19 @@
 #define EWOMS_DOMESTIC_OVERLAP_FROM_BCRS_MATRIX_HH
 
 #include "foreignoverlapfrombcrsmatrix.hh"
+#include "overlapexchangeplan.hh"
 #include "blacklist.hh"
 #include "globalindices.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/timer.hh>
 
 #include <algorithm>
 #include <limits>
 #include <set>
 #include <map>
+#include <memory>
+#include <typeindex>
 #include <vector>
 
 namespace Ewoms {
@@ -79,13 +83,41 @@ public:
         MPI_Comm_size(MPI_COMM_WORLD, &worldSize_);
 #endif // HAVE_MPI
 
+        Ewoms::Timer setupTimer;
+        setupTimer.start();
+
         buildDomesticOverlap_();
         updateMasterRanks_();
         blackList_.updateNativeToDomesticMap(*this);
+        updateRowClassification_();
 
         setupDebugMapping_();
+
+        setupTime_ = setupTimer.realTimeElapsed();
     }
 
+    /*!
+     * \brief Returns the wall clock time [s] which was required to
+     *        set up the foreign overlap.
+     */
+    double foreignOverlapSetupTime() const
+    { return foreignOverlap_.setupTime(); }
+
+    /*!
+     * \brief Returns the wall clock time [s] which was required to
+     *        set up the global indices.
+     */
+    double globalIndicesSetupTime() const
+    { return globalIndices_.setupTime(); }
+
+    /*!
+     * \brief Returns the wall clock time [s] which was required to
+     *        set up the domestic overlap given the foreign overlap
+     *        and the global indices.
+     */
+    double domesticOverlapSetupTime() const
+    { return setupTime_; }
+
     void check() const
     {
 #ifndef NDEBUG
@@ -359,6 +391,27 @@ public:
         return mapInternalToExternal_(internalIdx);
     }
 
+    /*!
+     * \brief Returns the sorted list of domestic indices which are
+     *        sent to at least one peer process if a vector is
+     *        syncronized.
+     *
+     * The values of these rows must be known before the
+     * communication of a vector can be started.
+     */
+    const std::vector<Index> &sendRows() const
+    { return sendRows_; }
+
+    /*!
+     * \brief Returns the sorted list of domestic indices which are
+     *        not sent to any peer process if a vector is syncronized.
+     *
+     * The values of these rows can be computed while the
+     * communication of a vector is in progress.
+     */
+    const std::vector<Index> &interiorRows() const
+    { return interiorRows_; }
+
     /*!
      * \brief Returns number of indices which are contained in the
      *        domestic overlap with a peer.
@@ -377,6 +430,27 @@ public:
         return mapInternalToExternal_(internalIdx);
     }
 
+    /*!
+     * \brief Returns the plan to exchange the overlap rows of block vectors with a
+     *        given block type.
+     *
+     * Setting up such a plan requires to communicate with all peer processes, so it is
+     * only done the first time this method is called for a given block type. After
+     * this, all vectors which use the overlap share the plan.
+     */
+    template <class FieldVector>
+    std::shared_ptr<OverlapExchangePlan<FieldVector, DomesticOverlapFromBCRSMatrix> >
+    exchangePlan() const
+    {
+        typedef OverlapExchangePlan<FieldVector, DomesticOverlapFromBCRSMatrix> ExchangePlan;
+
+        std::shared_ptr<void> &plan = exchangePlans_[std::type_index(typeid(FieldVector))];
+        if (!plan)
+            plan = std::make_shared<ExchangePlan>(*this);
+
+        return std::static_pointer_cast<ExchangePlan>(plan);
+    }
+
 protected:
     void buildDomesticOverlap_()
     {
@@ -448,23 +522,44 @@ protected:
         }
     }
 
+    void updateRowClassification_()
+    {
+        int nDomestic = numDomestic();
+        std::vector<bool> isSendRow(nDomestic, false);
+
+        // a row needs to be sent if it is in the foreign overlap of
+        // any peer process
+        auto peerIt = peerSet_.begin();
+        const auto &peerEndIt = peerSet_.end();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            int n = foreignOverlapSize(*peerIt);
+            for (int i = 0; i < n; ++i)
+                isSendRow[foreignOverlapOffsetToDomesticIdx(*peerIt, i)] = true;
+        }
+
+        sendRows_.clear();
+        interiorRows_.clear();
+        for (int domIdx = 0; domIdx < nDomestic; ++domIdx) {
+            if (isSendRow[domIdx])
+                sendRows_.push_back(domIdx);
+            else
+                interiorRows_.push_back(domIdx);
+        }
+    }
+
     void sendIndicesToPeer_(int peerRank)
     {
 #if HAVE_MPI
         const auto &foreignOverlap = foreignOverlap_.foreignOverlapWithPeer(peerRank);
 
-        // first, send a message containing the number of additional
-        // indices stemming from the overlap (i.e. without the border
-        // indices)
+        // send a single message containing the additional indices
+        // stemming from the overlap (i.e. without the border
+        // indices). the receiver determines their number from the
+        // size of the message.
         int numIndices = foreignOverlap.size();
-        numIndicesSendBuffer_[peerRank] = new MpiBuffer<size_t>(1);
-        (*numIndicesSendBuffer_[peerRank])[0] = numIndices;
-        numIndicesSendBuffer_[peerRank]->send(peerRank);
-
-        // create MPI buffers
-        indicesSendBuffer_[peerRank] = new MpiBuffer<IndexDistanceNpeers>(numIndices);
+        auto &sendBuffer = indicesSendBuffer_[peerRank];
+        sendBuffer = std::make_shared<MpiBuffer<IndexDistanceNpeers> >(numIndices);
 
-        // then send the additional indices themselfs
         auto overlapIt = foreignOverlap.begin();
         const auto &overlapEndIt = foreignOverlap.end();
         for (int i = 0; overlapIt != overlapEndIt; ++overlapIt, ++i) {
@@ -477,34 +572,31 @@ protected:
             tmp.borderDistance = borderDistance;
             tmp.numPeers = numPeers;
 
-            (*indicesSendBuffer_[peerRank])[i] = tmp;
+            (*sendBuffer)[i] = tmp;
         }
 
-        indicesSendBuffer_[peerRank]->send(peerRank);
+        sendBuffer->send(peerRank);
 #endif // HAVE_MPI
     }
 
     void waitSendIndices_(int peerRank)
     {
-        numIndicesSendBuffer_[peerRank]->wait();
-        delete numIndicesSendBuffer_[peerRank];
-
+#if HAVE_MPI
         indicesSendBuffer_[peerRank]->wait();
-        delete indicesSendBuffer_[peerRank];
+        indicesSendBuffer_.erase(peerRank);
+#endif // HAVE_MPI
     }
 
     void receiveIndicesFromPeer_(int peerRank)
     {
 #if HAVE_MPI
-        // receive the number of additional indices
-        int numIndices = -1;
-        MpiBuffer<size_t> numIndicesRecvBuff(1);
-        numIndicesRecvBuff.receive(peerRank);
-        numIndices = numIndicesRecvBuff[0];
-
-        // receive the additional indices themselfs
-        MpiBuffer<IndexDistanceNpeers> recvBuff(numIndices);
-        recvBuff.receive(peerRank);
+        // receive the additional indices
+        MpiBuffer<IndexDistanceNpeers> recvBuff;
+        recvBuff.receiveAnySize(peerRank);
+        Index numIndices = recvBuff.size();
+
+        auto &overlapWithPeer = domesticOverlapWithPeer_[peerRank];
+        overlapWithPeer.reserve(numIndices);
         for (Index i = 0; i < numIndices; ++i) {
             Index globalIdx = recvBuff[i].index;
             BorderDistance borderDistance = recvBuff[i].borderDistance;
@@ -525,7 +617,7 @@ protected:
 
             // extend the domestic overlap
             domesticOverlapByIndex_[domesticIdx][peerRank] = borderDistance;
-            domesticOverlapWithPeer_[peerRank].push_back(domesticIdx);
+            overlapWithPeer.push_back(domesticIdx);
 
             assert(borderDistance >= 0);
             assert(globalIdx >= 0);
@@ -574,11 +666,17 @@ protected:
     OverlapByIndex domesticOverlapByIndex_;
     std::vector<BorderDistance> borderDistance_;
     std::vector<ProcessRank> masterRank_;
+    std::vector<Index> sendRows_;
+    std::vector<Index> interiorRows_;
 
-    std::map<ProcessRank, MpiBuffer<size_t> *> numIndicesSendBuffer_;
-    std::map<ProcessRank, MpiBuffer<IndexDistanceNpeers> *> indicesSendBuffer_;
+    std::map<ProcessRank, std::shared_ptr<MpiBuffer<IndexDistanceNpeers> > > indicesSendBuffer_;
     GlobalIndices globalIndices_;
     PeerSet peerSet_;
+
+    // the plans to exchange the overlap rows of vectors, one for each block type
+    mutable std::map<std::type_index, std::shared_ptr<void> > exchangePlans_;
+
+    double setupTime_;
 };
 
 } // namespace Linear
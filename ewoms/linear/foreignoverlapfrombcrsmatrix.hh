@@ -31,6 +31,7 @@
 #include "blacklist.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/timer.hh>
 
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/istl/bcrsmatrix.hh>
@@ -73,6 +74,9 @@ public:
                                  int overlapSize)
         : borderList_(borderList), blackList_(blackList)
     {
+        Ewoms::Timer setupTimer;
+        setupTimer.start();
+
         overlapSize_ = overlapSize;
 
         myRank_ = 0;
@@ -90,6 +94,7 @@ public:
 
         // calculate the set of local indices on the border (beware:
         // _not_ the native ones)
+        isLocalBorder_.resize(numLocal_, false);
         auto it = borderList.begin();
         const auto &endIt = borderList.end();
         for (; it != endIt; ++it) {
@@ -97,9 +102,13 @@ public:
             if (localIdx < 0)
                 continue;
 
-            localBorderIndices_.insert(localIdx);
+            isLocalBorder_[localIdx] = true;
         }
 
+        // create a sorted list of the border indices which allows to
+        // quickly find the index of a border index on a peer process
+        createPeerIndexLookup_();
+
         // compute the set of processes which are neighbors of the
         // local process ...
         neighborPeerSet_.update(borderList);
@@ -135,8 +144,17 @@ public:
 
         // group foreign overlap by peer process rank
         groupForeignOverlapByRank_();
+
+        setupTime_ = setupTimer.realTimeElapsed();
     }
 
+    /*!
+     * \brief Returns the wall clock time [s] which was required to
+     *        set up the foreign overlap.
+     */
+    double setupTime() const
+    { return setupTime_; }
+
     /*!
      * \brief Returns the size of the overlap region.
      */
@@ -147,7 +165,7 @@ public:
      * \brief Returns true iff a local index is a border index.
      */
     bool isBorder(Index localIdx) const
-    { return localBorderIndices_.count(localIdx) > 0; }
+    { return 0 <= localIdx && localIdx < numLocal_ && isLocalBorder_[localIdx]; }
 
     /*!
      * \brief Returns true iff a local index is a border index shared with a
@@ -373,7 +391,7 @@ protected:
 
         // find the seed list for the next overlap level using the
         // seed set for the current level
-        SeedList nextSeedList;
+        std::vector<IndexRankDist> nextSeeds;
         seedIt = seedList.begin();
         for (; seedIt != seedEndIt; ++seedIt) {
             Index nativeRowIdx = seedIt->index;
@@ -399,32 +417,25 @@ protected:
                 else if (foreignOverlapByLocalIndex_[localColIdx].count(peerRank) > 0)
                     continue;
 
-                // check whether the new index is already in the overlap
-                bool hasIndex = false;
-                typename SeedList::iterator sIt = nextSeedList.begin();
-                typename SeedList::iterator sEndIt = nextSeedList.end();
-                for (; sIt != sEndIt; ++sIt) {
-                    if (sIt->index == nativeColIdx && sIt->peerRank == peerRank) {
-                        hasIndex = true;
-                        break;
-                    }
-                }
-                if (hasIndex)
-                    continue; // we already have this index
-
                 // add the current processes to the seed list for the
                 // next overlap level
                 IndexRankDist newTuple;
                 newTuple.index = nativeColIdx;
                 newTuple.peerRank = peerRank;
                 newTuple.borderDistance = seedIt->borderDistance + 1;
-                nextSeedList.push_back(newTuple);
+                nextSeeds.push_back(newTuple);
             }
         }
 
         // clear the old seed list to save some memory
         seedList.clear();
 
+        // an (index, peer rank) pair must be contained in the seed
+        // list only once
+        removeDuplicateSeeds_(nextSeeds);
+        SeedList nextSeedList;
+        nextSeedList.insert(nextSeedList.end(), nextSeeds.begin(), nextSeeds.end());
+
         // Perform the same excercise for the next overlap distance
         extendForeignOverlap_(A, nextSeedList, borderDistance + 1, overlapSize);
     }
@@ -450,18 +461,68 @@ protected:
         numLocal_ = localToNativeIndices_.size();
     }
 
+    // create a list of the border indices which is sorted by (index,
+    // peer rank). If the border list contains the same pair multiple
+    // times, the first one is used.
+    void createPeerIndexLookup_()
+    {
+        peerIndexLookup_.assign(borderList_.begin(), borderList_.end());
+        std::stable_sort(peerIndexLookup_.begin(), peerIndexLookup_.end(),
+                         borderIndexLess_);
+    }
+
+    static bool borderIndexLess_(const BorderIndex &a, const BorderIndex &b)
+    {
+        return
+            a.localIdx < b.localIdx
+            || (a.localIdx == b.localIdx && a.peerRank < b.peerRank);
+    }
+
     Index localToPeerIdx_(Index localIdx, ProcessRank peerRank) const
     {
-        auto it = borderList_.begin();
-        const auto &endIt = borderList_.end();
-        for (; it != endIt; ++it) {
-            if (it->localIdx == localIdx && it->peerRank == peerRank)
-                return it->peerIdx;
-        }
+        BorderIndex key;
+        key.localIdx = localIdx;
+        key.peerRank = peerRank;
+        auto it = std::lower_bound(peerIndexLookup_.begin(), peerIndexLookup_.end(), key,
+                                   borderIndexLess_);
+        if (it != peerIndexLookup_.end() && it->localIdx == localIdx && it->peerRank == peerRank)
+            return it->peerIdx;
 
         return -1;
     }
 
+    // remove all but the first occurrence of each (index, peer rank)
+    // pair from a list of seeds while retaining their order
+    static void removeDuplicateSeeds_(std::vector<IndexRankDist> &seeds)
+    {
+        int n = seeds.size();
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+                         [&seeds](int a, int b)
+                         {
+                             return
+                                 seeds[a].index < seeds[b].index
+                                 || (seeds[a].index == seeds[b].index
+                                     && seeds[a].peerRank < seeds[b].peerRank);
+                         });
+
+        std::vector<unsigned char> isDuplicate(n, false);
+        for (int i = 1; i < n; ++i) {
+            const auto &prev = seeds[order[i - 1]];
+            const auto &cur = seeds[order[i]];
+            if (prev.index == cur.index && prev.peerRank == cur.peerRank)
+                isDuplicate[order[i]] = true;
+        }
+
+        int j = 0;
+        for (int i = 0; i < n; ++i)
+            if (!isDuplicate[i])
+                seeds[j++] = seeds[i];
+        seeds.resize(j);
+    }
+
     void addNonNeighborOverlapIndices_(const BCRSMatrix &A, SeedList &seedList,
                                        int borderDist)
     {
@@ -508,17 +569,13 @@ protected:
         // now borderIndices contains the lists of indices which we
         // would like to send to each neighbor. Let's create the MPI
         // buffers.
-        std::map<ProcessRank, Ewoms::MpiBuffer<int> > numIndicesSendBufs;
         std::map<ProcessRank, Ewoms::MpiBuffer<BorderIndex> > indicesSendBufs;
         auto peerIt = neighborPeerSet().begin();
         const auto &peerEndIt = neighborPeerSet().end();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank peerRank = *peerIt;
-            int numIndices = borderIndices[peerRank].size();
-            numIndicesSendBufs[peerRank].resize(1);
-            numIndicesSendBufs[peerRank][0] = numIndices;
-
             const auto &peerBorderIndices = borderIndices[peerRank];
+            int numIndices = peerBorderIndices.size();
             indicesSendBufs[peerRank].resize(numIndices);
 
             auto tmpIt = peerBorderIndices.begin();
@@ -529,32 +586,41 @@ protected:
             }
         }
 
-        // now, send all these nice buffers to our neighbors
+        // now, send all these nice buffers to our neighbors. the
+        // receiver determines the number of indices from the size of
+        // the message.
         peerIt = neighborPeerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank neighborPeer = *peerIt;
-            numIndicesSendBufs[neighborPeer].send(neighborPeer);
             indicesSendBufs[neighborPeer].send(neighborPeer);
         }
 
+        // the (index, peer rank) pairs which are already in the seed
+        // list
+        std::vector<IndexRank> seedKeys;
+        auto seedIt = seedList.begin();
+        const auto &seedEndIt = seedList.end();
+        for (; seedIt != seedEndIt; ++seedIt) {
+            IndexRank tmp;
+            tmp.index = seedIt->index;
+            tmp.rank = seedIt->peerRank;
+            seedKeys.push_back(tmp);
+        }
+        auto indexRankLess = [](const IndexRank &a, const IndexRank &b)
+            { return a.index < b.index || (a.index == b.index && a.rank < b.rank); };
+        std::sort(seedKeys.begin(), seedKeys.end(), indexRankLess);
+
         // receive all data from the neighbors
-        std::map<ProcessRank, MpiBuffer<int> > numIndicesRcvBufs;
-        std::map<ProcessRank, MpiBuffer<BorderIndex> > indicesRcvBufs;
+        std::vector<IndexRankDist> newSeeds;
         peerIt = neighborPeerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank neighborPeer = *peerIt;
-            auto &numIndicesRcvBuf = numIndicesRcvBufs[neighborPeer];
-            auto &indicesRcvBuf = indicesRcvBufs[neighborPeer];
-
-            numIndicesRcvBuf.resize(1);
-            numIndicesRcvBuf.receive(neighborPeer);
-            int numIndices = numIndicesRcvBufs[neighborPeer][0];
-            indicesRcvBuf.resize(numIndices);
-            indicesRcvBuf.receive(neighborPeer);
+            MpiBuffer<BorderIndex> indicesRcvBuf;
+            indicesRcvBuf.receiveAnySize(neighborPeer);
+            int numIndices = indicesRcvBuf.size();
 
             // filter out all indices which are already in the peer
-            // processes' overlap and add them to the seed list. also
-            // extend the set of peer processes.
+            // processes' overlap or in the seed list.
             for (int i = 0; i < numIndices; ++i) {
                 // swap the local and the peer indices, because they were
                 // created with the point view of the sender
@@ -571,34 +637,32 @@ protected:
                     continue;
 
                 // make sure the index is not already in the seed list
-                bool inSeedList = false;
-                auto seedIt = seedList.begin();
-                const auto &seedEndIt = seedList.end();
-                for (; seedIt != seedEndIt; ++seedIt) {
-                    if (seedIt->index == localIdx && seedIt->peerRank == peerRank) {
-                        inSeedList = true;
-                        break;
-                    }
-                }
-                if (inSeedList)
+                IndexRank key;
+                key.index = localIdx;
+                key.rank = peerRank;
+                if (std::binary_search(seedKeys.begin(), seedKeys.end(), key, indexRankLess))
                     continue;
 
                 IndexRankDist seedEntry;
                 seedEntry.index = localIdx;
                 seedEntry.peerRank = peerRank;
                 seedEntry.borderDistance = borderDist;
-                seedList.push_back(seedEntry);
-
-                // update the peer set
-                peerSet_.insert(peerRank);
+                newSeeds.push_back(seedEntry);
             }
         }
 
+        // add the new indices to the seed list and extend the set of
+        // peer processes.
+        removeDuplicateSeeds_(newSeeds);
+        for (unsigned i = 0; i < newSeeds.size(); ++i) {
+            seedList.push_back(newSeeds[i]);
+            peerSet_.insert(newSeeds[i].peerRank);
+        }
+
         // make sure all data was send
         peerIt = neighborPeerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank neighborPeer = *peerIt;
-            numIndicesSendBufs[neighborPeer].wait();
             indicesSendBufs[neighborPeer].wait();
         }
 #endif // HAVE_MPI
@@ -674,9 +738,12 @@ protected:
     // index
     std::vector<ProcessRank> masterRank_;
 
-    // set of all local indices which are on the border of some remote
-    // process
-    std::set<Index> localBorderIndices_;
+    // specifies for each local index whether it is on the border of
+    // some remote process
+    std::vector<unsigned char> isLocalBorder_;
+
+    // the border list sorted by (index, peer rank)
+    std::vector<BorderIndex> peerIndexLookup_;
 
     // stores the set of process ranks which are in the overlap for a
     // given row index "owned" by the current rank. The second value
@@ -697,6 +764,9 @@ protected:
 
     // the MPI rank of the local process
     ProcessRank myRank_;
+
+    // the time required to set up the foreign overlap
+    double setupTime_;
 };
 
 } // namespace Linear
@@ -0,0 +1,133 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::FusedScalarProduct
+ */
+#ifndef EWOMS_FUSED_SCALAR_PRODUCT_HH
+#define EWOMS_FUSED_SCALAR_PRODUCT_HH
+
+#include "vectorkernels.hh"
+
+#include <dune/istl/scalarproducts.hh>
+
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief A scalar product which is able to compute several scalar products at once.
+ *
+ * In parallel computations, each scalar product requires a global reduction whose
+ * latency often dominates the run time of the linear solver if many processes are
+ * used. Scalar products derived from this class compute all scalar products which are
+ * passed to dotStart() using a single reduction. This reduction may be non-blocking,
+ * i.e., its results are only available after reduceFinish() has been called. This
+ * allows linear solvers to do other work while the reduction is in flight.
+ *
+ * Linear solvers which compute the local parts of scalar products themselves, e.g.,
+ * using the fused kernels of VectorKernels, only consider the rows selected by
+ * ownerMask() and pass the local sums to reduceStart(). Maxima over all processes,
+ * e.g., the weighted maximum norm of a convergence criterion, can be computed by the
+ * same reduction.
+ *
+ * The default implementation considers all rows and does not communicate.
+ */
+template <class Vector>
+class FusedScalarProduct : public Dune::ScalarProduct<Vector>
+{
+public:
+    typedef typename Vector::field_type field_type;
+
+    /*!
+     * \brief Returns a mask which specifies for each row of the vectors whether it is
+     *        considered by the local part of the scalar product.
+     *
+     * A null pointer means that all rows are considered.
+     */
+    virtual const unsigned char *ownerMask() const
+    { return 0; }
+
+    /*!
+     * \brief Start computing the scalar products of pairs of vectors.
+     *
+     * The results must not be accessed until reduceFinish() has been called.
+     *
+     * \param x The first vector of each scalar product
+     * \param y The second vector of each scalar product
+     * \param result The array to which the results are written
+     * \param numProducts The number of scalar products to be computed
+     */
+    void dotStart(const Vector *const *x,
+                  const Vector *const *y,
+                  field_type *result,
+                  int numProducts)
+    {
+        localSums_.resize(numProducts);
+        VectorKernels::dots(x, y, localSums_.data(), numProducts, ownerMask());
+        reduceStart(localSums_.data(), result, numProducts);
+    }
+
+    /*!
+     * \brief Start summing up the local parts of scalar products over all processes.
+     *
+     * Optionally, the maxima of some local values over all processes are determined
+     * by the same reduction. The results must not be accessed until reduceFinish()
+     * has been called.
+     *
+     * \param localSums The local parts of the scalar products
+     * \param result The array to which the global sums are written
+     * \param numSums The number of sums
+     * \param localMaxima The local values of which the global maxima are determined
+     * \param maxResult The array to which the global maxima are written
+     * \param numMaxima The number of maxima
+     */
+    virtual void reduceStart(const field_type *localSums,
+                             field_type *result,
+                             int numSums,
+                             const field_type *localMaxima = 0,
+                             field_type *maxResult = 0,
+                             int numMaxima = 0)
+    {
+        for (int i = 0; i < numSums; ++i)
+            result[i] = localSums[i];
+        for (int i = 0; i < numMaxima; ++i)
+            maxResult[i] = localMaxima[i];
+    }
+
+    /*!
+     * \brief Wait until the results of the reduction started by the last call to
+     *        dotStart() or reduceStart() are available.
+     */
+    virtual void reduceFinish()
+    {}
+
+private:
+    std::vector<field_type> localSums_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
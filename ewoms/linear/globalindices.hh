@@ -35,6 +35,8 @@
 #include <algorithm>
 #include <set>
 #include <map>
+#include <memory>
+#include <vector>
 #include <iostream>
 #include <tuple>
 
@@ -44,6 +46,9 @@
 
 #include "overlaptypes.hh"
 
+#include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/timer.hh>
+
 namespace Ewoms {
 namespace Linear {
 /*!
@@ -58,7 +63,7 @@ class GlobalIndices
     {}
 
     typedef std::map<Index, Index> GlobalToDomesticMap;
-    typedef std::map<Index, Index> DomesticToGlobalMap;
+    typedef std::vector<Index> DomesticToGlobalMap;
 
 public:
     GlobalIndices(const ForeignOverlap &foreignOverlap)
@@ -80,17 +85,28 @@ public:
         // calculate the domestic overlap (i.e. all overlap indices in
         // foreign processes which the current process overlaps.)
         // This requires communication via MPI.
+        Ewoms::Timer setupTimer;
+        setupTimer.start();
         buildGlobalIndices_();
+        setupTime_ = setupTimer.realTimeElapsed();
     }
 
+    /*!
+     * \brief Returns the wall clock time [s] which was required to
+     *        set up the global indices of the local indices.
+     */
+    double setupTime() const
+    { return setupTime_; }
+
     /*!
      * \brief Converts a domestic index to a global one.
      */
     int domesticToGlobal(int domesticIdx) const
     {
-        assert(domesticToGlobal_.find(domesticIdx) != domesticToGlobal_.end());
+        assert(0 <= domesticIdx && domesticIdx < int(domesticToGlobal_.size()));
+        assert(domesticToGlobal_[domesticIdx] >= 0);
 
-        return domesticToGlobal_.find(domesticIdx)->second;
+        return domesticToGlobal_[domesticIdx];
     }
 
     /*!
@@ -127,53 +143,12 @@ public:
      */
     void addIndex(int domesticIdx, int globalIdx)
     {
+        if (domesticIdx >= int(domesticToGlobal_.size()))
+            domesticToGlobal_.resize(domesticIdx + 1, -1);
+
         domesticToGlobal_[domesticIdx] = globalIdx;
         globalToDomestic_[globalIdx] = domesticIdx;
-        numDomestic_ = domesticToGlobal_.size();
-
-        assert(domesticToGlobal_.size() == globalToDomestic_.size());
-    }
-
-    /*!
-     * \brief Send a border index to a remote process.
-     */
-    void sendBorderIndex(int peerRank, int domesticIdx, int peerLocalIdx)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex sendBuf;
-        sendBuf.peerIdx = peerLocalIdx;
-        sendBuf.globalIdx = domesticToGlobal(domesticIdx);
-        MPI_Send(&sendBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 peerRank,                     // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD);              // communicator
-#endif
-    }
-
-    /*!
-     * \brief Receive an index on the border from a remote
-     *        process and add it the translation maps.
-     */
-    void receiveBorderIndex(int peerRank)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex recvBuf;
-        MPI_Recv(&recvBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 peerRank,                     // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD,               // communicator
-                 MPI_STATUS_IGNORE);           // status
-
-        int domesticIdx = foreignOverlap_.nativeToLocal(recvBuf.peerIdx);
-        if (domesticIdx >= 0) {
-            int globalIdx = recvBuf.globalIdx;
-            addIndex(domesticIdx, globalIdx);
-        }
-#endif // HAVE_MPI
+        numDomestic_ = globalToDomestic_.size();
     }
 
     /*!
@@ -209,82 +184,63 @@ protected:
 #endif
 
 #if HAVE_MPI
-        if (myRank_ == 0) {
-            // the first rank starts at index zero
-            domesticOffset_ = 0;
-        }
-        else {
-            // all other ranks retrieve their offset from the next
-            // lower rank
-            MPI_Recv(&domesticOffset_, // buffer
-                     1,                // count
-                     MPI_INT,          // data type
-                     myRank_ - 1,      // peer rank
-                     0,                // tag
-                     MPI_COMM_WORLD,   // communicator
-                     MPI_STATUS_IGNORE);
-        }
-
         // create maps for all indices for which the current process
         // is the master
         int numMaster = 0;
+        for (int i = 0; i < foreignOverlap_.numLocal(); ++i)
+            if (foreignOverlap_.iAmMasterOf(i))
+                ++numMaster;
+
+        // the offset of the current rank is the number of master
+        // indices of all lower ranks
+        MPI_Exscan(&numMaster,      // send buffer
+                   &domesticOffset_, // receive buffer
+                   1,               // count
+                   MPI_INT,         // data type
+                   MPI_SUM,         // operation
+                   MPI_COMM_WORLD); // communicator
+        if (myRank_ == 0)
+            // the result of MPI_Exscan is undefined for the first rank
+            domesticOffset_ = 0;
+
+        domesticToGlobal_.reserve(foreignOverlap_.numLocal());
+        int masterIdx = 0;
         for (int i = 0; i < foreignOverlap_.numLocal(); ++i) {
             if (!foreignOverlap_.iAmMasterOf(i))
                 continue;
 
-            addIndex(i, domesticOffset_ + numMaster);
-            ++numMaster;
-        }
-
-        if (myRank_ < mpiSize_ - 1) {
-            // send the domestic offset plus the number of master
-            // indices to the process which is one rank higher
-            int tmp = domesticOffset_ + numMaster;
-            MPI_Send(&tmp,            // buff
-                     1,               // count
-                     MPI_INT,         // data type
-                     myRank_ + 1,     // peer rank
-                     0,               // tag
-                     MPI_COMM_WORLD); // communicator
+            addIndex(i, domesticOffset_ + masterIdx);
+            ++masterIdx;
         }
 
-        typename PeerSet::const_iterator peerIt;
+        // exchange the global indices of the border indices with all
+        // peers at once. since the master of a border index always
+        // knows its global index, there are no dependencies between
+        // the messages.
+        std::vector<std::shared_ptr<MpiBuffer<PeerIndexGlobalIndex> > > sendBuffs;
+        typename PeerSet::const_iterator peerIt = peerSet_().begin();
         typename PeerSet::const_iterator peerEndIt = peerSet_().end();
-        // receive the border indices from the lower ranks
-        peerIt = peerSet_().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                receiveBorderFrom_(*peerIt);
+            sendBuffs.push_back(createBorderSendBuffer_(*peerIt));
+            sendBuffs.back()->send(*peerIt);
         }
 
-        // send the border indices to the higher ranks
         peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                sendBorderTo_(*peerIt);
-        }
+        for (; peerIt != peerEndIt; ++peerIt)
+            receiveBorderFrom_(*peerIt);
 
-        // receive the border indices from the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                receiveBorderFrom_(*peerIt);
-        }
-
-        // send the border indices to the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                sendBorderTo_(*peerIt);
-        }
+        for (unsigned i = 0; i < sendBuffs.size(); ++i)
+            sendBuffs[i]->wait();
 #endif // HAVE_MPI
     }
 
-    void sendBorderTo_(ProcessRank peerRank)
+    // create a buffer which contains the (local index on the peer,
+    // global index) pairs of all border indices shared with a given
+    // peer for which the local process is the master
+    std::shared_ptr<MpiBuffer<PeerIndexGlobalIndex> > createBorderSendBuffer_(ProcessRank peerRank)
     {
-#if HAVE_MPI
-        // send (local index on myRank, global index) pairs to the
-        // peers
+        std::vector<PeerIndexGlobalIndex> borderIndices;
+
         BorderList::const_iterator borderIt = borderList_().begin();
         BorderList::const_iterator borderEndIt = borderList_().end();
         for (; borderIt != borderEndIt; ++borderIt) {
@@ -294,32 +250,33 @@ protected:
                 continue;
 
             int localIdx = foreignOverlap_.nativeToLocal(borderIt->localIdx);
-            Index peerIdx = borderIt->peerIdx;
             assert(localIdx >= 0);
             if (foreignOverlap_.iAmMasterOf(localIdx)) {
-                sendBorderIndex(borderPeer, localIdx, peerIdx);
+                PeerIndexGlobalIndex tmp;
+                tmp.peerIdx = borderIt->peerIdx;
+                tmp.globalIdx = domesticToGlobal(localIdx);
+                borderIndices.push_back(tmp);
             }
         }
-#endif // HAVE_MPI
+
+        auto buff = std::make_shared<MpiBuffer<PeerIndexGlobalIndex> >(borderIndices.size());
+        for (unsigned i = 0; i < borderIndices.size(); ++i)
+            (*buff)[i] = borderIndices[i];
+        return buff;
     }
 
     void receiveBorderFrom_(ProcessRank peerRank)
     {
 #if HAVE_MPI
-        // retrieve the global indices for which we are not master
-        // from the processes with lower rank
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
-        for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            int borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
-                continue;
-
-            int nativeIdx = borderIt->localIdx;
-            int localIdx = foreignOverlap_.nativeToLocal(nativeIdx);
-            if (localIdx >= 0 && foreignOverlap_.masterRank(localIdx) == borderPeer)
-                receiveBorderIndex(borderPeer);
+        // retrieve the global indices for which the peer is the
+        // master
+        MpiBuffer<PeerIndexGlobalIndex> recvBuff;
+        recvBuff.receiveAnySize(peerRank);
+
+        for (unsigned i = 0; i < recvBuff.size(); ++i) {
+            int localIdx = foreignOverlap_.nativeToLocal(recvBuff[i].peerIdx);
+            if (localIdx >= 0)
+                addIndex(localIdx, recvBuff[i].globalIdx);
         }
 #endif // HAVE_MPI
     }
@@ -339,6 +296,8 @@ protected:
 
     GlobalToDomesticMap globalToDomestic_;
     DomesticToGlobalMap domesticToGlobal_;
+
+    double setupTime_;
 };
 
 } // namespace Linear
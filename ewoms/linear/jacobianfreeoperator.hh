@@ -0,0 +1,124 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::JacobianFreeOperator
+ */
+#ifndef EWOMS_JACOBIAN_FREE_OPERATOR_HH
+#define EWOMS_JACOBIAN_FREE_OPERATOR_HH
+
+#include <ewoms/common/propertysystem.hh>
+
+#include <dune/istl/operators.hh>
+
+namespace Ewoms {
+namespace Properties {
+NEW_PROP_TAG(Simulator);
+NEW_PROP_TAG(GlobalEqVector);
+NEW_PROP_TAG(Overlap);
+NEW_PROP_TAG(OverlappingVector);
+}
+
+namespace Linear {
+
+/*!
+ * \ingroup Linear
+ *
+ * \brief An overlap aware linear operator which applies the Jacobian matrix of the
+ *        model without accessing the assembled matrix.
+ *
+ * The product of the Jacobian with a vector \f$v\f$ is the directional derivative of
+ * the residual at the current solution in the direction of \f$v\f$. It is calculated
+ * element by element from the derivatives provided by the local linearizer (see
+ * FvBaseLinearizer::evalLocalJacobianProduct()), so it is exact if automatic
+ * differentiation is used. The contributions to the border rows are then summed up
+ * using the overlap of the linear solver, i.e., the same communication which is
+ * required to apply an assembled overlapping matrix. The solution of the model is not
+ * modified.
+ */
+template <class TypeTag>
+class JacobianFreeOperator
+    : public Dune::LinearOperator<typename GET_PROP_TYPE(TypeTag, OverlappingVector),
+                                  typename GET_PROP_TYPE(TypeTag, OverlappingVector)>
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, GlobalEqVector) GlobalEqVector;
+    typedef typename GET_PROP_TYPE(TypeTag, Overlap) Overlap;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+
+public:
+    //! export types
+    typedef OverlappingVector domain_type;
+    typedef OverlappingVector range_type;
+    typedef typename OverlappingVector::field_type field_type;
+
+    enum { category = Dune::SolverCategory::overlapping };
+
+    JacobianFreeOperator(Simulator &simulator, const Overlap &overlap)
+        : simulator_(simulator)
+        , overlap_(overlap)
+    { }
+
+    //! apply operator to x:  \f$ y = A(x) \f$
+    virtual void apply(const OverlappingVector &x, OverlappingVector &y) const
+    {
+        // the values of the overlap rows of the direction are not necessarily
+        // consistent with the ones of their master processes, but the stencils of the
+        // border elements refer to them. thus, they are synchronized first
+        overlappingDirection_ = x;
+        overlappingDirection_.sync();
+        overlappingDirection_.assignTo(direction_);
+
+        simulator_.model().linearizer().evalLocalJacobianProduct(direction_, product_);
+
+        // the contributions of the processes to the border rows are added up the same
+        // way as for the right hand side of the linear system
+        y.assignAddBorder(product_);
+    }
+
+    //! apply operator to x, scale and add:  \f$ y = y + \alpha A(x) \f$
+    virtual void applyscaleadd(field_type alpha,
+                               const OverlappingVector &x,
+                               OverlappingVector &y) const
+    {
+        OverlappingVector tmp(y);
+        apply(x, tmp);
+        y.axpy(alpha, tmp);
+    }
+
+    const Overlap &overlap() const
+    { return overlap_; }
+
+private:
+    Simulator &simulator_;
+    const Overlap &overlap_;
+
+    mutable OverlappingVector overlappingDirection_;
+    mutable GlobalEqVector direction_;
+    mutable GlobalEqVector product_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
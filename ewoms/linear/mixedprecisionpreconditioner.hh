@@ -0,0 +1,214 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::MixedPrecisionPreconditioner
+ */
+#ifndef EWOMS_MIXED_PRECISION_PRECONDITIONER_HH
+#define EWOMS_MIXED_PRECISION_PRECONDITIONER_HH
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <memory>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief Specifies whether a preconditioner stores its own copy of the matrix.
+ *
+ * If this is the case, the low precision matrix of MixedPrecisionPreconditioner can be
+ * released after the preconditioner has been set up. By default, it is assumed that
+ * the preconditioner references the matrix (like e.g., Dune::SeqSSOR does).
+ */
+template <template <class, class, class, int> class PreCond>
+struct PreconditionerCopiesMatrix
+{ static const bool value = false; };
+
+//! The incomplete LU factorizations are stored separately from the matrix
+template <>
+struct PreconditionerCopiesMatrix<Dune::SeqILU0>
+{ static const bool value = true; };
+
+template <>
+struct PreconditionerCopiesMatrix<Dune::SeqILUn>
+{ static const bool value = true; };
+
+/*!
+ * \brief A sequential preconditioner which is set up and applied using a lower
+ *        precision than the one of the linear system of equations.
+ *
+ * The matrix is copied to a matrix of the lower precision when the preconditioner is
+ * created. This copy is released again if the low precision preconditioner stores its
+ * own copy of the matrix (see PreconditionerCopiesMatrix). When the preconditioner is
+ * applied, the defect is converted to the lower precision and the correction is
+ * converted back. Since applying a preconditioner is usually limited by the memory
+ * bandwidth, this is faster and consumes less memory than a preconditioner which uses
+ * the full precision.
+ *
+ * \tparam Matrix The type of the matrix of the linear system
+ * \tparam DomainVector The type of the vectors of the linear system
+ * \tparam RangeVector The type of the right hand side of the linear system
+ * \tparam LowPrecisionPreCond The template of the preconditioner which is applied in
+ *                             low precision (e.g., Dune::SeqILU0)
+ * \tparam LowPrecisionScalar The floating point type of the low precision
+ */
+template <class Matrix,
+          class DomainVector,
+          class RangeVector,
+          template <class, class, class, int> class LowPrecisionPreCond,
+          class LowPrecisionScalar = float>
+class MixedPrecisionPreconditioner
+    : public Dune::Preconditioner<DomainVector, RangeVector>
+{
+    typedef typename Matrix::block_type MatrixBlock;
+    typedef Dune::FieldMatrix<LowPrecisionScalar,
+                              MatrixBlock::rows,
+                              MatrixBlock::cols> LowPrecisionBlock;
+    typedef Dune::BCRSMatrix<LowPrecisionBlock> LowPrecisionMatrix;
+
+    typedef Dune::FieldVector<LowPrecisionScalar,
+                              DomainVector::block_type::dimension> LowPrecisionVectorBlock;
+    typedef Dune::BlockVector<LowPrecisionVectorBlock> LowPrecisionVector;
+
+    typedef LowPrecisionPreCond<LowPrecisionMatrix,
+                                LowPrecisionVector,
+                                LowPrecisionVector,
+                                /*blockLevel=*/1> LowPrecisionPreconditioner;
+
+public:
+    typedef DomainVector domain_type;
+    typedef RangeVector range_type;
+    typedef typename DomainVector::field_type field_type;
+
+    enum { category = Dune::SolverCategory::sequential };
+
+    /*!
+     * \brief Create the preconditioner.
+     *
+     * \param matrix The matrix of the linear system
+     * \param args The arguments passed to the constructor of the low precision
+     *             preconditioner after the matrix
+     */
+    template <class ...Args>
+    MixedPrecisionPreconditioner(const Matrix &matrix, Args... args)
+        : x_(matrix.M())
+        , d_(matrix.N())
+    {
+        copyMatrix_(matrix);
+        preCond_.reset(new LowPrecisionPreconditioner(*matrix_, args...));
+
+        // the low precision matrix is only required if the preconditioner does not
+        // have its own copy of it
+        if (PreconditionerCopiesMatrix<LowPrecisionPreCond>::value)
+            matrix_.reset();
+    }
+
+    /*!
+     * \brief Prepare the low precision preconditioner.
+     *
+     * The low precision preconditioner only sees scratch copies of the vectors. They
+     * are not copied back because this would round the iterate and the right hand side
+     * of the linear solver to the low precision.
+     */
+    void pre(domain_type &x, range_type &b)
+    {
+        convert_(x_, x);
+        convert_(d_, b);
+        preCond_->pre(x_, d_);
+    }
+
+    void apply(domain_type &x, const range_type &d)
+    {
+        convert_(d_, d);
+        x_ = 0.0;
+        preCond_->apply(x_, d_);
+        convert_(x, x_);
+    }
+
+    /*!
+     * \brief Clean up the low precision preconditioner.
+     *
+     * Like for pre(), the iterate is not modified.
+     */
+    void post(domain_type &x)
+    {
+        convert_(x_, x);
+        preCond_->post(x_);
+    }
+
+private:
+    void copyMatrix_(const Matrix &matrix)
+    {
+        // create a matrix which exhibits the same sparsity pattern
+        matrix_.reset(new LowPrecisionMatrix(matrix.N(), matrix.M(),
+                                             matrix.nonzeroes(),
+                                             LowPrecisionMatrix::row_wise));
+        auto createIt = matrix_->createbegin();
+        const auto &createEndIt = matrix_->createend();
+        for (; createIt != createEndIt; ++createIt) {
+            const auto &row = matrix[createIt.index()];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt; ++colIt)
+                createIt.insert(colIt.index());
+        }
+
+        // copy the entries
+        for (unsigned rowIdx = 0; rowIdx < matrix.N(); ++rowIdx) {
+            const auto &row = matrix[rowIdx];
+            auto &lowPrecisionRow = (*matrix_)[rowIdx];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt; ++colIt) {
+                const MatrixBlock &block = *colIt;
+                LowPrecisionBlock &lowPrecisionBlock = lowPrecisionRow[colIt.index()];
+                for (unsigned i = 0; i < MatrixBlock::rows; ++i)
+                    for (unsigned j = 0; j < MatrixBlock::cols; ++j)
+                        lowPrecisionBlock[i][j] = static_cast<LowPrecisionScalar>(block[i][j]);
+            }
+        }
+    }
+
+    template <class DestVector, class SrcVector>
+    static void convert_(DestVector &dest, const SrcVector &src)
+    {
+        typedef typename DestVector::field_type DestScalar;
+        for (unsigned i = 0; i < src.size(); ++i)
+            for (unsigned j = 0; j < SrcVector::block_type::dimension; ++j)
+                dest[i][j] = static_cast<DestScalar>(src[i][j]);
+    }
+
+    std::unique_ptr<LowPrecisionMatrix> matrix_;
+    std::unique_ptr<LowPrecisionPreconditioner> preCond_;
+
+    LowPrecisionVector x_;
+    LowPrecisionVector d_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
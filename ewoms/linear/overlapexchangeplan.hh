@@ -0,0 +1,317 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::OverlapExchangePlan
+ */
+#ifndef EWOMS_OVERLAP_EXCHANGE_PLAN_HH
+#define EWOMS_OVERLAP_EXCHANGE_PLAN_HH
+
+#include "overlaptypes.hh"
+
+#include <ewoms/parallel/mpibuffer.hh>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief Stores everything which is required to exchange the overlap
+ *        rows of block vectors with the peer processes.
+ *
+ * The plan is set up once for a given overlap. It stores the peer
+ * ranks and the rows which need to be sent to and received from each
+ * peer in contiguous arrays and uses persistent MPI requests on a
+ * dedicated communicator. An exchange thus only consists of packing
+ * the send buffer, starting the requests, waiting for their
+ * completion and unpacking the receive buffer.
+ *
+ * The plan is shared by all vectors which use the same overlap (see
+ * DomesticOverlapFromBCRSMatrix::exchangePlan()), so only one exchange
+ * can be in progress for all of them at any given time.
+ */
+template <class FieldVector, class Overlap>
+class OverlapExchangePlan
+{
+    OverlapExchangePlan(const OverlapExchangePlan &)
+    {}
+
+public:
+    /*!
+     * \brief Specifies how the values received from the peer
+     *        processes are merged into the local vector.
+     */
+    enum ReceiveMode {
+        //! Take the values of all rows from their master process
+        ReceiveFromMaster,
+        //! Add the values of all rows
+        ReceiveAdd,
+        //! Add the values of border rows, take the values of the
+        //! remaining rows from the peer
+        ReceiveAddBorder
+    };
+
+    OverlapExchangePlan(const Overlap &overlap)
+        : exchangePending_(false)
+    {
+#if HAVE_MPI
+        MPI_Comm_dup(MPI_COMM_WORLD, &comm_);
+#endif // HAVE_MPI
+
+        const PeerSet &peerSet = overlap.peerSet();
+        peerRanks_.assign(peerSet.begin(), peerSet.end());
+
+        buildIndices_(overlap);
+        createRequests_();
+    }
+
+    ~OverlapExchangePlan()
+    {
+#if HAVE_MPI
+        for (unsigned i = 0; i < requests_.size(); ++i)
+            MPI_Request_free(&requests_[i]);
+        MPI_Comm_free(&comm_);
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Returns the number of peer processes.
+     */
+    int numPeers() const
+    { return peerRanks_.size(); }
+
+    /*!
+     * \brief Pack the values of a vector which are required by the
+     *        peer processes and start the communication.
+     *
+     * The exchange of the previous call must have been completed using
+     * finish() because the buffers and the requests are reused.
+     */
+    template <class BlockVector>
+    void start(const BlockVector &vec)
+    {
+        assert(!exchangePending_);
+        exchangePending_ = true;
+
+#if HAVE_MPI
+        if (peerRanks_.empty())
+            return;
+
+        int nPeers = peerRanks_.size();
+
+        // post the receive operations before sending anything. this
+        // avoids that incoming messages need to be buffered by the
+        // MPI implementation.
+        MPI_Startall(nPeers, &requests_[0]);
+
+        int numSend = sendIndices_.size();
+        for (int i = 0; i < numSend; ++i)
+            sendValues_[i] = vec[sendIndices_[i]];
+
+        MPI_Startall(nPeers, &requests_[nPeers]);
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Wait until the communication started by start() is
+     *        completed and merge the received values into a vector.
+     */
+    template <class BlockVector>
+    void finish(BlockVector &vec, ReceiveMode mode)
+    {
+        assert(exchangePending_);
+        exchangePending_ = false;
+
+#if HAVE_MPI
+        if (peerRanks_.empty())
+            return;
+
+        int nPeers = peerRanks_.size();
+        MPI_Waitall(nPeers, &requests_[0], MPI_STATUSES_IGNORE);
+
+        // the received values are processed in the order of the peer
+        // ranks so that the result does not depend on the order in
+        // which the messages arrive
+        int numRecv = recvIndices_.size();
+        switch (mode) {
+        case ReceiveFromMaster:
+            for (int j = 0; j < numRecv; ++j)
+                if (recvFromMaster_[j])
+                    vec[recvIndices_[j]] = recvValues_[j];
+            break;
+
+        case ReceiveAdd:
+            for (int j = 0; j < numRecv; ++j)
+                vec[recvIndices_[j]] += recvValues_[j];
+            break;
+
+        case ReceiveAddBorder:
+            for (int j = 0; j < numRecv; ++j) {
+                if (recvIsBorder_[j])
+                    vec[recvIndices_[j]] += recvValues_[j];
+                else
+                    vec[recvIndices_[j]] = recvValues_[j];
+            }
+            break;
+        }
+
+        MPI_Waitall(nPeers, &requests_[nPeers], MPI_STATUSES_IGNORE);
+#endif // HAVE_MPI
+    }
+
+private:
+    void buildIndices_(const Overlap &overlap)
+    {
+        int nPeers = peerRanks_.size();
+        sendOffsets_.resize(nPeers + 1);
+        recvOffsets_.resize(nPeers + 1);
+
+        // the rows which are sent to a peer are given by its foreign
+        // overlap
+        sendOffsets_[0] = 0;
+        for (int peerIdx = 0; peerIdx < nPeers; ++peerIdx) {
+            int peerRank = peerRanks_[peerIdx];
+            int numEntries = overlap.foreignOverlapSize(peerRank);
+            for (int i = 0; i < numEntries; ++i)
+                sendIndices_.push_back(overlap.foreignOverlapOffsetToDomesticIdx(peerRank, i));
+            sendOffsets_[peerIdx + 1] = sendIndices_.size();
+        }
+        sendValues_.resize(sendIndices_.size());
+
+        recvOffsets_[0] = 0;
+#if HAVE_MPI
+        // send the global indices of the rows to the peers
+        std::vector<std::shared_ptr<MpiBuffer<int> > > numIndicesSendBuff(nPeers);
+        std::vector<std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff(nPeers);
+        for (int peerIdx = 0; peerIdx < nPeers; ++peerIdx) {
+            int peerRank = peerRanks_[peerIdx];
+            int numEntries = sendOffsets_[peerIdx + 1] - sendOffsets_[peerIdx];
+
+            numIndicesSendBuff[peerIdx] = std::make_shared<MpiBuffer<int> >(1);
+            indicesSendBuff[peerIdx] = std::make_shared<MpiBuffer<Index> >(numEntries);
+
+            MpiBuffer<Index> &indicesBuff = *indicesSendBuff[peerIdx];
+            for (int i = 0; i < numEntries; ++i)
+                indicesBuff[i] = overlap.domesticToGlobal(sendIndices_[sendOffsets_[peerIdx] + i]);
+
+            (*numIndicesSendBuff[peerIdx])[0] = numEntries;
+            numIndicesSendBuff[peerIdx]->send(peerRank);
+            indicesBuff.send(peerRank);
+        }
+
+        // receive the indices from the peers and translate them to
+        // domestic ones
+        for (int peerIdx = 0; peerIdx < nPeers; ++peerIdx) {
+            int peerRank = peerRanks_[peerIdx];
+
+            MpiBuffer<int> numRowsRecvBuff(1);
+            numRowsRecvBuff.receive(peerRank);
+            int numRows = numRowsRecvBuff[0];
+
+            MpiBuffer<Index> indicesRecvBuff(numRows);
+            indicesRecvBuff.receive(peerRank);
+
+            for (int i = 0; i < numRows; ++i) {
+                Index domRowIdx = overlap.globalToDomestic(indicesRecvBuff[i]);
+
+                recvIndices_.push_back(domRowIdx);
+                recvFromMaster_.push_back(overlap.masterRank(domRowIdx) == peerRank);
+                recvIsBorder_.push_back(overlap.isBorderWith(domRowIdx, peerRank));
+            }
+            recvOffsets_[peerIdx + 1] = recvIndices_.size();
+        }
+        recvValues_.resize(recvIndices_.size());
+
+        // wait for all send operations to complete
+        for (int peerIdx = 0; peerIdx < nPeers; ++peerIdx) {
+            numIndicesSendBuff[peerIdx]->wait();
+            indicesSendBuff[peerIdx]->wait();
+        }
+#endif // HAVE_MPI
+    }
+
+    void createRequests_()
+    {
+#if HAVE_MPI
+        // the first half of the requests are the receive operations,
+        // the second half are the send operations
+        int nPeers = peerRanks_.size();
+        requests_.resize(2*nPeers);
+        for (int peerIdx = 0; peerIdx < nPeers; ++peerIdx) {
+            int peerRank = peerRanks_[peerIdx];
+
+            int recvBegin = recvOffsets_[peerIdx];
+            int recvSize = recvOffsets_[peerIdx + 1] - recvBegin;
+            MPI_Recv_init(recvValues_.data() + recvBegin,
+                          recvSize*sizeof(FieldVector),
+                          MPI_BYTE,
+                          peerRank,
+                          /*tag=*/0,
+                          comm_,
+                          &requests_[peerIdx]);
+
+            int sendBegin = sendOffsets_[peerIdx];
+            int sendSize = sendOffsets_[peerIdx + 1] - sendBegin;
+            MPI_Send_init(sendValues_.data() + sendBegin,
+                          sendSize*sizeof(FieldVector),
+                          MPI_BYTE,
+                          peerRank,
+                          /*tag=*/0,
+                          comm_,
+                          &requests_[nPeers + peerIdx]);
+        }
+#endif // HAVE_MPI
+    }
+
+    std::vector<ProcessRank> peerRanks_;
+
+    std::vector<int> sendOffsets_;
+    std::vector<Index> sendIndices_;
+    std::vector<FieldVector> sendValues_;
+
+    std::vector<int> recvOffsets_;
+    std::vector<Index> recvIndices_;
+    std::vector<unsigned char> recvFromMaster_;
+    std::vector<unsigned char> recvIsBorder_;
+    std::vector<FieldVector> recvValues_;
+
+    // true between start() and finish()
+    bool exchangePending_;
+
+#if HAVE_MPI
+    MPI_Comm comm_;
+    std::vector<MPI_Request> requests_;
+#endif // HAVE_MPI
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -31,6 +31,7 @@
 #include <ewoms/linear/globalindices.hh>
 #include <ewoms/linear/blacklist.hh>
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/timer.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 
@@ -38,10 +39,9 @@
 #include <dune/istl/io.hh>
 
 #include <algorithm>
-#include <set>
-#include <map>
 #include <iostream>
 #include <vector>
+#include <utility>
 #include <memory>
 
 namespace Ewoms {
@@ -59,7 +59,8 @@ public:
     typedef Ewoms::Linear::DomesticOverlapFromBCRSMatrix<BCRSMatrix> Overlap;
 
 private:
-    typedef std::vector<std::set<Index> > Entries;
+    // a flat list of (domestic row index, domestic column index) pairs
+    typedef std::vector<std::pair<Index, Index> > Entries;
 
 public:
     typedef typename ParentType::ColIterator ColIterator;
@@ -83,36 +84,14 @@ public:
         MPI_Comm_rank(MPI_COMM_WORLD, &myRank_);
 #endif // HAVE_MPI
 
+        const PeerSet &peerSet = overlap_->peerSet();
+        peerRanks_.assign(peerSet.begin(), peerSet.end());
+
         // build the overlapping matrix from the non-overlapping
         // matrix and the overlap
         build_(nativeMatrix);
     }
 
-    ~OverlappingBCRSMatrix()
-    {
-        if (overlap_.use_count() == 0)
-            return;
-
-        // delete all MPI buffers
-        const PeerSet &peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-
-            delete rowSizesRecvBuff_[peerRank];
-            delete rowIndicesRecvBuff_[peerRank];
-            delete entryColIndicesRecvBuff_[peerRank];
-            delete entryValuesRecvBuff_[peerRank];
-
-            delete numRowsSendBuff_[peerRank];
-            delete rowSizesSendBuff_[peerRank];
-            delete rowIndicesSendBuff_[peerRank];
-            delete entryColIndicesSendBuff_[peerRank];
-            delete entryValuesSendBuff_[peerRank];
-        }
-    }
-
     /*!
      * \brief Returns the domestic overlap for the process.
      */
@@ -167,6 +146,51 @@ public:
         }
     }
 
+    /*!
+     * \brief Print the wall clock time required by each phase of
+     *        setting up the overlapping matrix.
+     *
+     * The printed times are the maxima over all processes. This
+     * method must be called by all processes, but only the first
+     * process prints something.
+     */
+    void printSetupTimes(std::ostream &os) const
+    {
+        const int numPhases = 6;
+        double localTimes[numPhases] = {
+            overlap_->foreignOverlapSetupTime(),
+            overlap_->globalIndicesSetupTime(),
+            overlap_->domesticOverlapSetupTime(),
+            localEntriesTime_,
+            indexExchangeTime_,
+            structureSetupTime_
+        };
+        double maxTimes[numPhases];
+        std::copy(localTimes, localTimes + numPhases, maxTimes);
+
+#if HAVE_MPI
+        MPI_Reduce(localTimes,
+                   maxTimes,
+                   numPhases,
+                   MPI_DOUBLE,
+                   MPI_MAX,
+                   /*rootRank=*/0,
+                   MPI_COMM_WORLD);
+#endif // HAVE_MPI
+
+        if (myRank_ != 0)
+            return;
+
+        os << "Setting up the overlapping matrix took (max over processes):\n"
+           << "  foreign overlap: " << maxTimes[0] << " seconds\n"
+           << "  global indices: " << maxTimes[1] << " seconds\n"
+           << "  domestic overlap: " << maxTimes[2] << " seconds\n"
+           << "  local matrix entries: " << maxTimes[3] << " seconds\n"
+           << "  exchange of matrix entries: " << maxTimes[4] << " seconds\n"
+           << "  matrix structure: " << maxTimes[5] << " seconds\n"
+           << std::flush;
+    }
+
     void print() const
     {
         overlap_->print();
@@ -249,27 +273,16 @@ private:
         buildIndices_(nativeMatrix);
     }
 
-    int numDomesticEntriesInRowFor_(const BCRSMatrix &nativeMatrix, int peerRank, int rowIdx)
-    {
-        int numEntries = 0;
-
-        typedef typename BCRSMatrix::ConstColIterator ColIt;
-        ColIt colIt = nativeMatrix[rowIdx].begin();
-        ColIt colEndIt = nativeMatrix[rowIdx].end();
-        for (; colIt != colEndIt; ++colIt) {
-            if (overlap_->isDomesticIndexFor(peerRank, colIt.index()))
-                ++numEntries;
-        }
-
-        return numEntries;
-    }
-
     void buildIndices_(const BCRSMatrix &nativeMatrix)
     {
+        Ewoms::Timer timer;
+
         /////////
         // first, add all local matrix entries
         /////////
-        entries_.resize(overlap_->numDomestic());
+        timer.start();
+        Entries entries;
+        entries.reserve(nativeMatrix.nonzeroes());
         for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
             int domesticRowIdx = overlap_->nativeToDomestic(nativeRowIdx);
             if (domesticRowIdx < 0)
@@ -290,120 +303,119 @@ private:
                 if (domesticColIdx < 0)
                     continue;
 
-                entries_[domesticRowIdx].insert(domesticColIdx);
+                entries.push_back(std::make_pair(domesticRowIdx, domesticColIdx));
             }
         }
+        localEntriesTime_ = timer.realTimeElapsed();
 
         /////////
         // add the indices for all additional entries
         /////////
+        timer.start();
+        int numPeers = peerRanks_.size();
+        sendOffsets_.assign(numPeers + 1, 0);
+        recvOffsets_.assign(numPeers + 1, 0);
+        entryValuesSendBuff_.resize(numPeers);
+        entryValuesRecvBuff_.resize(numPeers);
 
         // first, send all our indices to all peers
-        const PeerSet &peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            sendIndices_(nativeMatrix, peerRank);
-        }
+        std::vector<std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff(numPeers);
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            indicesSendBuff[peerIdx] = sendIndices_(nativeMatrix, peerIdx);
 
         // then recieve all indices from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            receiveIndices_(peerRank);
-        }
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            receiveIndices_(peerIdx, entries);
 
         // wait until all send operations are completed
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-
-            numRowsSendBuff_[peerRank]->wait();
-            rowSizesSendBuff_[peerRank]->wait();
-            rowIndicesSendBuff_[peerRank]->wait();
-            entryColIndicesSendBuff_[peerRank]->wait();
-
-            // convert the global indices in the send buffers to domestic
-            // ones
-            globalToDomesticBuff_(*rowIndicesSendBuff_[peerRank]);
-            globalToDomesticBuff_(*entryColIndicesSendBuff_[peerRank]);
-        }
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            indicesSendBuff[peerIdx]->wait();
+        indexExchangeTime_ = timer.realTimeElapsed();
 
         /////////
         // actually initialize the BCRS matrix structure
         /////////
+        timer.start();
+        setupStructure_(entries);
+        structureSetupTime_ = timer.realTimeElapsed();
+    }
 
-        // set the row sizes
+    // set the sparsity pattern of the matrix given an unsorted list
+    // of entries which may contain duplicates
+    void setupStructure_(const Entries &entries)
+    {
+        // sort the entries by row using a counting sort
         int numDomestic = overlap_->numDomestic();
-        for (int rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
-            int numCols = 0;
-            const auto &colIndices = entries_[rowIdx];
-            auto colIdxIt = colIndices.begin();
-            const auto &colIdxEndIt = colIndices.end();
-            for (; colIdxIt != colIdxEndIt; ++colIdxIt) {
-                if (*colIdxIt < 0)
-                    // the matrix for the local process does not know about this DOF
-                    continue;
+        std::vector<int> rowOffsets(numDomestic + 1, 0);
+        auto entryIt = entries.begin();
+        const auto &entryEndIt = entries.end();
+        for (; entryIt != entryEndIt; ++entryIt) {
+            if (entryIt->second < 0)
+                // the matrix for the local process does not know about this DOF
+                continue;
 
-                ++numCols;
-            }
+            ++rowOffsets[entryIt->first + 1];
+        }
+        for (int rowIdx = 0; rowIdx < numDomestic; ++rowIdx)
+            rowOffsets[rowIdx + 1] += rowOffsets[rowIdx];
+
+        std::vector<Index> colIndices(rowOffsets[numDomestic]);
+        std::vector<int> rowFill(rowOffsets.begin(), rowOffsets.end() - 1);
+        entryIt = entries.begin();
+        for (; entryIt != entryEndIt; ++entryIt) {
+            if (entryIt->second < 0)
+                continue;
 
-            this->setrowsize(rowIdx, numCols);
+            colIndices[rowFill[entryIt->first]++] = entryIt->second;
         }
-        this->endrowsizes();
 
-        // set the indices
+        // sort the column indices of each row and remove the
+        // duplicates
+        std::vector<int> rowSizes(numDomestic);
         for (int rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
-            const auto &colIndices = entries_[rowIdx];
+            auto rowBegin = colIndices.begin() + rowOffsets[rowIdx];
+            auto rowEnd = colIndices.begin() + rowOffsets[rowIdx + 1];
+            std::sort(rowBegin, rowEnd);
+            rowSizes[rowIdx] = std::unique(rowBegin, rowEnd) - rowBegin;
+        }
 
-            auto colIdxIt = colIndices.begin();
-            const auto &colIdxEndIt = colIndices.end();
-            for (; colIdxIt != colIdxEndIt; ++colIdxIt) {
-                if (*colIdxIt < 0)
-                    // the matrix for the local process does not know about this DOF
-                    continue;
+        // set the row sizes
+        for (int rowIdx = 0; rowIdx < numDomestic; ++rowIdx)
+            this->setrowsize(rowIdx, rowSizes[rowIdx]);
+        this->endrowsizes();
 
-                this->addindex(rowIdx, *colIdxIt);
-            }
+        // set the indices
+        for (int rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
+            int rowBegin = rowOffsets[rowIdx];
+            for (int i = 0; i < rowSizes[rowIdx]; ++i)
+                this->addindex(rowIdx, colIndices[rowBegin + i]);
         }
         this->endindices();
-
-        // free the memory occupied by the array of the matrix entries
-        entries_.clear();
     }
 
-    // send the overlap indices to a peer
-    void sendIndices_(const BCRSMatrix &nativeMatrix, int peerRank)
+    // send the overlap indices to a peer. all indices are sent using
+    // a single message which consists of the number of rows, the
+    // global indices of the rows, the number of entries of each row
+    // and the global column indices of the entries.
+    std::shared_ptr<MpiBuffer<Index> > sendIndices_(const BCRSMatrix &nativeMatrix, int peerIdx)
     {
-#if HAVE_MPI
-        // send size of foreign overlap to peer
+        int peerRank = peerRanks_[peerIdx];
         int numOverlapRows = overlap_->foreignOverlapSize(peerRank);
-        numRowsSendBuff_[peerRank] = new MpiBuffer<Index>(1);
-        (*numRowsSendBuff_[peerRank])[0] = numOverlapRows;
-        numRowsSendBuff_[peerRank]->send(peerRank);
-
-        // allocate the buffers which hold the global indices of each row and the number
-        // of entries which need to be communicated by the respective row
-        rowIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
-        rowSizesSendBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
 
-        // compute the sets of the indices of the entries which need to be send to the peer
-        typedef std::set<int> ColumnIndexSet;
-        typedef std::map<int, ColumnIndexSet> EntryTuples;
+        std::vector<Index> message(1 + 2*numOverlapRows);
+        message[0] = numOverlapRows;
 
-        EntryTuples entryIndices;
-        int numEntries = 0; // <- total number of matrix entries to be send to the peer
+        // (global column index, domestic column index) pairs of the
+        // current row
+        std::vector<std::pair<Index, Index> > rowEntries;
         for (int overlapOffset = 0; overlapOffset < numOverlapRows; ++overlapOffset) {
             int domesticRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, overlapOffset);
             int nativeRowIdx = overlap_->domesticToNative(domesticRowIdx);
             int globalRowIdx = overlap_->domesticToGlobal(domesticRowIdx);
 
-            ColumnIndexSet &colIndices = entryIndices[globalRowIdx];
-
-            typedef typename BCRSMatrix::ConstColIterator ColIt;
-            ColIt nativeColIt = nativeMatrix[nativeRowIdx].begin();
-            ColIt nativeColEndIt = nativeMatrix[nativeRowIdx].end();
+            rowEntries.clear();
+            ConstColIterator nativeColIt = nativeMatrix[nativeRowIdx].begin();
+            ConstColIterator nativeColEndIt = nativeMatrix[nativeRowIdx].end();
             for (; nativeColIt != nativeColEndIt; ++nativeColIt) {
                 int nativeColIdx = nativeColIt.index();
                 int domesticColIdx = overlap_->nativeToDomestic(nativeColIdx);
@@ -420,259 +432,198 @@ private:
                     continue;
 
                 int globalColIdx = overlap_->domesticToGlobal(domesticColIdx);
-                colIndices.insert(globalColIdx);
-                ++numEntries;
+                rowEntries.push_back(std::make_pair(globalColIdx, domesticColIdx));
             }
-        };
-
-        // fill the send buffers
-        entryColIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numEntries);
-        int overlapEntryIdx = 0;
-        for (int overlapOffset = 0; overlapOffset < numOverlapRows; ++overlapOffset) {
-            int domesticRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, overlapOffset);
-            int globalRowIdx = overlap_->domesticToGlobal(domesticRowIdx);
-
-            (*rowIndicesSendBuff_[peerRank])[overlapOffset] = globalRowIdx;
-
-            const ColumnIndexSet &colIndexSet = entryIndices[globalRowIdx];
-            auto* rssb = rowSizesSendBuff_[peerRank];
-            (*rssb)[overlapOffset] = colIndexSet.size();
-            for (auto it = colIndexSet.begin(); it != colIndexSet.end(); ++it) {
-                int globalColIdx = *it;
 
-                (*entryColIndicesSendBuff_[peerRank])[overlapEntryIdx] = globalColIdx;
-                ++ overlapEntryIdx;
+            // the entries of each row are sent sorted by their global
+            // column index and without duplicates
+            std::sort(rowEntries.begin(), rowEntries.end());
+            rowEntries.erase(std::unique(rowEntries.begin(), rowEntries.end()),
+                             rowEntries.end());
+
+            message[1 + overlapOffset] = globalRowIdx;
+            message[1 + numOverlapRows + overlapOffset] = rowEntries.size();
+            for (unsigned i = 0; i < rowEntries.size(); ++i) {
+                message.push_back(rowEntries[i].first);
+
+                // remember the domestic indices of the entries for
+                // sending their values later
+                sendRowIndices_.push_back(domesticRowIdx);
+                sendColIndices_.push_back(rowEntries[i].second);
             }
         }
+        sendOffsets_[peerIdx + 1] = sendRowIndices_.size();
 
-        // actually communicate with the peer
-        rowSizesSendBuff_[peerRank]->send(peerRank);
-        rowIndicesSendBuff_[peerRank]->send(peerRank);
-        entryColIndicesSendBuff_[peerRank]->send(peerRank);
+        auto sendBuff = std::make_shared<MpiBuffer<Index> >(message.size());
+        std::copy(message.begin(), message.end(), &(*sendBuff)[0]);
+        sendBuff->send(peerRank);
 
         // create the send buffers for the values of the matrix
         // entries
-        entryValuesSendBuff_[peerRank] = new MpiBuffer<block_type>(numEntries);
-#endif // HAVE_MPI
+        int numEntries = sendOffsets_[peerIdx + 1] - sendOffsets_[peerIdx];
+        entryValuesSendBuff_[peerIdx] = std::make_shared<MpiBuffer<block_type> >(numEntries);
+
+        return sendBuff;
     }
 
-    // receive the overlap indices to a peer
-    void receiveIndices_(int peerRank)
+    // receive the overlap indices from a peer
+    void receiveIndices_(int peerIdx, Entries &entries)
     {
-#if HAVE_MPI
-        // receive size of foreign overlap to peer
-        Index numOverlapRows;
-        auto &numRowsRecvBuff = numRowsRecvBuff_[peerRank];
-        numRowsRecvBuff.resize(1);
-        numRowsRecvBuff.receive(peerRank);
-        numOverlapRows = numRowsRecvBuff[0];
-
-        // create receive buffer for the row sizes and receive them
-        // from the peer
-        rowSizesRecvBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
-        rowIndicesRecvBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
-        rowSizesRecvBuff_[peerRank]->receive(peerRank);
-        rowIndicesRecvBuff_[peerRank]->receive(peerRank);
-
-        // calculate the total number of indices which are send by the
-        // peer
-        int totalIndices = 0;
-        for (Index i = 0; i < numOverlapRows; ++i) {
-            totalIndices += (*rowSizesRecvBuff_[peerRank])[i];
-        }
-
-        // create the buffer to store the column indices of the matrix entries
-        entryColIndicesRecvBuff_[peerRank] = new MpiBuffer<Index>(totalIndices);
-        entryValuesRecvBuff_[peerRank] = new MpiBuffer<block_type>(totalIndices);
+        int peerRank = peerRanks_[peerIdx];
 
-        // communicate with the peer
-        entryColIndicesRecvBuff_[peerRank]->receive(peerRank);
-
-        // convert the global indices in the receive buffers to
-        // domestic ones
-        globalToDomesticBuff_(*rowIndicesRecvBuff_[peerRank]);
-        globalToDomesticBuff_(*entryColIndicesRecvBuff_[peerRank]);
+#if HAVE_MPI
+        MpiBuffer<Index> message;
+        message.receiveAnySize(peerRank);
 
-        // add the entries to the global entry map
-        int k = 0;
+        Index numOverlapRows = message[0];
+        int k = 1 + 2*numOverlapRows;
         for (Index i = 0; i < numOverlapRows; ++i) {
-            int domRowIdx = (*rowIndicesRecvBuff_[peerRank])[i];
-            for (Index j = 0; j < (*rowSizesRecvBuff_[peerRank])[i]; ++j) {
-                int domColIdx = (*entryColIndicesRecvBuff_[peerRank])[k];
-                entries_[domRowIdx].insert(domColIdx);
-                ++k;
+            Index domRowIdx = overlap_->globalToDomestic(message[1 + i]);
+            Index rowSize = message[1 + numOverlapRows + i];
+            for (Index j = 0; j < rowSize; ++j, ++k) {
+                Index domColIdx = overlap_->globalToDomestic(message[k]);
+
+                // column indices which are unknown to the local
+                // process are kept because the peer sends values for
+                // them
+                recvRowIndices_.push_back(domRowIdx);
+                recvColIndices_.push_back(domColIdx);
+                entries.push_back(std::make_pair(domRowIdx, domColIdx));
             }
         }
 #endif // HAVE_MPI
+        recvOffsets_[peerIdx + 1] = recvRowIndices_.size();
+
+        // create the buffer to store the values of the matrix entries
+        int numEntries = recvOffsets_[peerIdx + 1] - recvOffsets_[peerIdx];
+        entryValuesRecvBuff_[peerIdx] = std::make_shared<MpiBuffer<block_type> >(numEntries);
     }
 
     // communicates and adds up the contents of overlapping rows
     void syncAdd_()
     {
-        // first, send all entries to the peers
-        const PeerSet &peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
+        int numPeers = peerRanks_.size();
 
-            sendEntries_(peerRank);
-        }
+        // first, post the receives and send all entries to the peers
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            entryValuesRecvBuff_[peerIdx]->startReceive(peerRanks_[peerIdx]);
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            sendEntries_(peerIdx);
 
         // then, receive entries from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-
-            receiveAddEntries_(peerRank);
-        }
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            receiveAddEntries_(peerIdx);
 
         // finally, make sure that everything which we send was
         // received by the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            entryValuesSendBuff_[peerRank]->wait();
-        }
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            entryValuesSendBuff_[peerIdx]->wait();
     }
 
     // communicates and copies the contents of overlapping rows from
     // the master
     void syncCopy_()
     {
-        // first, send all entries to the peers
-        const PeerSet &peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
+        int numPeers = peerRanks_.size();
 
-            sendEntries_(peerRank);
-        }
+        // first, post the receives and send all entries to the peers
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            entryValuesRecvBuff_[peerIdx]->startReceive(peerRanks_[peerIdx]);
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            sendEntries_(peerIdx);
 
         // then, receive entries from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-
-            receiveCopyEntries_(peerRank);
-        }
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            receiveCopyEntries_(peerIdx);
 
         // finally, make sure that everything which we send was
         // received by the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            entryValuesSendBuff_[peerRank]->wait();
-        }
+        for (int peerIdx = 0; peerIdx < numPeers; ++peerIdx)
+            entryValuesSendBuff_[peerIdx]->wait();
     }
 
-    void sendEntries_(int peerRank)
+    void sendEntries_(int peerIdx)
     {
 #if HAVE_MPI
-        auto &mpiSendBuff = *entryValuesSendBuff_[peerRank];
-
-        auto &mpiRowIndicesSendBuff = *rowIndicesSendBuff_[peerRank];
-        auto &mpiRowSizesSendBuff = *rowSizesSendBuff_[peerRank];
-        auto &mpiColIndicesSendBuff = *entryColIndicesSendBuff_[peerRank];
+        auto &mpiSendBuff = *entryValuesSendBuff_[peerIdx];
 
         // fill the send buffer
-        unsigned k = 0;
-        for (unsigned i = 0; i < mpiRowIndicesSendBuff.size(); ++i) {
-            Index domRowIdx = mpiRowIndicesSendBuff[i];
-
-            for (Index j = 0; j < static_cast<Index>(mpiRowSizesSendBuff[i]); ++j)
-            {
-                // move to the next column which is in the overlap
-                Index domColIdx = mpiColIndicesSendBuff[k];
-
-                // add the values of this column to the send buffer
-                mpiSendBuff[k] = (*this)[domRowIdx][domColIdx];
-                ++k;
-            }
-        }
+        int offset = sendOffsets_[peerIdx];
+        int numEntries = sendOffsets_[peerIdx + 1] - offset;
+        for (int k = 0; k < numEntries; ++k)
+            mpiSendBuff[k] = (*this)[sendRowIndices_[offset + k]][sendColIndices_[offset + k]];
 
-        mpiSendBuff.send(peerRank);
+        mpiSendBuff.send(peerRanks_[peerIdx]);
 #endif // HAVE_MPI
     }
 
-    void receiveAddEntries_(int peerRank)
+    void receiveAddEntries_(int peerIdx)
     {
 #if HAVE_MPI
-        auto &mpiRecvBuff = *entryValuesRecvBuff_[peerRank];
-
-        auto &mpiRowIndicesRecvBuff = *rowIndicesRecvBuff_[peerRank];
-        auto &mpiRowSizesRecvBuff = *rowSizesRecvBuff_[peerRank];
-        auto &mpiColIndicesRecvBuff = *entryColIndicesRecvBuff_[peerRank];
-
-        mpiRecvBuff.receive(peerRank);
+        auto &mpiRecvBuff = *entryValuesRecvBuff_[peerIdx];
+        mpiRecvBuff.wait();
 
         // retrieve the values from the receive buffer
-        int k = 0;
-        for (Index i = 0; i < static_cast<Index>(mpiRowIndicesRecvBuff.size()); ++i) {
-            Index domRowIdx = mpiRowIndicesRecvBuff[i];
-            for (Index j = 0; j < static_cast<Index>(mpiRowSizesRecvBuff[i]); ++j, ++k) {
-                Index domColIdx = mpiColIndicesRecvBuff[k];
-
-                if (domColIdx < 0)
-                    // the matrix for the current process does not know about this DOF
-                    continue;
+        int offset = recvOffsets_[peerIdx];
+        int numEntries = recvOffsets_[peerIdx + 1] - offset;
+        for (int k = 0; k < numEntries; ++k) {
+            Index domColIdx = recvColIndices_[offset + k];
 
-                (*this)[domRowIdx][domColIdx] += mpiRecvBuff[k];
-            }
+            if (domColIdx < 0)
+                // the matrix for the current process does not know about this DOF
+                continue;
+
+            (*this)[recvRowIndices_[offset + k]][domColIdx] += mpiRecvBuff[k];
         }
 #endif // HAVE_MPI
     }
 
-    void receiveCopyEntries_(int peerRank)
+    void receiveCopyEntries_(int peerIdx)
     {
 #if HAVE_MPI
-        MpiBuffer<block_type> &mpiRecvBuff = *entryValuesRecvBuff_[peerRank];
-
-        MpiBuffer<Index> &mpiRowIndicesRecvBuff = *rowIndicesRecvBuff_[peerRank];
-        MpiBuffer<Index> &mpiRowSizesRecvBuff = *rowSizesRecvBuff_[peerRank];
-        MpiBuffer<Index> &mpiColIndicesRecvBuff = *entryColIndicesRecvBuff_[peerRank];
-
-        mpiRecvBuff.receive(peerRank);
+        auto &mpiRecvBuff = *entryValuesRecvBuff_[peerIdx];
+        mpiRecvBuff.wait();
 
         // retrieve the values from the receive buffer
-        int k = 0;
-        for (int i = 0; i < mpiRowIndicesRecvBuff.size(); ++i) {
-            Index domRowIdx = mpiRowIndicesRecvBuff[i];
-            for (int j = 0; j < mpiRowSizesRecvBuff[i]; ++j, ++k) {
-                Index domColIdx = mpiColIndicesRecvBuff[k];
-
-                if (domColIdx < 0)
-                    // the matrix for the current process does not know about this DOF
-                    continue;
+        int offset = recvOffsets_[peerIdx];
+        int numEntries = recvOffsets_[peerIdx + 1] - offset;
+        for (int k = 0; k < numEntries; ++k) {
+            Index domColIdx = recvColIndices_[offset + k];
 
-                (*this)[domRowIdx][domColIdx] = mpiRecvBuff[k];
-            }
+            if (domColIdx < 0)
+                // the matrix for the current process does not know about this DOF
+                continue;
+
+            (*this)[recvRowIndices_[offset + k]][domColIdx] = mpiRecvBuff[k];
         }
 #endif // HAVE_MPI
     }
 
-    void globalToDomesticBuff_(MpiBuffer<Index> &idxBuff)
-    {
-        for (unsigned i = 0; i < idxBuff.size(); ++i)
-            idxBuff[i] = overlap_->globalToDomestic(idxBuff[i]);
-    }
-
     int myRank_;
-    Entries entries_;
     std::shared_ptr<Overlap> overlap_;
 
-    std::map<ProcessRank, MpiBuffer<Index> *> numRowsSendBuff_;
-    std::map<ProcessRank, MpiBuffer<Index> *> rowSizesSendBuff_;
-    std::map<ProcessRank, MpiBuffer<Index> *> rowIndicesSendBuff_;
-    std::map<ProcessRank, MpiBuffer<Index> *> entryColIndicesSendBuff_;
-    std::map<ProcessRank, MpiBuffer<block_type> *> entryValuesSendBuff_;
-
-    std::map<ProcessRank, MpiBuffer<Index> > numRowsRecvBuff_;
-    std::map<ProcessRank, MpiBuffer<Index> *> rowSizesRecvBuff_;
-    std::map<ProcessRank, MpiBuffer<Index> *> rowIndicesRecvBuff_;
-    std::map<ProcessRank, MpiBuffer<Index> *> entryColIndicesRecvBuff_;
-    std::map<ProcessRank, MpiBuffer<block_type> *> entryValuesRecvBuff_;
+    // the ranks of the peer processes
+    std::vector<ProcessRank> peerRanks_;
+
+    // the domestic (row, column) indices of the entries which are
+    // sent to the peers. the entries for the peer with index i are
+    // stored in the range [sendOffsets_[i], sendOffsets_[i + 1]).
+    std::vector<int> sendOffsets_;
+    std::vector<Index> sendRowIndices_;
+    std::vector<Index> sendColIndices_;
+    std::vector<std::shared_ptr<MpiBuffer<block_type> > > entryValuesSendBuff_;
+
+    // the domestic (row, column) indices of the entries which are
+    // received from the peers
+    std::vector<int> recvOffsets_;
+    std::vector<Index> recvRowIndices_;
+    std::vector<Index> recvColIndices_;
+    std::vector<std::shared_ptr<MpiBuffer<block_type> > > entryValuesRecvBuff_;
+
+    // the wall clock time required by the phases of the setup
+    double localEntriesTime_;
+    double indexExchangeTime_;
+    double structureSetupTime_;
 };
 
 } // namespace Linear
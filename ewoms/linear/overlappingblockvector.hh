@@ -28,15 +28,14 @@
 #define EWOMS_OVERLAPPING_BLOCK_VECTOR_HH
 
 #include "overlaptypes.hh"
+#include "overlapexchangeplan.hh"
 
-#include <ewoms/parallel/mpibuffer.hh>
 #include <opm/material/common/Valgrind.hpp>
 
 #include <dune/istl/bvector.hh>
 #include <dune/common/fvector.hh>
 
 #include <memory>
-#include <map>
 #include <iostream>
 
 namespace Ewoms {
@@ -50,6 +49,7 @@ class OverlappingBlockVector : public Dune::BlockVector<FieldVector>
 {
     typedef Dune::BlockVector<FieldVector> ParentType;
     typedef Dune::BlockVector<FieldVector> BlockVector;
+    typedef Ewoms::Linear::OverlapExchangePlan<FieldVector, Overlap> ExchangePlan;
 
 public:
     /*!
@@ -57,19 +57,17 @@ public:
      *        block vector coherent to it.
      */
     OverlappingBlockVector(const Overlap &overlap)
-        : ParentType(overlap.numDomestic()), overlap_(&overlap)
-    { createBuffers_(); }
+        : ParentType(overlap.numDomestic())
+        , exchangePlan_(overlap.template exchangePlan<FieldVector>())
+        , overlap_(&overlap)
+    {}
 
     /*!
      * \brief Copy constructor.
      */
     OverlappingBlockVector(const OverlappingBlockVector &obv)
         : ParentType(obv)
-        , numIndicesSendBuff_(obv.numIndicesSendBuff_)
-        , indicesSendBuff_(obv.indicesSendBuff_)
-        , indicesRecvBuff_(obv.indicesRecvBuff_)
-        , valuesSendBuff_(obv.valuesSendBuff_)
-        , valuesRecvBuff_(obv.valuesRecvBuff_)
+        , exchangePlan_(obv.exchangePlan_)
         , overlap_(obv.overlap_)
     {}
 
@@ -92,11 +90,7 @@ public:
     OverlappingBlockVector &operator=(const OverlappingBlockVector &obv)
     {
         ParentType::operator=(obv);
-        numIndicesSendBuff_ = obv.numIndicesSendBuff_;
-        indicesSendBuff_ = obv.indicesSendBuff_;
-        indicesRecvBuff_ = obv.indicesRecvBuff_;
-        valuesSendBuff_ = obv.valuesSendBuff_;
-        valuesRecvBuff_ = obv.valuesRecvBuff_;
+        exchangePlan_ = obv.exchangePlan_;
         overlap_ = obv.overlap_;
         return *this;
     }
@@ -170,26 +164,31 @@ public:
      */
     void sync()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            sendEntries_(peerRank);
-        }
+        startSync();
+        finishSync();
+    }
 
-        // recieve all entries to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            receiveFromMaster_(peerRank);
-        }
+    /*!
+     * \brief Start syncronizing the values of the block vector from their
+     *        master process.
+     *
+     * This sends the values of all rows which are part of the
+     * overlap of a peer process and posts the receive operations for
+     * the values of the remaining overlap rows. Until finishSync()
+     * has been called, only rows which are not in the overlap of any
+     * peer process (see the interiorRows() method of the overlap)
+     * may be modified and the values of rows that are not owned by
+     * the local process are undefined.
+     */
+    void startSync()
+    { exchangePlan_->start(*this); }
 
-        // wait until we have send everything
-        waitSendFinished_();
-    }
+    /*!
+     * \brief Finish syncronizing the values of the block vector which
+     *        was started by startSync().
+     */
+    void finishSync()
+    { exchangePlan_->finish(*this, ExchangePlan::ReceiveFromMaster); }
 
     /*!
      * \brief Syncronize all values of the block vector by adding up
@@ -197,25 +196,8 @@ public:
      */
     void syncAdd()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            sendEntries_(peerRank);
-        }
-
-        // recieve all entries to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            receiveAdd_(peerRank);
-        }
-
-        // wait until we have send everything
-        waitSendFinished_();
+        exchangePlan_->start(*this);
+        exchangePlan_->finish(*this, ExchangePlan::ReceiveAdd);
     }
 
     /*!
@@ -224,26 +206,8 @@ public:
      */
     void syncAddBorder()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            sendEntries_(peerRank);
-        }
-
-        // recieve all entries to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            receiveAddBorder_(peerRank);
-        }
-
-        // wait until we have send everything
-        waitSendFinished_();
-
+        exchangePlan_->start(*this);
+        exchangePlan_->finish(*this, ExchangePlan::ReceiveAddBorder);
     }
 
     void print() const
@@ -255,164 +219,7 @@ public:
     }
 
 private:
-    void createBuffers_()
-    {
-#if HAVE_MPI
-        // create array for the front indices
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all indices to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-
-            int numEntries = overlap_->foreignOverlapSize(peerRank);
-            numIndicesSendBuff_[peerRank] = std::make_shared<MpiBuffer<int> >(1);
-            indicesSendBuff_[peerRank] = std::make_shared<MpiBuffer<Index> >(numEntries);
-            valuesSendBuff_[peerRank] = std::make_shared<MpiBuffer<FieldVector> >(numEntries);
-
-            // fill the indices buffer with global indices
-            MpiBuffer<Index> &indicesSendBuff = *indicesSendBuff_[peerRank];
-            for (int i = 0; i < numEntries; ++i) {
-                int domRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, i);
-                indicesSendBuff[i] = overlap_->domesticToGlobal(domRowIdx);
-            }
-
-            // first, send the number of indices
-            (*numIndicesSendBuff_[peerRank])[0] = numEntries;
-            numIndicesSendBuff_[peerRank]->send(peerRank);
-
-            // then, send the indices themselfs
-            indicesSendBuff.send(peerRank);
-        }
-
-        // receive the indices from the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-
-            // receive size of overlap to peer
-            MpiBuffer<int> numRowsRecvBuff(1);
-            numRowsRecvBuff.receive(peerRank);
-            int numRows = numRowsRecvBuff[0];
-
-            // then, create the MPI buffers
-            indicesRecvBuff_[peerRank] = std::shared_ptr<MpiBuffer<Index> >(
-                new MpiBuffer<Index>(numRows));
-            valuesRecvBuff_[peerRank] = std::shared_ptr<MpiBuffer<FieldVector> >(
-                new MpiBuffer<FieldVector>(numRows));
-            MpiBuffer<Index> &indicesRecvBuff = *indicesRecvBuff_[peerRank];
-
-            // next, receive the actual indices
-            indicesRecvBuff.receive(peerRank);
-
-            // finally, translate the global indices to domestic ones
-            for (int i = 0; i != numRows; ++i) {
-                int globalRowIdx = indicesRecvBuff[i];
-                int domRowIdx = overlap_->globalToDomestic(globalRowIdx);
-
-                indicesRecvBuff[i] = domRowIdx;
-            }
-        }
-
-        // wait for all send operations to complete
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            numIndicesSendBuff_[peerRank]->wait();
-            indicesSendBuff_[peerRank]->wait();
-
-            // convert the global indices of the send buffer to
-            // domestic ones
-            MpiBuffer<Index> &indicesSendBuff = *indicesSendBuff_[peerRank];
-            for (unsigned i = 0; i < indicesSendBuff.size(); ++i) {
-                indicesSendBuff[i] = overlap_->globalToDomestic(indicesSendBuff[i]);
-            }
-        }
-#endif // HAVE_MPI
-    }
-
-    void sendEntries_(int peerRank)
-    {
-        // copy the values into the send buffer
-        const MpiBuffer<Index> &indices = *indicesSendBuff_[peerRank];
-        MpiBuffer<FieldVector> &values = *valuesSendBuff_[peerRank];
-        for (unsigned i = 0; i < indices.size(); ++i)
-            values[i] = (*this)[indices[i]];
-
-        values.send(peerRank);
-    }
-
-    void waitSendFinished_()
-    {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            int peerRank = *peerIt;
-            valuesSendBuff_[peerRank]->wait();
-        }
-    }
-
-    void receiveFromMaster_(int peerRank)
-    {
-        const MpiBuffer<Index> &indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector> &values = *valuesRecvBuff_[peerRank];
-
-        // receive the values from the peer
-        values.receive(peerRank);
-
-        // copy them into the block vector
-        for (unsigned j = 0; j < indices.size(); ++j) {
-            Index domRowIdx = indices[j];
-            if (overlap_->masterRank(domRowIdx) == peerRank) {
-                (*this)[domRowIdx] = values[j];
-            }
-        }
-    }
-
-    void receiveAddBorder_(int peerRank)
-    {
-        const MpiBuffer<Index> &indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector> &values = *valuesRecvBuff_[peerRank];
-
-        // receive the values from the peer
-        values.receive(peerRank);
-
-        // add up the values of rows on the shared boundary
-        for (unsigned j = 0; j < indices.size(); ++j) {
-            int domRowIdx = indices[j];
-            if (overlap_->isBorderWith(domRowIdx, peerRank))
-                (*this)[domRowIdx] += values[j];
-            else
-                (*this)[domRowIdx] = values[j];
-        }
-    }
-
-    void receiveAdd_(int peerRank)
-    {
-        const MpiBuffer<Index> &indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector> &values = *valuesRecvBuff_[peerRank];
-
-        // receive the values from the peer
-        values.receive(peerRank);
-
-        // add up the values of rows on the shared boundary
-        for (int j = 0; j < indices.size(); ++j) {
-            int domRowIdx = indices[j];
-            (*this)[domRowIdx] += values[j];
-        }
-    }
-
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<int> > > numIndicesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesRecvBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<FieldVector> > > valuesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<FieldVector> > > valuesRecvBuff_;
-
+    std::shared_ptr<ExchangePlan> exchangePlan_;
     const Overlap *overlap_;
 };
 
@@ -52,19 +52,33 @@ public:
     OverlappingOperator(const OverlappingMatrix &A) : A_(A)
     {}
 
-    //! apply operator to x:  \f$ y = A(x) \f$
+    /*!
+     * \brief apply operator to x:  \f$ y = A(x) \f$
+     *
+     * The rows of y which need to be sent to peer processes are
+     * computed first. The remaining rows are computed while the
+     * communication is in progress.
+     */
     virtual void apply(const DomainVector &x, RangeVector &y) const
     {
-        A_.mv(x, y);
-        y.sync();
+        const Overlap &overlap = A_.overlap();
+
+        mvRows_(overlap.sendRows(), x, y);
+        y.startSync();
+        mvRows_(overlap.interiorRows(), x, y);
+        y.finishSync();
     }
 
     //! apply operator to x, scale and add:  \f$ y = y + \alpha A(x) \f$
     virtual void applyscaleadd(field_type alpha, const DomainVector &x,
                                RangeVector &y) const
     {
-        A_.usmv(alpha, x, y);
-        y.sync();
+        const Overlap &overlap = A_.overlap();
+
+        usmvRows_(overlap.sendRows(), alpha, x, y);
+        y.startSync();
+        usmvRows_(overlap.interiorRows(), alpha, x, y);
+        y.finishSync();
     }
 
     //! returns the matrix
@@ -75,6 +89,40 @@ public:
     { return A_.overlap(); }
 
 private:
+    template <class RowList>
+    void mvRows_(const RowList &rows, const DomainVector &x, RangeVector &y) const
+    {
+        auto rowIt = rows.begin();
+        const auto &rowEndIt = rows.end();
+        for (; rowIt != rowEndIt; ++rowIt) {
+            int rowIdx = *rowIt;
+            y[rowIdx] = 0.0;
+
+            const auto &row = A_[rowIdx];
+            auto colIt = row.begin();
+            const auto &colEndIt = row.end();
+            for (; colIt != colEndIt; ++colIt)
+                colIt->umv(x[colIt.index()], y[rowIdx]);
+        }
+    }
+
+    template <class RowList>
+    void usmvRows_(const RowList &rows, field_type alpha,
+                   const DomainVector &x, RangeVector &y) const
+    {
+        auto rowIt = rows.begin();
+        const auto &rowEndIt = rows.end();
+        for (; rowIt != rowEndIt; ++rowIt) {
+            int rowIdx = *rowIt;
+
+            const auto &row = A_[rowIdx];
+            auto colIt = row.begin();
+            const auto &colEndIt = row.end();
+            for (; colIt != colEndIt; ++colIt)
+                colIt->usmv(alpha, x[colIt.index()], y[rowIdx]);
+        }
+    }
+
     const OverlappingMatrix &A_;
 };
 
@@ -31,25 +31,66 @@
 #include <mpi.h>
 #endif
 
+#include "fusedscalarproduct.hh"
+
 #include <dune/istl/scalarproducts.hh>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace Ewoms {
 namespace Linear {
 
 /*!
  * \brief An overlap aware ISTL scalar product.
+ *
+ * The global reductions use a dedicated communicator, so that the non-blocking ones
+ * cannot be confused with other collective operations which are issued while they are
+ * in progress.
  */
 template <class OverlappingBlockVector, class Overlap>
 class OverlappingScalarProduct
-    : public Dune::ScalarProduct<OverlappingBlockVector>
+    : public FusedScalarProduct<OverlappingBlockVector>
 {
 public:
     typedef typename OverlappingBlockVector::field_type field_type;
 
     enum { category = Dune::SolverCategory::overlapping };
 
-    OverlappingScalarProduct(const Overlap &overlap) : overlap_(overlap)
-    {}
+    // the MPI objects are owned by the scalar product
+    OverlappingScalarProduct(const OverlappingScalarProduct &) = delete;
+
+    OverlappingScalarProduct(const Overlap &overlap)
+        : overlap_(overlap)
+        , pendingResult_(0)
+        , pendingMaxResult_(0)
+        , numPendingSums_(0)
+        , numPendingMaxima_(0)
+    {
+        ownerMask_.resize(overlap_.numDomestic(), 0);
+        int numLocal = overlap_.numLocal();
+        for (int localIdx = 0; localIdx < numLocal; ++localIdx)
+            ownerMask_[localIdx] = overlap_.iAmMasterOf(localIdx) ? 1 : 0;
+
+#if HAVE_MPI
+        MPI_Comm_dup(MPI_COMM_WORLD, &comm_);
+
+        // the data type and the operation of the fused reductions of sums and maxima
+        MPI_Type_contiguous(2, MPI_DOUBLE, &sumOrMaxType_);
+        MPI_Type_commit(&sumOrMaxType_);
+        MPI_Op_create(&sumOrMax_, /*commute=*/1, &sumOrMaxOp_);
+#endif // HAVE_MPI
+    }
+
+    ~OverlappingScalarProduct()
+    {
+#if HAVE_MPI
+        MPI_Op_free(&sumOrMaxOp_);
+        MPI_Type_free(&sumOrMaxType_);
+        MPI_Comm_free(&comm_);
+#endif // HAVE_MPI
+    }
 
     field_type dot(const OverlappingBlockVector &x,
                    const OverlappingBlockVector &y)
@@ -69,7 +110,7 @@ public:
                       1,               // number of objects in buffers
                       MPI_DOUBLE,      // data type
                       MPI_SUM,         // operation
-                      MPI_COMM_WORLD); // communicator
+                      comm_);          // communicator
 #else
         sumGlobal = sum;
 #endif // HAVE_MPI
@@ -80,8 +121,149 @@ public:
     double norm(const OverlappingBlockVector &x)
     { return std::sqrt(dot(x, x)); }
 
+    /*!
+     * \copydoc FusedScalarProduct::ownerMask()
+     *
+     * The rows of the vectors which are considered are the local ones of which the
+     * process is the master.
+     */
+    const unsigned char *ownerMask() const
+    { return ownerMask_.data(); }
+
+    /*!
+     * \copydoc FusedScalarProduct::reduceStart()
+     *
+     * All sums and maxima are computed using a single global reduction. It is
+     * non-blocking if the MPI implementation supports it.
+     */
+    void reduceStart(const field_type *localSums,
+                     field_type *result,
+                     int numSums,
+                     const field_type *localMaxima = 0,
+                     field_type *maxResult = 0,
+                     int numMaxima = 0)
+    {
+        pendingResult_ = result;
+        pendingMaxResult_ = maxResult;
+        numPendingSums_ = numSums;
+        numPendingMaxima_ = numMaxima;
+
+        if (numMaxima == 0) {
+            localSums_.assign(localSums, localSums + numSums);
+            globalSums_.resize(numSums);
+#if HAVE_MPI
+#if MPI_VERSION >= 3
+            MPI_Iallreduce(localSums_.data(),  // source buffer
+                           globalSums_.data(), // destination buffer
+                           numSums,            // number of objects in buffers
+                           MPI_DOUBLE,         // data type
+                           MPI_SUM,            // operation
+                           comm_,              // communicator
+                           &request_);         // request object
+#else
+            MPI_Allreduce(localSums_.data(),  // source buffer
+                          globalSums_.data(), // destination buffer
+                          numSums,            // number of objects in buffers
+                          MPI_DOUBLE,         // data type
+                          MPI_SUM,            // operation
+                          comm_);             // communicator
+#endif
+#else
+            globalSums_ = localSums_;
+#endif // HAVE_MPI
+            return;
+        }
+
+        // if maxima are requested, each value is accompanied by a flag which
+        // specifies whether it is summed up or whether its maximum is taken. this
+        // allows to use a single reduction with a custom operation
+        int numValues = numSums + numMaxima;
+        localSums_.resize(2*numValues);
+        globalSums_.resize(2*numValues);
+        for (int i = 0; i < numSums; ++i) {
+            localSums_[2*i] = localSums[i];
+            localSums_[2*i + 1] = 0.0;
+        }
+        for (int i = 0; i < numMaxima; ++i) {
+            localSums_[2*(numSums + i)] = localMaxima[i];
+            localSums_[2*(numSums + i) + 1] = 1.0;
+        }
+#if HAVE_MPI
+#if MPI_VERSION >= 3
+        MPI_Iallreduce(localSums_.data(),  // source buffer
+                       globalSums_.data(), // destination buffer
+                       numValues,          // number of objects in buffers
+                       sumOrMaxType_,      // data type
+                       sumOrMaxOp_,        // operation
+                       comm_,              // communicator
+                       &request_);         // request object
+#else
+        MPI_Allreduce(localSums_.data(),  // source buffer
+                      globalSums_.data(), // destination buffer
+                      numValues,          // number of objects in buffers
+                      sumOrMaxType_,      // data type
+                      sumOrMaxOp_,        // operation
+                      comm_);             // communicator
+#endif
+#else
+        globalSums_ = localSums_;
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \copydoc FusedScalarProduct::reduceFinish()
+     */
+    void reduceFinish()
+    {
+#if HAVE_MPI && MPI_VERSION >= 3
+        MPI_Wait(&request_, MPI_STATUS_IGNORE);
+#endif
+        if (numPendingMaxima_ == 0) {
+            for (int i = 0; i < numPendingSums_; ++i)
+                pendingResult_[i] = globalSums_[i];
+            return;
+        }
+
+        for (int i = 0; i < numPendingSums_; ++i)
+            pendingResult_[i] = globalSums_[2*i];
+        for (int i = 0; i < numPendingMaxima_; ++i)
+            pendingMaxResult_[i] = globalSums_[2*(numPendingSums_ + i)];
+    }
+
 private:
+#if HAVE_MPI
+    // the reduction operation for (value, flag) pairs: the values are summed up if
+    // the flag is zero and their maximum is taken otherwise
+    static void sumOrMax_(void *in, void *inOut, int *len, MPI_Datatype *)
+    {
+        const double *a = static_cast<const double*>(in);
+        double *b = static_cast<double*>(inOut);
+        for (int i = 0; i < *len; ++i) {
+            if (a[2*i + 1] != 0.0)
+                b[2*i] = std::max(a[2*i], b[2*i]);
+            else
+                b[2*i] += a[2*i];
+        }
+    }
+#endif // HAVE_MPI
+
     const Overlap &overlap_;
+
+    std::vector<unsigned char> ownerMask_;
+    std::vector<double> localSums_;
+    std::vector<double> globalSums_;
+    field_type *pendingResult_;
+    field_type *pendingMaxResult_;
+    int numPendingSums_;
+    int numPendingMaxima_;
+#if HAVE_MPI
+    MPI_Comm comm_;
+    MPI_Datatype sumOrMaxType_;
+    MPI_Op sumOrMaxOp_;
+#endif // HAVE_MPI
+#if HAVE_MPI && MPI_VERSION >= 3
+    MPI_Request request_;
+#endif
 };
 
 } // namespace Linear
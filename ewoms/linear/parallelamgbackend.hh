@@ -50,7 +50,9 @@
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpicollectivecommunication.hh>
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 
 namespace Ewoms {
 namespace Linear {
@@ -63,15 +65,73 @@ NEW_TYPE_TAG(ParallelAmgLinearSolver, INHERITS_FROM(ParallelIterativeLinearSolve
 
 NEW_PROP_TAG(AmgCoarsenTarget);
 
+/*!
+ * \brief Specifies how much of the AMG hierarchy is reused by subsequent solves.
+ *
+ * 0 means that the hierarchy is set up from scratch for each linear system, 1 means
+ * that the aggregates are kept and only the Galerkin products of the coarse levels
+ * are recomputed and 2 means that the coarse levels are kept as they are.
+ */
+NEW_PROP_TAG(AmgReuseHierarchy);
+
+/*!
+ * \brief The factor by which the number of iterations of a linear solve may exceed the
+ *        one observed directly after the AMG hierarchy was set up before the hierarchy
+ *        is set up from scratch.
+ */
+NEW_PROP_TAG(AmgRebuildIterationRatio);
+
 //! The target number of DOFs per processor for the parallel algebraic
 //! multi-grid solver
 SET_INT_PROP(ParallelAmgLinearSolver, AmgCoarsenTarget, 5000);
 
+//! set up the AMG hierarchy from scratch for each linear system by default
+SET_INT_PROP(ParallelAmgLinearSolver, AmgReuseHierarchy, 0);
+
+//! rebuild a reused AMG hierarchy if the number of iterations doubles
+SET_SCALAR_PROP(ParallelAmgLinearSolver, AmgRebuildIterationRatio, 2.0);
+
 SET_TYPE_PROP(ParallelAmgLinearSolver, LinearSolverBackend,
               Ewoms::Linear::ParallelAmgBackend<TypeTag>);
 } // namespace Properties
 
 namespace Linear {
+#if HAVE_MPI
+/*!
+ * \ingroup Linear
+ *
+ * \brief Create DUNE's parallel index set from a domestic overlap.
+ *
+ * \param overlap The domestic overlap of the process
+ * \param istlIndices The index set which ought to be set up
+ */
+template <class Overlap, class ParallelIndexSet>
+void setupAmgIndexSet(const Overlap &overlap, ParallelIndexSet &istlIndices)
+{
+    typedef Dune::OwnerOverlapCopyAttributeSet GridAttributes;
+    typedef Dune::OwnerOverlapCopyAttributeSet::AttributeSet GridAttributeSet;
+
+    // create DUNE's ParallelIndexSet from a domestic overlap
+    istlIndices.beginResize();
+    for (int curIdx = 0; curIdx < overlap.numDomestic(); ++curIdx) {
+        GridAttributeSet gridFlag = overlap.iAmMasterOf(curIdx)
+                                        ? GridAttributes::owner
+                                        : GridAttributes::copy;
+
+        // an index is used by other processes if it is in the
+        // domestic or in the foreign overlap.
+        bool isShared = overlap.isInOverlap(curIdx);
+
+        assert(curIdx == int(overlap.globalToDomestic(
+                             overlap.domesticToGlobal(curIdx))));
+        istlIndices.add(/*globalIdx=*/overlap.domesticToGlobal(curIdx),
+                        Dune::ParallelLocalIndex<GridAttributeSet>(
+                            curIdx, gridFlag, isShared));
+    }
+    istlIndices.endResize();
+}
+#endif
+
 /*!
  * \ingroup Linear
  *
@@ -129,10 +189,18 @@ class ParallelAmgBackend
 public:
     ParallelAmgBackend(const Simulator &simulator)
         : simulator_(simulator)
+        , gridSequenceNumber_(-1)
+        , amgIsFresh_(false)
+        , amgNeedsRebuild_(false)
+        , baselineIterations_(0)
     {
         overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
         overlappingx_ = nullptr;
+        fineOperator_ = nullptr;
+#if HAVE_MPI
+        istlComm_ = nullptr;
+#endif
 
         amg_ = nullptr;
     }
@@ -147,8 +215,24 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, AmgCoarsenTarget,
                              "The coarsening target for the agglomerations of "
                              "the AMG preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, int, AmgReuseHierarchy,
+                             "Specifies how much of the AMG hierarchy is reused by "
+                             "subsequent linear solves: 0 = nothing, 1 = the "
+                             "aggregates, 2 = the whole hierarchy");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, AmgRebuildIterationRatio,
+                             "The factor by which the number of linear iterations may "
+                             "grow before a reused AMG hierarchy is set up from scratch");
     }
 
+    /*!
+     * \brief Returns true if the backend is able to apply the Jacobian matrix without
+     *        an up-to-date assembled matrix.
+     *
+     * The AMG backend always applies the assembled matrix.
+     */
+    static bool supportsJacobianFreeNewton()
+    { return false; }
+
     /*!
      * \brief Causes the solve() method to discared the structure of the linear system of
      *        equations the next time it is called.
@@ -198,17 +282,69 @@ public:
         if (simulator_.gridManager().gridView().comm().rank() == 0)
             verbosity = EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity);
 
-        (*overlappingx_) = 0.0;
+        // the AMG hierarchy must be set up from scratch if the grid has changed
+        int curGridSequenceNumber = simulator_.gridManager().gridSequenceNumber();
+        if (curGridSequenceNumber != gridSequenceNumber_) {
+            amgNeedsRebuild_ = true;
+            gridSequenceNumber_ = curGridSequenceNumber;
+        }
 
         /////////////
         // set-up the AMG preconditioner
         /////////////
-        // create the parallel scalar product and the parallel operator
-#if HAVE_MPI
-        FineOperator fineOperator(*overlappingMatrix_, *istlComm_);
-#else
-        FineOperator fineOperator(*overlappingMatrix_);
-#endif
+        updateAmg_();
+
+        // if the hierarchy is reused, keep the right hand side to be able to retry
+        // with a fresh hierarchy if the linear solver fails
+        std::unique_ptr<OverlappingVector> bBackup;
+        if (!amgIsFresh_)
+            bBackup.reset(new OverlappingVector(*overlappingb_));
+
+        Dune::InverseOperatorResult result;
+        bool solverSucceeded = solveWithAmg_(result, verbosity);
+
+        if (!amgIsFresh_) {
+            Scalar maxRatio = EWOMS_GET_PARAM(TypeTag, Scalar, AmgRebuildIterationRatio);
+            if (!solverSucceeded || !result.converged) {
+                // the reused hierarchy is not good enough anymore. set it up from
+                // scratch and try again
+                if (verbosity > 0)
+                    std::cout << "Linear solver failed using a reused AMG hierarchy. "
+                              << "Retrying with a new hierarchy\n" << std::flush;
+                *overlappingb_ = *bBackup;
+                amgNeedsRebuild_ = true;
+                updateAmg_();
+                solverSucceeded = solveWithAmg_(result, verbosity);
+            }
+            else if (result.iterations > maxRatio*baselineIterations_)
+                // the convergence has degraded too much. the hierarchy is set up
+                // from scratch for the next linear system
+                amgNeedsRebuild_ = true;
+        }
+
+        if (amgIsFresh_ && solverSucceeded)
+            baselineIterations_ = std::max(result.iterations, 1);
+        amgIsFresh_ = false;
+
+        if (!solverSucceeded)
+            return false;
+
+        // copy the result back to the non-overlapping vector
+        overlappingx_->assignTo(x);
+
+        return result.converged;
+    }
+
+private:
+    Implementation &asImp_()
+    { return *static_cast<Implementation *>(this); }
+
+    const Implementation &asImp_() const
+    { return *static_cast<const Implementation *>(this); }
+
+    bool solveWithAmg_(Dune::InverseOperatorResult &result, int verbosity)
+    {
+        (*overlappingx_) = 0.0;
 
 #if HAVE_MPI
         FineScalarProduct scalarProduct(*istlComm_);
@@ -216,8 +352,6 @@ public:
         FineScalarProduct scalarProduct;
 #endif
 
-        setupAmg_(fineOperator);
-
         /////////////
         // set-up the linear solver
         /////////////
@@ -227,7 +361,7 @@ public:
         typedef Ewoms::BiCGSTABSolver<Vector> SolverType;
         Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
         int maxIterations = EWOMS_GET_PARAM(TypeTag, int, LinearSolverMaxIterations);
-        SolverType solver(fineOperator,
+        SolverType solver(*fineOperator_,
                           scalarProduct,
                           /*preconditioner=*/*amg_,
                           linearSolverTolerance,
@@ -267,7 +401,6 @@ public:
         typedef Ewoms::ConvergenceCriterion<Vector> ConvergenceCriterion;
         solver.setConvergenceCriterion(std::shared_ptr<ConvergenceCriterion>(convCrit));
 
-        Dune::InverseOperatorResult result;
         int solverSucceeded = 1;
         try
         {
@@ -280,22 +413,9 @@ public:
             solverSucceeded = simulator_.gridManager().gridView().comm().min(solverSucceeded);
         }
 
-        if (!solverSucceeded)
-            return false;
-
-        // copy the result back to the non-overlapping vector
-        overlappingx_->assignTo(x);
-
-        return result.converged;
+        return solverSucceeded != 0;
     }
 
-private:
-    Implementation &asImp_()
-    { return *static_cast<Implementation *>(this); }
-
-    const Implementation &asImp_() const
-    { return *static_cast<const Implementation *>(this); }
-
     void prepare_(const Matrix &M)
     {
         BorderListCreator borderListCreator(simulator_.gridView(),
@@ -309,6 +429,8 @@ private:
                                                    borderListCreator.borderList(),
                                                    blackList,
                                                    overlapSize);
+        if (EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity) > 1)
+            overlappingMatrix_->printSetupTimes(std::cout);
 
         // create the overlapping vectors for the residual and the
         // solution
@@ -321,58 +443,61 @@ private:
         // create and initialize DUNE's OwnerOverlapCopyCommunication
         // using the domestic overlap
         istlComm_ = new OwnerOverlapCopyCommunication(MPI_COMM_WORLD);
-        setupAmgIndexSet_(overlappingMatrix_->overlap(), istlComm_->indexSet());
+        setupAmgIndexSet(overlappingMatrix_->overlap(), istlComm_->indexSet());
         istlComm_->remoteIndices().template rebuild<false>();
+
+        fineOperator_ = new FineOperator(*overlappingMatrix_, *istlComm_);
+#else
+        fineOperator_ = new FineOperator(*overlappingMatrix_);
 #endif
     }
 
     void cleanup_()
     {
         // create the overlapping Jacobian matrix and vectors
+        delete amg_;
+        delete fineOperator_;
+#if HAVE_MPI
+        delete istlComm_;
+#endif
         delete overlappingMatrix_;
         delete overlappingb_;
         delete overlappingx_;
-        delete amg_;
 
         overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
         overlappingx_ = nullptr;
+        fineOperator_ = nullptr;
+#if HAVE_MPI
+        istlComm_ = nullptr;
+#endif
         amg_ = nullptr;
     }
 
-#if HAVE_MPI
-    template <class ParallelIndexSet>
-    void setupAmgIndexSet_(const Overlap &overlap, ParallelIndexSet &istlIndices)
+    // make the AMG hierarchy consistent with the current matrix. depending on the
+    // AmgReuseHierarchy parameter, this sets up the hierarchy from scratch, only
+    // recomputes the Galerkin products of the coarse levels, or does nothing at all.
+    // the smoothers refer to the matrices of the hierarchy, so they do not need to be
+    // updated explicitly.
+    void updateAmg_()
     {
-        typedef Dune::OwnerOverlapCopyAttributeSet GridAttributes;
-        typedef Dune::OwnerOverlapCopyAttributeSet::AttributeSet GridAttributeSet;
-
-        // create DUNE's ParallelIndexSet from a domestic overlap
-        istlIndices.beginResize();
-        for (int curIdx = 0; curIdx < overlap.numDomestic(); ++curIdx) {
-            GridAttributeSet gridFlag = overlap.iAmMasterOf(curIdx)
-                                            ? GridAttributes::owner
-                                            : GridAttributes::copy;
-
-            // an index is used by other processes if it is in the
-            // domestic or in the foreign overlap.
-            bool isShared = overlap.isInOverlap(curIdx);
-
-            assert(curIdx == int(overlap.globalToDomestic(
-                                 overlap.domesticToGlobal(curIdx))));
-            istlIndices.add(/*globalIdx=*/overlap.domesticToGlobal(curIdx),
-                            Dune::ParallelLocalIndex<GridAttributeSet>(
-                                curIdx, gridFlag, isShared));
+        int reuseMode = EWOMS_GET_PARAM(TypeTag, int, AmgReuseHierarchy);
+        if (amg_ && (reuseMode == 0 || amgNeedsRebuild_)) {
+            delete amg_;
+            amg_ = nullptr;
         }
-        istlIndices.endResize();
+
+        if (!amg_) {
+            setupAmg_();
+            amgIsFresh_ = true;
+            amgNeedsRebuild_ = false;
+        }
+        else if (reuseMode == 1)
+            amg_->recalculateHierarchy();
     }
-#endif
 
-    void setupAmg_(FineOperator &fineOperator)
+    void setupAmg_()
     {
-        if (amg_)
-            return;
-
         int verbosity = 0;
         if (simulator_.gridManager().gridView().comm().rank() == 0)
             verbosity = EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity);
@@ -413,15 +538,21 @@ private:
 
 // instantiate the AMG preconditioner
 #if HAVE_MPI
-        amg_ = new AMG(fineOperator, coarsenCriterion, smootherArgs, *istlComm_);
+        amg_ = new AMG(*fineOperator_, coarsenCriterion, smootherArgs, *istlComm_);
 #else
-        amg_ = new AMG(fineOperator, coarsenCriterion, smootherArgs);
+        amg_ = new AMG(*fineOperator_, coarsenCriterion, smootherArgs);
 #endif
     }
 
     const Simulator &simulator_;
 
     AMG *amg_;
+    FineOperator *fineOperator_;
+
+    int gridSequenceNumber_;
+    bool amgIsFresh_;
+    bool amgNeedsRebuild_;
+    int baselineIterations_;
 
 #if HAVE_MPI
     OwnerOverlapCopyCommunication *istlComm_;
@@ -32,7 +32,10 @@
 #include <ewoms/linear/overlappingpreconditioner.hh>
 #include <ewoms/linear/overlappingscalarproduct.hh>
 #include <ewoms/linear/overlappingoperator.hh>
+#include <ewoms/linear/jacobianfreeoperator.hh>
 #include <ewoms/linear/solverpreconditioner.hh>
+#include <ewoms/linear/mixedprecisionpreconditioner.hh>
+#include <ewoms/linear/threadedilu0.hh>
 
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
@@ -46,8 +49,12 @@
 #include <dune/common/shared_ptr.hh>
 #include <dune/common/fvector.hh>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <sstream>
 #include <iostream>
+#include <type_traits>
 
 namespace Ewoms {
 namespace Properties {
@@ -60,6 +67,7 @@ NEW_PROP_TAG(JacobianMatrix);
 NEW_PROP_TAG(GlobalEqVector);
 NEW_PROP_TAG(VertexMapper);
 NEW_PROP_TAG(GridView);
+NEW_PROP_TAG(ThreadManager);
 
 NEW_PROP_TAG(BorderListCreator);
 NEW_PROP_TAG(Overlap);
@@ -87,6 +95,23 @@ NEW_PROP_TAG(LinearSolverOverlapSize);
  */
 NEW_PROP_TAG(LinearSolverTolerance);
 
+/*!
+ * \brief Specifies how the tolerance of the linear solver is adapted to the
+ *        convergence of the Newton method.
+ *
+ * 0 means that the LinearSolverTolerance is always used, 1 and 2 select the
+ * respective choice of the Eisenstat-Walker method for the forcing terms of inexact
+ * Newton methods. In the latter case, LinearSolverTolerance is the lower bound of the
+ * tolerance.
+ */
+NEW_PROP_TAG(LinearSolverEisenstatWalker);
+
+/*!
+ * \brief The maximum tolerance of the linear solver if the Eisenstat-Walker method is
+ *        used.
+ */
+NEW_PROP_TAG(LinearSolverMaxTolerance);
+
 /*!
  * \brief Specifies the verbosity of the linear solver
  *
@@ -105,8 +130,23 @@ NEW_PROP_TAG(PreconditionerOrder);
 //! The relaxation factor of the preconditioner
 NEW_PROP_TAG(PreconditionerRelaxation);
 
+/*!
+ * \brief The number of newly assembled matrices for which the preconditioner of an
+ *        older matrix is reused.
+ *
+ * If the matrix did not change since the last call to solve(), the preconditioner is
+ * always reused.
+ */
+NEW_PROP_TAG(PreconditionerMaxAge);
+
 //! number of iterations between solver restarts for the GMRES solver
 NEW_PROP_TAG(GMResRestart);
+
+//! maximum number of vectors which the recycling GMRES solver keeps between solves
+NEW_PROP_TAG(GMResRecycledVectors);
+
+//! Specifies whether the Jacobian matrix may be applied without assembling it
+NEW_PROP_TAG(EnableJacobianFreeNewton);
 } // namespace Properties
 } // namespace Ewoms
 
@@ -136,6 +176,12 @@ namespace Linear {
  * - \c BiCGStab: A stabilized bi-conjugated gradients solver
  * - \c MinRes: A solver based on the  minimized residual algorithm
  * - \c RestartedGMRes: A restarted GMRES solver
+ * - \c RecyclingGMRes: A restarted GMRES solver which keeps a small deflation
+ *   subspace between solves, e.g., across the iterations of the Newton method
+ * - \c PipelinedConjugatedGradients, \c PipelinedBiCGStab: Variants of the conjugated
+ *   gradients and the BiCGSTAB solvers which fuse the scalar products of an
+ *   iteration into as few global reductions as possible and overlap them with
+ *   the application of the preconditioner and of the linear operator
  *
  * Chosing the preconditioner works in an analogous way:
  * \code
@@ -158,6 +204,10 @@ namespace Linear {
  *            higher orders
  * - \c Solver: A BiCGSTAB solver wrapped into the preconditioner
  *              interface (may be useful for parallel computations)
+ * - \c FloatSSOR, \c FloatILU0, \c FloatILUn: The SSOR, ILU(0) and ILU(n)
+ *   preconditioners, but set up and applied using single precision
+ * - \c ThreadedILU0: An ILU(0) preconditioner which uses all threads of the
+ *   ThreadManager for its factorization and its triangular solves
  */
 template <class TypeTag>
 class ParallelIterativeSolverBackend
@@ -187,17 +237,26 @@ class ParallelIterativeSolverBackend
     typedef Ewoms::Linear::OverlappingOperator<OverlappingMatrix,
                                                OverlappingVector,
                                                OverlappingVector> ParallelOperator;
+    typedef Ewoms::Linear::JacobianFreeOperator<TypeTag> JacobianFreeOperator;
 
     enum { dimWorld = GridView::dimensionworld };
 
 public:
-    ParallelIterativeSolverBackend(const Simulator &simulator)
+    ParallelIterativeSolverBackend(Simulator &simulator)
         : simulator_(simulator)
         , gridSequenceNumber_( -1 )
     {
         overlappingMatrix_ = 0;
         overlappingb_ = 0;
         overlappingx_ = 0;
+
+        matrixIsPrepared_ = false;
+        preconditionerIsPrepared_ = false;
+        preconditionerAge_ = 0;
+
+        lastNonlinearResidual_ = 0.0;
+        lastLinearResidual_ = 0.0;
+        lastForcingTerm_ = 0.0;
     }
 
     ~ParallelIterativeSolverBackend()
@@ -210,6 +269,16 @@ public:
     {
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, LinearSolverTolerance,
                              "The maximum allowed error between of the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverEisenstatWalker,
+                             "Adapt the tolerance of the linear solver to the convergence "
+                             "of the Newton method using the given choice of the "
+                             "Eisenstat-Walker method (0: use a fixed tolerance)");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, LinearSolverMaxTolerance,
+                             "The maximum tolerance of the linear solver if the "
+                             "Eisenstat-Walker method is used");
+        EWOMS_REGISTER_PARAM(TypeTag, int, PreconditionerMaxAge,
+                             "The number of newly assembled matrices for which the "
+                             "preconditioner of an older matrix is reused");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverOverlapSize,
                              "The size of the algebraic overlap for the linear solver");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverMaxIterations,
@@ -221,6 +290,19 @@ public:
         PreconditionerWrapper::registerParameters();
     }
 
+    /*!
+     * \brief Returns true if the backend is able to apply the Jacobian matrix without
+     *        an up-to-date assembled matrix.
+     *
+     * If the matrix was not updated since the last call to solve(), the Jacobian is
+     * applied using directional derivatives of the residual and the outdated matrix
+     * is only used for preconditioning. Note that this does not reduce the memory
+     * required by the linear solver: The Jacobian matrix and its overlapping copy are
+     * still allocated because the preconditioner is set up from them.
+     */
+    static bool supportsJacobianFreeNewton()
+    { return true; }
+
     /*!
      * \brief Causes the solve() method to discared the structure of the linear system of
      *        equations the next time it is called.
@@ -240,6 +322,7 @@ public:
         // equations to the overlapping one. On ther border, we add up
         // the values of all processes (using the assignAdd() methods)
         overlappingMatrix_->assignAdd(M);
+        matrixIsPrepared_ = true;
     }
 
     void prepareRhs(const Matrix& M, Vector &b)
@@ -262,33 +345,56 @@ public:
     /*!
      * \brief Actually solve the linear system of equations.
      *
+     * If Jacobian-free Newton-Krylov is enabled and prepareMatrix() has not been called
+     * since the last invocation of this method, the matrix which is available is
+     * considered to be outdated. In this case, it is only used for preconditioning and
+     * the Jacobian is applied via the directional derivatives of the residual.
+     *
+     * The preconditioner is kept between calls and only set up anew if the matrix was
+     * changed more than PreconditionerMaxAge times since its last set up.
+     *
      * \return true if the residual reduction could be achieved, else false.
      */
     bool solve(Vector &x)
     {
+        bool jacobianFree =
+            EWOMS_GET_PARAM(TypeTag, bool, EnableJacobianFreeNewton)
+            && !matrixIsPrepared_;
+        if (matrixIsPrepared_)
+            ++ preconditionerAge_;
+        matrixIsPrepared_ = false;
+
         Scalar oldSingularLimit = Dune::FMatrixPrecision<Scalar>::singular_limit();
         Dune::FMatrixPrecision<Scalar>::set_singular_limit(1e-50);
 
         (*overlappingx_) = 0.0;
 
-        int preconditionerIsReady = 1;
-        try {
-            // update sequential preconditioner
-            precWrapper_.prepare(*overlappingMatrix_);
-        }
-        catch (const Dune::Exception &e) {
-            std::cout << "Preconditioner threw exception \"" << e.what()
-                      << " on rank " << overlappingMatrix_->overlap().myRank()
-                      << "\n"  << std::flush;
-            preconditionerIsReady = 0;
-        }
+        int maxPreconditionerAge = EWOMS_GET_PARAM(TypeTag, int, PreconditionerMaxAge);
+        if (!preconditionerIsPrepared_ || preconditionerAge_ > maxPreconditionerAge) {
+            cleanupPreconditioner_();
 
-        // make sure that the preconditioner is also ready on all peer
-        // ranks.
-        preconditionerIsReady = simulator_.gridView().comm().min(preconditionerIsReady);
-        if (!preconditionerIsReady) {
-            Dune::FMatrixPrecision<Scalar>::set_singular_limit(oldSingularLimit);
-            return false;
+            int preconditionerIsReady = 1;
+            try {
+                // update sequential preconditioner
+                precWrapper_.prepare(*overlappingMatrix_);
+                preconditionerIsPrepared_ = true;
+                preconditionerAge_ = 0;
+            }
+            catch (const Dune::Exception &e) {
+                std::cout << "Preconditioner threw exception \"" << e.what()
+                          << " on rank " << overlappingMatrix_->overlap().myRank()
+                          << "\n"  << std::flush;
+                preconditionerIsReady = 0;
+            }
+
+            // make sure that the preconditioner is also ready on all peer
+            // ranks.
+            preconditionerIsReady = simulator_.gridView().comm().min(preconditionerIsReady);
+            if (!preconditionerIsReady) {
+                cleanupPreconditioner_();
+                Dune::FMatrixPrecision<Scalar>::set_singular_limit(oldSingularLimit);
+                return false;
+            }
         }
 
         // create the parallel preconditioner
@@ -298,9 +404,16 @@ public:
         // create the parallel scalar product and the parallel operator
         ParallelScalarProduct parScalarProduct(overlappingMatrix_->overlap());
         ParallelOperator parOperator(*overlappingMatrix_);
+        std::unique_ptr<JacobianFreeOperator> jacobianFreeOperator;
+        if (jacobianFree)
+            jacobianFreeOperator.reset(new JacobianFreeOperator(simulator_,
+                                                                overlappingMatrix_->overlap()));
 
         // retrieve the linear solver
-        auto &solver = solverWrapper_.get(parOperator, parScalarProduct, parPreCond);
+        auto &solver =
+            jacobianFree
+            ? solverWrapper_.get(*jacobianFreeOperator, parScalarProduct, parPreCond)
+            : solverWrapper_.get(parOperator, parScalarProduct, parPreCond);
 
         /////
         // create a residual reduction convergence criterion
@@ -317,7 +430,7 @@ public:
             }
         }
 
-        Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+        Scalar linearSolverTolerance = linearSolverTolerance_(residWeightVec);
         Scalar linearSolverAbsTolerance = simulator_.model().newtonMethod().tolerance() / 100.0;
         Scalar linearSolverFixPointTolerance = 100*std::numeric_limits<Scalar>::epsilon();
         typedef typename GridView::CollectiveCommunication Comm;
@@ -342,18 +455,22 @@ public:
         try {
             solver.apply(*overlappingx_, *overlappingb_, result);
             solverSucceeded = simulator_.gridView().comm().min(solverSucceeded);
+
+            // the weighted residual of the linearized system which has been achieved
+            lastLinearResidual_ = convCrit->accuracy();
         }
         catch (const Dune::Exception &) {
             solverSucceeded = 0;
             solverSucceeded = simulator_.gridView().comm().min(solverSucceeded);
         }
 
-        // free the unneeded memory of the sequential preconditioner
-        // and the linear solver
+        // free the unneeded memory of the linear solver. the sequential
+        // preconditioner is kept for the next invocation unless the solver
+        // failed.
         solverWrapper_.cleanup();
-        precWrapper_.cleanup();
 
         if (!solverSucceeded) {
+            cleanupPreconditioner_();
             Dune::FMatrixPrecision<Scalar>::set_singular_limit(oldSingularLimit);
             return false;
         }
@@ -376,6 +493,67 @@ private:
     const Implementation &asImp_() const
     { return *static_cast<const Implementation *>(this); }
 
+    // determine the tolerance of the linear solver. if the Eisenstat-Walker method is
+    // used, this is the forcing term of the inexact Newton method, else it is fixed.
+    Scalar linearSolverTolerance_(const OverlappingVector &residWeightVec)
+    {
+        Scalar minTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+        int choice = EWOMS_GET_PARAM(TypeTag, int, LinearSolverEisenstatWalker);
+        if (choice != 1 && choice != 2)
+            return minTolerance;
+
+        Scalar maxTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverMaxTolerance);
+        const auto &newtonMethod = simulator_.model().newtonMethod();
+
+        // calculate the weighted maximum norm of the non-linear residual. this is the
+        // same norm as the one used by the convergence criterion.
+        Scalar residual = 0.0;
+        for (unsigned rowIdx = 0; rowIdx < overlappingb_->size(); ++rowIdx)
+            for (int eqIdx = 0; eqIdx < Vector::block_type::dimension; ++eqIdx)
+                residual = std::max<Scalar>(residual,
+                                            residWeightVec[rowIdx][eqIdx]
+                                            *std::abs((*overlappingb_)[rowIdx][eqIdx]));
+        residual = simulator_.gridView().comm().max(residual);
+
+        Scalar forcingTerm;
+        if (newtonMethod.numIterations() == 0 || lastNonlinearResidual_ <= 0.0)
+            forcingTerm = std::min<Scalar>(0.5, maxTolerance);
+        else if (choice == 1) {
+            // choice 1: how well did the linearization of the last iteration predict
+            // the current residual?
+            forcingTerm =
+                std::abs(residual - lastLinearResidual_)
+                / lastNonlinearResidual_;
+
+            Scalar safeguard = std::pow(lastForcingTerm_, (1.0 + std::sqrt(5.0))/2);
+            if (safeguard > 0.1)
+                forcingTerm = std::max(forcingTerm, safeguard);
+        }
+        else {
+            // choice 2: use the reduction of the residual of the last iteration
+            const Scalar gamma = 0.9;
+            const Scalar alpha = 2.0;
+            forcingTerm = gamma*std::pow(residual/lastNonlinearResidual_, alpha);
+
+            Scalar safeguard = gamma*std::pow(lastForcingTerm_, alpha);
+            if (safeguard > 0.1)
+                forcingTerm = std::max(forcingTerm, safeguard);
+        }
+
+        // do not solve much more accurately than required by the Newton method
+        Scalar newtonTolerance = newtonMethod.tolerance();
+        forcingTerm = std::max(forcingTerm,
+                               0.5*newtonTolerance/std::max<Scalar>(residual, 1e-100));
+
+        forcingTerm = std::min(forcingTerm, maxTolerance);
+        forcingTerm = std::max(forcingTerm, minTolerance);
+
+        lastNonlinearResidual_ = residual;
+        lastForcingTerm_ = forcingTerm;
+
+        return forcingTerm;
+    }
+
     void prepare_(const Matrix &M)
     {
         // if grid has changed the sequence number has changed too
@@ -395,6 +573,8 @@ private:
                                                    borderListCreator.borderList(),
                                                    borderListCreator.blackList(),
                                                    overlapSize);
+        if (EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity) > 1)
+            overlappingMatrix_->printSetupTimes(std::cout);
 
         // create the overlapping vectors for the residual and the
         // solution
@@ -404,8 +584,21 @@ private:
         // writeOverlapToVTK_();
     }
 
+    void cleanupPreconditioner_()
+    {
+        if (preconditionerIsPrepared_)
+            precWrapper_.cleanup();
+        preconditionerIsPrepared_ = false;
+    }
+
     void cleanup_()
     {
+        // the preconditioner may refer to the overlapping matrix
+        cleanupPreconditioner_();
+
+        // the linear solver may keep vectors which use the overlap
+        solverWrapper_.eraseMatrix();
+
         // create the overlapping Jacobian matrix and vectors
         delete overlappingMatrix_;
         delete overlappingb_;
@@ -453,12 +646,20 @@ private:
         }
     }
 
-    const Simulator &simulator_;
+    Simulator &simulator_;
     int gridSequenceNumber_;
 
     OverlappingMatrix *overlappingMatrix_;
     OverlappingVector *overlappingb_;
     OverlappingVector *overlappingx_;
+    bool matrixIsPrepared_;
+    bool preconditionerIsPrepared_;
+    int preconditionerAge_;
+
+    // the state of the Eisenstat-Walker method
+    Scalar lastNonlinearResidual_;
+    Scalar lastLinearResidual_;
+    Scalar lastForcingTerm_;
 
     PreconditionerWrapper precWrapper_;
     LinearSolverWrapper solverWrapper_;
@@ -508,6 +709,9 @@ private:
         void cleanup()                                                             \
         { delete solver_; }                                                        \
                                                                                    \
+        void eraseMatrix()                                                         \
+        {}                                                                         \
+                                                                                   \
     private:                                                                       \
         ParallelSolver *solver_;                                                   \
     };
@@ -518,10 +722,74 @@ EWOMS_WRAP_ISTL_SOLVER(ConjugatedGradients, Ewoms::CGSolver)
 EWOMS_WRAP_ISTL_SOLVER(BiCGStab, Ewoms::BiCGSTABSolver)
 EWOMS_WRAP_ISTL_SOLVER(MinRes, Ewoms::MINRESSolver)
 EWOMS_WRAP_ISTL_SOLVER(RestartedGMRes, Ewoms::RestartedGMResSolver)
+EWOMS_WRAP_ISTL_SOLVER(PipelinedConjugatedGradients, Ewoms::PipelinedCGSolver)
+EWOMS_WRAP_ISTL_SOLVER(PipelinedBiCGStab, Ewoms::PipelinedBiCGSTABSolver)
 
 #undef EWOMS_WRAP_ISTL_SOLVER
 #undef EWOMS_ISTL_SOLVER_TYPDEF
 
+/*!
+ * \brief Wraps the GMRES solver which recycles a deflation subspace.
+ *
+ * In contrast to the other solvers, the state of this solver is not completely
+ * discarded after a linear system has been solved: The recycled subspace is kept by
+ * the wrapper and used by the next solve, e.g., in the next Newton iteration. It is
+ * only thrown away if the structure of the linear system changes.
+ */
+template <class TypeTag>
+class SolverWrapperRecyclingGMRes
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+
+    typedef Ewoms::RecyclingGMResSolver<OverlappingVector> ParallelSolver;
+    typedef typename ParallelSolver::RecycleSpace RecycleSpace;
+
+public:
+    SolverWrapperRecyclingGMRes()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, int, GMResRestart,
+                             "The number of iterations after which the GMRES solver "
+                             "is restarted");
+        EWOMS_REGISTER_PARAM(TypeTag, int, GMResRecycledVectors,
+                             "The maximum number of vectors which the GMRES solver "
+                             "recycles between solves");
+    }
+
+    template <class LinearOperator, class ScalarProduct, class Preconditioner>
+    ParallelSolver &get(LinearOperator &parOperator,
+                        ScalarProduct &parScalarProduct,
+                        Preconditioner &parPreCond)
+    {
+        Scalar tolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+        int maxIter = EWOMS_GET_PARAM(TypeTag, int, LinearSolverMaxIterations);
+        int restart = EWOMS_GET_PARAM(TypeTag, int, GMResRestart);
+        recycleSpace_.setMaxSize(EWOMS_GET_PARAM(TypeTag, int, GMResRecycledVectors));
+
+        int verbosity = 0;
+        if (parOperator.overlap().myRank() == 0)
+            verbosity = EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity);
+        solver_ = new ParallelSolver(parOperator, parScalarProduct, parPreCond,
+                                     recycleSpace_, tolerance, restart, maxIter,
+                                     verbosity);
+
+        return *solver_;
+    }
+
+    void cleanup()
+    { delete solver_; }
+
+    void eraseMatrix()
+    { recycleSpace_.clear(); }
+
+private:
+    RecycleSpace recycleSpace_;
+    ParallelSolver *solver_;
+};
+
 #define EWOMS_WRAP_ISTL_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE)               \
     template <class TypeTag>                                                    \
     class PreconditionerWrapper##PREC_NAME                                      \
@@ -615,6 +883,149 @@ EWOMS_WRAP_ISTL_PRECONDITIONER(ILUm, Dune::SeqILUn)
 EWOMS_WRAP_ISTL_PRECONDITIONER(Solver, Ewoms::Linear::SolverPreconditioner)
 
 #undef EWOMS_WRAP_ISTL_PRECONDITIONER
+
+/*!
+ * \brief Specifies whether the constructor of a preconditioner expects an order
+ *        argument after the matrix.
+ */
+template <template <class, class, class, int> class PreCond>
+struct PreconditionerHasOrder
+{ static const bool value = true; };
+
+template <>
+struct PreconditionerHasOrder<Dune::SeqILU0>
+{ static const bool value = false; };
+
+/*!
+ * \brief Wraps a sequential preconditioner which uses single precision internally.
+ *
+ * \tparam FloatPreCond The template of the preconditioner which is applied in single
+ *                      precision (e.g., Dune::SeqILU0)
+ */
+template <class TypeTag, template <class, class, class, int> class FloatPreCond>
+class PreconditionerWrapperFloat
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) JacobianMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+
+    static const bool hasOrder = PreconditionerHasOrder<FloatPreCond>::value;
+
+public:
+    typedef Ewoms::Linear::MixedPrecisionPreconditioner<JacobianMatrix,
+                                                        OverlappingVector,
+                                                        OverlappingVector,
+                                                        FloatPreCond> SequentialPreconditioner;
+
+    PreconditionerWrapperFloat()
+    {}
+
+    static void registerParameters()
+    {
+        if (hasOrder)
+            EWOMS_REGISTER_PARAM(TypeTag, int, PreconditionerOrder,
+                                 "The order of the preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+    }
+
+    void prepare(JacobianMatrix &matrix)
+    {
+        float relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        seqPreCond_ = create_(matrix, relaxationFactor, std::integral_constant<bool, hasOrder>());
+    }
+
+    SequentialPreconditioner &get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    { delete seqPreCond_; }
+
+private:
+    static SequentialPreconditioner *create_(JacobianMatrix &matrix,
+                                             float relaxationFactor,
+                                             std::true_type)
+    {
+        int order = EWOMS_GET_PARAM(TypeTag, int, PreconditionerOrder);
+        return new SequentialPreconditioner(matrix, order, relaxationFactor);
+    }
+
+    static SequentialPreconditioner *create_(JacobianMatrix &matrix,
+                                             float relaxationFactor,
+                                             std::false_type)
+    { return new SequentialPreconditioner(matrix, relaxationFactor); }
+
+    SequentialPreconditioner *seqPreCond_;
+};
+
+//! The SSOR preconditioner applied in single precision
+template <class TypeTag>
+class PreconditionerWrapperFloatSSOR
+    : public PreconditionerWrapperFloat<TypeTag, Dune::SeqSSOR>
+{};
+
+//! The ILU(0) preconditioner applied in single precision
+template <class TypeTag>
+class PreconditionerWrapperFloatILU0
+    : public PreconditionerWrapperFloat<TypeTag, Dune::SeqILU0>
+{};
+
+//! The ILU(n) preconditioner applied in single precision
+template <class TypeTag>
+class PreconditionerWrapperFloatILUn
+    : public PreconditionerWrapperFloat<TypeTag, Dune::SeqILUn>
+{};
+
+/*!
+ * \brief Wraps the multi-threaded ILU(0) preconditioner.
+ *
+ * The level sets used to parallelize the preconditioner only depend on the sparsity
+ * pattern of the matrix, so they are kept by the wrapper and only recomputed if the
+ * pattern changes.
+ */
+template <class TypeTag>
+class PreconditionerWrapperThreadedILU0
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) JacobianMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
+
+public:
+    typedef Ewoms::Linear::ThreadedILU0<JacobianMatrix,
+                                        OverlappingVector,
+                                        OverlappingVector> SequentialPreconditioner;
+
+    PreconditionerWrapperThreadedILU0()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the "
+                             "preconditioner");
+    }
+
+    void prepare(JacobianMatrix &matrix)
+    {
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        schedule_.update(matrix);
+        seqPreCond_ = new SequentialPreconditioner(matrix,
+                                                   schedule_,
+                                                   relaxationFactor,
+                                                   ThreadManager::maxThreads());
+    }
+
+    SequentialPreconditioner &get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    { delete seqPreCond_; }
+
+private:
+    TriangularLevelSchedule schedule_;
+    SequentialPreconditioner *seqPreCond_;
+};
 } // namespace Linear
 } // namespace Ewoms
 
@@ -632,6 +1043,9 @@ SET_INT_PROP(ParallelIterativeLinearSolver, PreconditionerOrder, 0);
 //! set the GMRes restart parameter to 10 by default
 SET_INT_PROP(ParallelIterativeLinearSolver, GMResRestart, 10);
 
+//! recycle up to 5 vectors between the solves of the recycling GMRes solver by default
+SET_INT_PROP(ParallelIterativeLinearSolver, GMResRecycledVectors, 5);
+
 SET_TYPE_PROP(ParallelIterativeLinearSolver, OverlappingMatrix,
               Ewoms::Linear::OverlappingBCRSMatrix<typename GET_PROP_TYPE(
                   TypeTag, JacobianMatrix)>);
@@ -670,6 +1084,15 @@ SET_SCALAR_PROP(ParallelIterativeLinearSolver, LinearSolverOverlapSize, 2);
 
 //! set the default number of maximum iterations for the linear solver
 SET_INT_PROP(ParallelIterativeLinearSolver, LinearSolverMaxIterations, 250);
+
+//! set up the preconditioner for every new matrix by default
+SET_INT_PROP(ParallelIterativeLinearSolver, PreconditionerMaxAge, 0);
+
+//! use a fixed tolerance for the linear solver by default
+SET_INT_PROP(ParallelIterativeLinearSolver, LinearSolverEisenstatWalker, 0);
+
+//! the default maximum tolerance of the Eisenstat-Walker method
+SET_SCALAR_PROP(ParallelIterativeLinearSolver, LinearSolverMaxTolerance, 0.9);
 } // namespace Properties
 } // namespace Ewoms
 
@@ -86,12 +86,33 @@ public:
         curDefect_ = initialDefect_;
     }
 
+    /*!
+     * \copydoc ConvergenceCriterion::setInitial(const Vector &, const Vector &, Scalar)
+     */
+    void setInitial(const Vector &curSol, const Vector &curResid, Scalar curResidNorm)
+    {
+        initialDefect_ = std::max<Scalar>(curResidNorm, 1e-20);
+        curDefect_ = initialDefect_;
+    }
+
     /*!
      * \copydoc ConvergenceCriterion::update(const Vector &, const Vector &)
      */
     void update(const Vector &curSol, const Vector &curResid)
     { curDefect_ = scalarProduct_.norm(curResid); }
 
+    /*!
+     * \copydoc ConvergenceCriterion::update(const Vector &, const Vector &, Scalar)
+     */
+    void update(const Vector &curSol, const Vector &curResid, Scalar curResidNorm)
+    { curDefect_ = curResidNorm; }
+
+    /*!
+     * \copydoc ConvergenceCriterion::usesResidualNorm()
+     */
+    bool usesResidualNorm() const
+    { return true; }
+
     /*!
      * \copydoc ConvergenceCriterion::converged()
      */
@@ -47,6 +47,7 @@
 #ifndef EWOMS_SOLVERS_HH
 #define EWOMS_SOLVERS_HH
 
+#include <cassert>
 #include <cmath>
 #include <complex>
 #include <iostream>
@@ -58,6 +59,8 @@
 #include "residreductioncriterion.hh"
 #include "weightedresidreductioncriterion.hh"
 #include "fixpointcriterion.hh"
+#include "fusedscalarproduct.hh"
+#include "vectorkernels.hh"
 
 #include <dune/common/version.hh>
 #include <dune/istl/istlexception.hh>
@@ -468,6 +471,207 @@ private:
 
 
 
+/*!
+  \brief Computes several scalar products using as few global reductions as
+         possible.
+
+  If the scalar product is a Linear::FusedScalarProduct, the local parts of all
+  scalar products which were added since the last call to finish() are computed
+  in a single pass over the vectors and summed up using a single (possibly
+  non-blocking) reduction. The global maxima required by the convergence
+  criterion are determined by the same reduction. Otherwise, each scalar product
+  is computed separately by ScalarProduct::dot() and the convergence criterion
+  does its own communication.
+*/
+template <class X>
+class ScalarProductBatch
+{
+    enum { maxProducts = 8 };
+    enum { maxMaxima = 4 };
+
+public:
+    typedef typename X::field_type field_type;
+
+    ScalarProductBatch(Dune::ScalarProduct<X>& sp)
+        : _sp(sp)
+        , _fusedSp(dynamic_cast<Linear::FusedScalarProduct<X>*>(&sp))
+        , _numProducts(0)
+        , _numMaxima(0)
+        , _critMaxIdx(-1)
+    {}
+
+    /*!
+      \brief Add the scalar product of two vectors to the batch and return its index.
+
+      The vectors must not be modified until start() has been called.
+    */
+    int add(const X& x, const X& y)
+    {
+        assert(_numProducts < maxProducts);
+        _x[_numProducts] = &x;
+        _y[_numProducts] = &y;
+        return _numProducts++;
+    }
+
+    /*!
+      \brief Compute \f$ y_1 \leftarrow y_1 + a_1 x_1 \f$ and \f$ y_2 \leftarrow
+             y_2 + a_2 x_2 \f$, add \f$ (y_2, y_2) \f$ to the batch and return its
+             index.
+
+      If possible, the local part of the scalar product is computed in the same
+      pass over the vectors as the updates.
+    */
+    int axpy2AndAddNorm2(X& y1, field_type a1, const X& x1,
+                         X& y2, field_type a2, const X& x2)
+    {
+        if (!_fusedSp) {
+            Linear::VectorKernels::axpy2(y1, a1, x1, y2, a2, x2);
+            return add(y2, y2);
+        }
+
+        assert(_numProducts < maxProducts);
+        _x[_numProducts] = 0;
+        _y[_numProducts] = 0;
+        _local[_numProducts] =
+            Linear::VectorKernels::axpy2Norm2(y1, a1, x1, y2, a2, x2,
+                                              _fusedSp->ownerMask());
+        return _numProducts++;
+    }
+
+    /*!
+      \brief Add the process-local errors of a convergence criterion for a given
+             solution and residual to the batch.
+
+      The errors are only added if their global maxima can be determined by the
+      reduction of the batch. In any case, updateCriterion() must be called with
+      the same vectors after finish().
+    */
+    void addCriterion(const ConvergenceCriterion<X>& crit, const X& x, const X& r)
+    {
+        int n = crit.numLocalMaxima();
+        if (!_fusedSp || n == 0)
+            return;
+
+        assert(_numMaxima + n <= maxMaxima);
+        _critMaxIdx = _numMaxima;
+        crit.localMaxima(x, r, _localMax + _numMaxima);
+        _numMaxima += n;
+    }
+
+    /*!
+      \brief Update a convergence criterion after finish() has been called.
+
+      If the errors of the criterion were added to the batch, their global maxima
+      are passed to the criterion, so it does not need to communicate.
+    */
+    void updateCriterion(ConvergenceCriterion<X>& crit,
+                         const X& x,
+                         const X& r,
+                         field_type residNorm)
+    {
+        if (_critMaxIdx >= 0)
+            crit.update(x, r, residNorm, _maxResult + _critMaxIdx);
+        else
+            crit.update(x, r, residNorm);
+        _critMaxIdx = -1;
+    }
+
+    //! \brief Start computing all scalar products of the batch.
+    void start()
+    {
+        if (!_fusedSp) {
+            for (int i = 0; i < _numProducts; ++i)
+                _result[i] = _sp.dot(*_x[i], *_y[i]);
+            return;
+        }
+
+        // compute the local parts of the scalar products which have not been
+        // computed yet using a single pass over the vectors
+        const X* x[maxProducts];
+        const X* y[maxProducts];
+        int idx[maxProducts];
+        int numPending = 0;
+        for (int i = 0; i < _numProducts; ++i) {
+            if (!_x[i])
+                continue;
+            x[numPending] = _x[i];
+            y[numPending] = _y[i];
+            idx[numPending] = i;
+            ++numPending;
+        }
+
+        field_type local[maxProducts];
+        Linear::VectorKernels::dots(x, y, local, numPending, _fusedSp->ownerMask());
+        for (int i = 0; i < numPending; ++i)
+            _local[idx[i]] = local[i];
+
+        _fusedSp->reduceStart(_local, _result, _numProducts,
+                              _localMax, _maxResult, _numMaxima);
+    }
+
+    //! \brief Wait until the results are available and clear the batch.
+    void finish()
+    {
+        if (_fusedSp)
+            _fusedSp->reduceFinish();
+        _numProducts = 0;
+        _numMaxima = 0;
+    }
+
+    //! \brief Return the result of a scalar product after finish() has been called.
+    field_type operator[](int i) const
+    { return _result[i]; }
+
+    /*!
+      \brief Update the solution and the residual of a Krylov method and pass them
+             to a convergence criterion.
+
+      This computes \f$ x \leftarrow x + a\,\Delta x \f$ and \f$ r \leftarrow r +
+      b\,\Delta r \f$ using a single pass over the vectors. If the convergence
+      criterion uses the norm of the residual, it is computed in the same pass.
+      The norm and the global maxima required by the criterion are determined
+      using a single reduction.
+    */
+    void updateSolution(ConvergenceCriterion<X>& crit,
+                        X& x, field_type a, const X& dx,
+                        X& r, field_type b, const X& dr)
+    {
+        bool foldMaxima = _fusedSp && crit.numLocalMaxima() > 0;
+        if (!crit.usesResidualNorm() && !foldMaxima) {
+            Linear::VectorKernels::axpy2(x, a, dx, r, b, dr);
+            crit.update(x, r);
+            return;
+        }
+
+        int normIdx = -1;
+        if (crit.usesResidualNorm())
+            normIdx = axpy2AndAddNorm2(x, a, dx, r, b, dr);
+        else
+            Linear::VectorKernels::axpy2(x, a, dx, r, b, dr);
+        addCriterion(crit, x, r);
+        start();
+        finish();
+
+        field_type residNorm = 0.0;
+        if (normIdx >= 0)
+            residNorm = std::sqrt(std::abs((*this)[normIdx]));
+        updateCriterion(crit, x, r, residNorm);
+    }
+
+private:
+    Dune::ScalarProduct<X>& _sp;
+    Linear::FusedScalarProduct<X>* _fusedSp;
+    const X* _x[maxProducts];
+    const X* _y[maxProducts];
+    field_type _local[maxProducts];
+    field_type _result[maxProducts];
+    field_type _localMax[maxMaxima];
+    field_type _maxResult[maxMaxima];
+    int _numProducts;
+    int _numMaxima;
+    int _critMaxIdx;
+};
+
 //! \brief conjugate gradient method
 template <class X>
 class CGSolver : public InverseOperator<X, X>
@@ -553,6 +757,7 @@ public:
 
         // some local variables
         field_type rho, rholast, lambda, alpha, beta;
+        ScalarProductBatch<X> batch(_sp);
 
         // determine initial search direction
         p = 0; // clear correction
@@ -566,11 +771,9 @@ public:
             _op.apply(p, q); // q=Ap
             alpha = _sp.dot(p, q); // scalar product
             lambda = rholast/alpha; // minimization
-            x.axpy(lambda, p); // update solution
-            b.axpy(-lambda, q); // update defect
 
-            // convergence test
-            this->convergenceCriterion().update(x, b);
+            // update solution and defect and test for convergence
+            batch.updateSolution(this->convergenceCriterion(), x, lambda, p, b, -lambda, q);
             if (_verbose > 1) // print
                 this->convergenceCriterion().print(i);
             if (this->convergenceCriterion().converged()) {
@@ -710,6 +913,8 @@ public:
         alpha = 1;
         omega = 1;
 
+        ScalarProductBatch<X> batch(_sp);
+
         this->convergenceCriterion().setInitial(x, r);
         if (_verbose > 0)
         {
@@ -753,9 +958,8 @@ public:
                 p = r;
             else {
                 beta = (rho_new / rho) * (alpha / omega);
-                p.axpy(-omega, v); // p = r + beta (p - omega*v)
-                p *= beta;
-                p += r;
+                // p = r + beta (p - omega*v)
+                Linear::VectorKernels::linearCombination(p, 1.0, r, -beta*omega, v, beta);
             }
 
             // y = W^-1 * p
@@ -775,15 +979,10 @@ public:
 
             // apply first correction to x
             // x <- x + alpha y
-            x.axpy(alpha, y);
-
             // r = r - alpha*v
-            r.axpy(-alpha, v);
-
             //
-            // test stop criteria
-            //
-            this->convergenceCriterion().update(x, r);
+            // and test stop criteria
+            batch.updateSolution(this->convergenceCriterion(), x, alpha, y, r, -alpha, v);
             if (_verbose > 1) // print
                 this->convergenceCriterion().print(it);
             if (this->convergenceCriterion().converged()) {
@@ -800,21 +999,20 @@ public:
             _op.apply(y, t);
 
             // omega = < t, r > / < t, t >
-            omega = _sp.dot(t, r) / _sp.dot(t, t);
+            int trIdx = batch.add(t, r);
+            int ttIdx = batch.add(t, t);
+            batch.start();
+            batch.finish();
+            omega = batch[trIdx] / batch[ttIdx];
 
             // apply second correction to x
             // x <- x + omega y
-            x.axpy(omega, y);
-
             // r = s - omega*t (remember : r = s)
-            r.axpy(-omega, t);
+            //
+            // and test stop criteria
+            batch.updateSolution(this->convergenceCriterion(), x, omega, y, r, -omega, t);
 
             rho = rho_new;
-
-            //
-            // test stop criteria
-            //
-            this->convergenceCriterion().update(x, r);
             if (_verbose > 1) // print
                 this->convergenceCriterion().print(it);
             if (this->convergenceCriterion().converged()) {
@@ -827,12 +1025,450 @@ public:
         it = std::min(static_cast<double>(_maxit), it);
 
         if (_verbose == 1) // printing for non verbose
-            this->convergenceCriterion().print(it);
+            this->convergenceCriterion().print(it);
+
+        _prec.post(x); // postprocess preconditioner
+        res.iterations = static_cast<int>(std::ceil(it)); // fill statistics
+        res.reduction = this->convergenceCriterion().accuracy();
+        res.conv_rate = std::pow(res.reduction, 1.0/res.iterations);
+        res.elapsed = watch.elapsed();
+    }
+
+private:
+    Dune::SeqScalarProduct<X> ssp;
+    Dune::LinearOperator<X, X> &_op;
+    Dune::Preconditioner<X, X> &_prec;
+    Dune::ScalarProduct<X> &_sp;
+    std::shared_ptr<ConvergenceCriterion> convergenceCriterion_;
+    int _maxit;
+    int _verbose;
+};
+
+/*!
+  \brief Pipelined preconditioned conjugate gradient method
+
+  This is a variant of the CG method which only requires a single global
+  reduction per iteration. This reduction is overlapped with the application
+  of the preconditioner and of the operator. Mathematically, the method is
+  equivalent to the CG method, but it requires more vectors and is slightly
+  less stable. For details, see
+
+  P. Ghysels, W. Vanroose: "Hiding global synchronization latency in the
+  preconditioned Conjugate Gradient algorithm", Parallel Computing, 40(7),
+  pp. 224-238, 2014
+*/
+template <class X>
+class PipelinedCGSolver : public InverseOperator<X, X>
+{
+    typedef Ewoms::ConvergenceCriterion<X> ConvergenceCriterion;
+
+public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted.
+    typedef typename X::field_type field_type;
+    //! \brief The real type of the field type (is the same if using real numbers, but differs for std::complex)
+    typedef typename Dune::FieldTraits<field_type>::real_type real_type;
+
+    /*!
+      \brief Set up the pipelined conjugate gradient solver.
+
+      \copydoc LoopSolver::LoopSolver(L&, P&, double, int, int)
+    */
+    template <class L, class P>
+    PipelinedCGSolver(L& op, P& prec, real_type reduction, int maxit, int verbose) :
+        ssp(), _op(op), _prec(prec), _sp(ssp), _maxit(maxit), _verbose(verbose)
+    {
+        static_assert(static_cast<int>(L::category) == static_cast<int>(P::category),
+                      "L and P must have the same category!");
+        static_assert(static_cast<int>(L::category) == static_cast<int>(Dune::SolverCategory::sequential),
+                      "L must be sequential!");
+
+        auto crit = std::make_shared<ResidReductionCriterion<X>>(_sp, reduction);
+        this->setConvergenceCriterion(crit);
+    }
+    /*!
+      \brief Set up the pipelined conjugate gradient solver.
+
+      \copydoc LoopSolver::LoopSolver(L&, S&, P&, double, int, int)
+    */
+    template <class L, class S, class P>
+    PipelinedCGSolver(L& op, S& sp, P& prec, real_type reduction, int maxit, int verbose) :
+        _op(op), _prec(prec), _sp(sp), _maxit(maxit), _verbose(verbose)
+    {
+        static_assert(static_cast<int>(L::category) == static_cast<int>(P::category),
+                      "L and P must have the same category!");
+        static_assert(static_cast<int>(L::category) == static_cast<int>(S::category),
+                      "L and S must have the same category!");
+
+        auto crit = std::make_shared<ResidReductionCriterion<X>>(_sp, reduction);
+        this->setConvergenceCriterion(crit);
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&, Y&, InverseOperatorResult&)
+    */
+    virtual void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+    {
+        res.clear(); // clear solver statistics
+        Dune::Timer watch; // start a timer
+        _prec.pre(x, b); // prepare preconditioner
+        _op.applyscaleadd(-1, x, b); // overwrite b with defect
+
+        X& r = b;
+        X u(x); // the preconditioned residual
+        X w(x); // w = A u
+        X m(x); // m = M^-1 w
+        X n(x); // n = A m
+        X p(x); // the search direction
+        X s(x); // s = A p
+        X q(x); // q = M^-1 s
+        X z(x); // z = A q
+
+        this->convergenceCriterion().setInitial(x, r);
+        if (_verbose > 0)
+        {
+            std::cout << "=== PipelinedCGSolver" << std::endl << std::flush;
+            if (_verbose > 1)
+                this->convergenceCriterion().printInitial();
+        }
+        if (this->convergenceCriterion().converged()) {
+            // fill statistics
+            res.converged = true;
+            res.iterations = 0;
+            res.reduction = this->convergenceCriterion().accuracy();
+            res.conv_rate = 0;
+            res.elapsed = 0;
+            return;
+        }
+
+        u = 0;
+        _prec.apply(u, r); // u = M^-1 r
+        _op.apply(u, w); // w = A u
+
+        p = 0;
+        s = 0;
+        q = 0;
+        z = 0;
+
+        // some local variables
+        field_type gamma, gammaLast = 1, delta, alpha = 1, beta;
+        ScalarProductBatch<X> batch(_sp);
+
+        // the loop
+        int i = 0;
+        for (; i < _maxit; i++) {
+            // start the global reduction
+            int gammaIdx = batch.add(r, u);
+            int deltaIdx = batch.add(w, u);
+            int rNormIdx = batch.add(r, r);
+            if (i > 0)
+                batch.addCriterion(this->convergenceCriterion(), x, r);
+            batch.start();
+
+            // overlap the reduction with the preconditioner and the operator
+            m = 0;
+            _prec.apply(m, w); // m = M^-1 w
+            _op.apply(m, n); // n = A m
+
+            batch.finish();
+            gamma = batch[gammaIdx];
+            delta = batch[deltaIdx];
+
+            // convergence test. since the norm of the residual is only known
+            // after the reduction, the test lags behind by one update of the
+            // solution
+            if (i > 0) {
+                batch.updateCriterion(this->convergenceCriterion(), x, r,
+                                      std::sqrt(std::abs(batch[rNormIdx])));
+                if (_verbose > 1) // print
+                    this->convergenceCriterion().print(i);
+                if (this->convergenceCriterion().converged()) {
+                    res.converged = true;
+                    break;
+                }
+            }
+
+            if (i > 0) {
+                beta = gamma/gammaLast;
+                alpha = gamma/(delta - beta*gamma/alpha);
+            }
+            else {
+                beta = 0;
+                alpha = gamma/delta;
+            }
+            gammaLast = gamma;
+
+            // update the recurrences
+            Linear::VectorKernels::aypx2(z, beta, n, q, m); // z = n + beta z, q = m + beta q
+            Linear::VectorKernels::aypx2(s, beta, w, p, u); // s = w + beta s, p = u + beta p
+
+            // update solution and defect
+            Linear::VectorKernels::axpy2(x, alpha, p, r, -alpha, s);
+            // update preconditioned defect and w = A u
+            Linear::VectorKernels::axpy2(u, -alpha, q, w, -alpha, z);
+        }
+
+        //correct i which is wrong if convergence was not achieved.
+        i = std::min(_maxit, i);
+
+        if (_verbose == 1) // printing for non verbose
+            this->convergenceCriterion().print(i);
+
+        _prec.post(x); // postprocess preconditioner
+        res.iterations = i; // fill statistics
+        res.reduction = this->convergenceCriterion().accuracy();
+        res.conv_rate = std::pow(res.reduction, 1.0/std::max(res.iterations, 1));
+        res.elapsed = watch.elapsed();
+    }
+
+private:
+    Dune::SeqScalarProduct<X> ssp;
+    Dune::LinearOperator<X, X> &_op;
+    Dune::Preconditioner<X, X> &_prec;
+    Dune::ScalarProduct<X> &_sp;
+    int _maxit;
+    int _verbose;
+};
+
+/*!
+  \brief Pipelined Bi-conjugate Gradient Stabilized (p-BiCG-STAB)
+
+  This is a variant of the right-preconditioned BiCG-STAB method which needs
+  two global reductions per iteration instead of five. Each reduction is
+  overlapped with the application of the preconditioner and of the operator.
+  For details, see
+
+  S. Cools, W. Vanroose: "The communication-hiding pipelined BiCGStab method
+  for the parallel solution of large unsymmetric linear systems", Parallel
+  Computing, 65, pp. 1-20, 2017
+*/
+template <class X>
+class PipelinedBiCGSTABSolver : public InverseOperator<X, X>
+{
+    typedef Ewoms::ConvergenceCriterion<X> ConvergenceCriterion;
+
+public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted
+    typedef typename X::field_type field_type;
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2,4)
+    //! \brief The real type of the field type (is the same if using real numbers, but differs for std::complex)
+    typedef typename Dune::FieldTraits<field_type>::real_type real_type;
+#else
+    typedef field_type real_type;
+#endif
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&, P&, double, int, int)
+    */
+    template <class L, class P>
+    PipelinedBiCGSTABSolver(L& op, P& prec,
+                            real_type reduction, int maxit, int verbose) :
+        ssp(), _op(op), _prec(prec), _sp(ssp), _maxit(maxit), _verbose(verbose)
+    {
+        static_assert(static_cast<int>(L::category) == static_cast<int>(P::category),
+                      "L and P must be of the same category!");
+        static_assert(static_cast<int>(L::category) == static_cast<int>(Dune::SolverCategory::sequential),
+                      "L must be sequential!");
+
+        auto crit = std::make_shared<ResidReductionCriterion<X>>(_sp, reduction);
+        this->setConvergenceCriterion(crit);
+    }
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&, S&, P&, double, int, int)
+    */
+    template <class L, class S, class P>
+    PipelinedBiCGSTABSolver(L& op, S& sp, P& prec,
+                            real_type reduction, int maxit, int verbose) :
+        _op(op), _prec(prec), _sp(sp), _maxit(maxit), _verbose(verbose)
+    {
+        static_assert(static_cast<int>(L::category) == static_cast<int>(P::category),
+                      "L and P must have the same category!");
+        static_assert(static_cast<int>(L::category) == static_cast<int>(S::category),
+                      "L and S must have the same category!");
+
+        auto crit = std::make_shared<ResidReductionCriterion<X>>(_sp, reduction);
+        this->setConvergenceCriterion(crit);
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&, Y&, InverseOperatorResult&)
+    */
+    virtual void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+    {
+        const real_type EPSILON = 1e-80;
+
+        // the vectors with a hat are the preconditioned versions of the ones
+        // without, i.e., rHat = M^-1 r. the remaining ones are related by
+        // w = A rHat, t = A wHat, s = A pHat, z = A sHat and v = A zHat
+        X& r = b;
+        X rt(x);
+        X rHat(x);
+        X w(x);
+        X wHat(x);
+        X t(x);
+        X pHat(x);
+        X s(x);
+        X sHat(x);
+        X z(x);
+        X zHat(x);
+        X v(x);
+
+        res.clear(); // clear solver statistics
+        Dune::Timer watch; // start a timer
+        _prec.pre(x, r); // prepare preconditioner
+        _op.applyscaleadd(-1, x, r); // overwrite b with defect
+
+        this->convergenceCriterion().setInitial(x, r);
+        if (_verbose > 0)
+        {
+            std::cout << "=== PipelinedBiCGSTABSolver" << std::endl << std::flush;
+            if (_verbose > 1)
+                this->convergenceCriterion().printInitial();
+        }
+        if (this->convergenceCriterion().converged()) {
+            // fill statistics
+            res.converged = true;
+            res.iterations = 0;
+            res.reduction = this->convergenceCriterion().accuracy();
+            res.conv_rate = 0;
+            res.elapsed = 0;
+            return;
+        }
+
+        rt = r;
+
+        rHat = 0;
+        _prec.apply(rHat, r);
+        _op.apply(rHat, w);
+        wHat = 0;
+        _prec.apply(wHat, w);
+        _op.apply(wHat, t);
+
+        pHat = 0;
+        s = 0;
+        sHat = 0;
+        z = 0;
+        zHat = 0;
+        v = 0;
+
+        ScalarProductBatch<X> batch(_sp);
+        int rtrIdx = batch.add(rt, r);
+        int rtwIdx = batch.add(rt, w);
+        batch.start();
+        batch.finish();
+
+        field_type rtr = batch[rtrIdx];
+        if (std::abs(batch[rtwIdx]) < EPSILON)
+            DUNE_THROW(Dune::ISTLError, "breakdown in pipelined BiCGSTAB - (rt, w) == 0");
+        field_type alpha = rtr/batch[rtwIdx];
+        field_type beta = 0;
+        field_type omega = 1;
+
+        int i = 0;
+        for (; i < _maxit; i++) {
+            // update the search directions
+            Linear::VectorKernels::linearCombination(pHat, 1.0, rHat, -beta*omega, sHat, beta);
+            Linear::VectorKernels::linearCombination(s, 1.0, w, -beta*omega, z, beta);
+            Linear::VectorKernels::linearCombination(sHat, 1.0, wHat, -beta*omega, zHat, beta);
+            Linear::VectorKernels::linearCombination(z, 1.0, t, -beta*omega, v, beta);
+
+            // r becomes q = r - alpha*s, rHat becomes qHat = rHat - alpha*sHat
+            // and w becomes y = w - alpha*z
+            Linear::VectorKernels::axpy2(r, -alpha, s, rHat, -alpha, sHat);
+            w.axpy(-alpha, z);
+
+            // start the first global reduction
+            int qyIdx = batch.add(r, w);
+            int yyIdx = batch.add(w, w);
+            batch.start();
+
+            // overlap it with the preconditioner and the operator
+            zHat = 0;
+            _prec.apply(zHat, z);
+            _op.apply(zHat, v);
+
+            batch.finish();
+            if (std::abs(batch[yyIdx]) < EPSILON)
+                DUNE_THROW(Dune::ISTLError, "breakdown in pipelined BiCGSTAB - (y, y) == 0"
+                           << " after " << i << " iterations");
+            omega = batch[qyIdx]/batch[yyIdx];
+            if (std::abs(omega) <= EPSILON)
+                DUNE_THROW(Dune::ISTLError, "breakdown in pipelined BiCGSTAB - omega "
+                           << omega << " <= EPSILON " << EPSILON
+                           << " after " << i << " iterations");
+
+            // update the solution and the residual
+            Linear::VectorKernels::linearCombination(x, alpha, pHat, omega, rHat, 1.0);
+            r.axpy(-omega, w);
+            Linear::VectorKernels::linearCombination(rHat, -omega, wHat, omega*alpha, zHat, 1.0);
+            Linear::VectorKernels::linearCombination(w, -omega, t, omega*alpha, v, 1.0);
+
+            // start the second global reduction
+            rtrIdx = batch.add(rt, r);
+            rtwIdx = batch.add(rt, w);
+            int rtsIdx = batch.add(rt, s);
+            int rtzIdx = batch.add(rt, z);
+            int rNormIdx = batch.add(r, r);
+            batch.addCriterion(this->convergenceCriterion(), x, r);
+            batch.start();
+
+            // overlap it with the preconditioner and the operator
+            wHat = 0;
+            _prec.apply(wHat, w);
+            _op.apply(wHat, t);
+
+            batch.finish();
+
+            // convergence test
+            batch.updateCriterion(this->convergenceCriterion(), x, r,
+                                  std::sqrt(std::abs(batch[rNormIdx])));
+            if (_verbose > 1) // print
+                this->convergenceCriterion().print(i + 1);
+            if (this->convergenceCriterion().converged()) {
+                res.converged = true;
+                ++i;
+                break;
+            }
+
+            if (std::abs(rtr) <= EPSILON)
+                DUNE_THROW(Dune::ISTLError, "breakdown in pipelined BiCGSTAB - rho "
+                           << rtr << " <= EPSILON " << EPSILON
+                           << " after " << i << " iterations");
+            beta = (alpha/omega)*batch[rtrIdx]/rtr;
+            rtr = batch[rtrIdx];
+
+            field_type denom = batch[rtwIdx] + beta*batch[rtsIdx] - beta*omega*batch[rtzIdx];
+            if (std::abs(denom) < EPSILON)
+                DUNE_THROW(Dune::ISTLError, "breakdown in pipelined BiCGSTAB - h == 0"
+                           << " after " << i << " iterations");
+            alpha = rtr/denom;
+        }
+
+        //correct i which is wrong if convergence was not achieved.
+        i = std::min(_maxit, i);
+
+        if (_verbose == 1) // printing for non verbose
+            this->convergenceCriterion().print(i);
 
         _prec.post(x); // postprocess preconditioner
-        res.iterations = static_cast<int>(std::ceil(it)); // fill statistics
+        res.iterations = i; // fill statistics
         res.reduction = this->convergenceCriterion().accuracy();
-        res.conv_rate = std::pow(res.reduction, 1.0/res.iterations);
+        res.conv_rate = std::pow(res.reduction, 1.0/std::max(res.iterations, 1));
         res.elapsed = watch.elapsed();
     }
 
@@ -841,7 +1477,6 @@ private:
     Dune::LinearOperator<X, X> &_op;
     Dune::Preconditioner<X, X> &_prec;
     Dune::ScalarProduct<X> &_sp;
-    std::shared_ptr<ConvergenceCriterion> convergenceCriterion_;
     int _maxit;
     int _verbose;
 };
@@ -1391,6 +2026,673 @@ private :
     int _verbose;
 };
 
+/**
+   \brief Stores the subspace which is recycled by the RecyclingGMResSolver
+          between calls.
+
+   The subspace is given by a set of vectors which approximate the
+   directions that hamper the convergence of GMRes the most. Since the
+   operator and the preconditioner usually change between calls, only
+   these vectors are kept and their image under the preconditioned
+   operator is recomputed at the beginning of each solve.
+
+   \tparam X vector type of the solution
+*/
+template <class X>
+class GMResRecycleSpace
+{
+public:
+    explicit GMResRecycleSpace(int maxSize = 0)
+        : _maxSize(std::max(maxSize, 0))
+    {}
+
+    //! \brief Set the maximum number of vectors which are recycled.
+    void setMaxSize(int maxSize)
+    {
+        _maxSize = std::max(maxSize, 0);
+        if (static_cast<int>(_u.size()) > _maxSize)
+            _u.erase(_u.begin() + _maxSize, _u.end());
+    }
+
+    //! \brief Returns the maximum number of vectors which are recycled.
+    int maxSize() const
+    { return _maxSize; }
+
+    //! \brief Returns the number of vectors which are currently stored.
+    int size() const
+    { return _u.size(); }
+
+    /*!
+      \brief Discard all recycled vectors.
+
+      This must be called if the structure of the linear system changes.
+    */
+    void clear()
+    { _u.clear(); }
+
+    //! \brief Returns the vectors which span the recycled subspace.
+    std::vector<X> &vectors()
+    { return _u; }
+
+    //! \brief Returns the vectors which span the recycled subspace.
+    const std::vector<X> &vectors() const
+    { return _u; }
+
+private:
+    int _maxSize;
+    std::vector<X> _u;
+};
+
+/**
+   \brief implements a restarted GMRes method which recycles a
+          deflation subspace between calls (GCRO-DR)
+
+   In each cycle, the Arnoldi process is orthogonalized against the
+   image C = W^-1 A U of a small subspace U which is kept by a
+   GMResRecycleSpace object. After each cycle, U is replaced by the
+   directions of the combined space [U V] which correspond to the
+   smallest singular values of the projected (preconditioned) operator,
+   i.e., the directions which slow down the convergence of GMRes.
+
+   Since U is kept by the recycle space and not by the solver, it is
+   still available if the solver is re-created for the next linear
+   system, e.g., in the next Newton iteration. At the beginning of each
+   solve, C is recomputed for the current operator and preconditioner
+   and the initial residual is projected onto the orthogonal complement
+   of C. For sequences of slowly changing linear systems this removes
+   the slowest converging part of the spectrum without having to build
+   it up again by the Krylov iteration.
+
+   The convergence criterion is evaluated using the true residual at
+   the end of each cycle. Within a cycle, the cheap estimate of the
+   preconditioned residual is used to decide when to stop.
+
+   \tparam X vector type of the solution and of the RHS
+*/
+template <class X>
+class RecyclingGMResSolver : public InverseOperator<X, X>
+{
+    typedef Ewoms::ConvergenceCriterion<X> ConvergenceCriterion;
+
+public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted
+    typedef typename X::field_type field_type;
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2,4)
+    //! \brief The real type of the field type (is the same if using real numbers, but differs for std::complex)
+    typedef typename Dune::FieldTraits<field_type>::real_type real_type;
+#else
+    typedef field_type real_type;
+#endif
+    //! \brief The type of the object which stores the recycled subspace
+    typedef GMResRecycleSpace<X> RecycleSpace;
+
+    static_assert(std::is_same<field_type, real_type>::value,
+                  "The recycling GMRes solver only supports real numbers");
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&, P&, double, int, int)
+      \param recycleSpace The object which keeps the recycled subspace
+      \param restart number of GMRes iterations before restart
+    */
+    template <class L, class P>
+    RecyclingGMResSolver(L& op, P& prec, RecycleSpace& recycleSpace,
+                         real_type reduction, int restart, int maxit, int verbose) :
+        _A(op), _W(prec),
+        ssp(), _sp(ssp), _recycleSpace(recycleSpace),
+        _reduction(reduction), _restart(restart),
+        _maxit(maxit), _verbose(verbose)
+    {
+        static_assert(static_cast<int>(P::category) == static_cast<int>(L::category),
+                      "P and L must be the same category!");
+        static_assert(static_cast<int>(L::category) == static_cast<int>(Dune::SolverCategory::sequential),
+                      "L must be sequential!");
+
+        auto crit = std::make_shared<ResidReductionCriterion<X>>(_sp, reduction);
+        this->setConvergenceCriterion(crit);
+    }
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&, S&, P&, double, int, int)
+      \param recycleSpace The object which keeps the recycled subspace
+      \param restart number of GMRes iterations before restart
+    */
+    template <class L, class S, class P>
+    RecyclingGMResSolver(L& op, S& sp, P& prec, RecycleSpace& recycleSpace,
+                         real_type reduction, int restart, int maxit, int verbose) :
+        _A(op), _W(prec),
+        _sp(sp), _recycleSpace(recycleSpace),
+        _reduction(reduction), _restart(restart),
+        _maxit(maxit), _verbose(verbose)
+    {
+        static_assert(static_cast<int>(P::category) == static_cast<int>(L::category),
+                      "P and L must have the same category!");
+        static_assert(static_cast<int>(P::category) == static_cast<int>(S::category),
+                      "P and S must have the same category!");
+
+        auto crit = std::make_shared<ResidReductionCriterion<X>>(_sp, reduction);
+        this->setConvergenceCriterion(crit);
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&, Y&, double, InverseOperatorResult&)
+    */
+    virtual void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+    {
+        const real_type EPSILON = 1e-80;
+        const int m = std::max(_restart, 1);
+        real_type norm, norm_0, target;
+        int j = 1;
+        std::vector<field_type> s(m+1), sn(m);
+        std::vector<real_type> cs(m);
+        // need copy of rhs to compute the true residual after each cycle
+        X b2(b);
+        // helper vector
+        X w(b);
+        std::vector< std::vector<field_type> > H(m+1, std::vector<field_type>(m, 0.0));
+        // the Hessenberg matrix without the Givens rotations applied
+        std::vector< std::vector<field_type> > Hbar(H);
+        // the coefficients of the Arnoldi vectors in the recycled subspace
+        std::vector< std::vector<field_type> > Bk;
+        std::vector<X> v(m+1, b);
+
+        // the recycled subspace and its image under the preconditioned operator
+        std::vector<X>& U = _recycleSpace.vectors();
+        std::vector<X> C;
+
+        // start timer
+        Dune::Timer watch;
+        watch.reset();
+
+        // clear solver statistics and set res.converged to false
+        res.clear();
+        _W.pre(x, b);
+
+        // calculate defect and overwrite rhs with it
+        _A.applyscaleadd(-1.0, x, b); // b -= Ax
+        // calculate preconditioned defect
+        v[0] = 0.0; _W.apply(v[0], b); // r = W^-1 b
+        norm_0 = _sp.norm(v[0]);
+
+        this->convergenceCriterion().setInitial(x, b, norm_0);
+        if (_verbose > 0) {
+            std::cout << "=== RecyclingGMResSolver (" << U.size()
+                      << " recycled vectors)" << std::endl << std::flush;
+            if (_verbose > 1)
+                this->convergenceCriterion().printInitial();
+        }
+        if (this->convergenceCriterion().converged())
+            res.converged = true;
+
+        if (res.converged != true) {
+            // the operator and the preconditioner may have changed since
+            // the recycled vectors were computed, so their image needs to
+            // be determined anew
+            C.assign(U.size(), b);
+            for (unsigned k = 0; k < U.size(); ++k)
+                applyPreconditionedOperator_(U[k], C[k], w);
+            orthonormalize_(U, C);
+
+            // remove the components of the residual which are in the
+            // range of the recycled subspace
+            projectResidual_(x, v[0], U, C);
+        }
+        norm = _sp.norm(v[0]);
+        target = _reduction*norm_0;
+
+        while (j <= _maxit && res.converged != true) {
+            const int nk = C.size();
+            Bk.assign(nk, std::vector<field_type>(m, 0.0));
+
+            int i = 0;
+            if (norm > EPSILON) {
+                v[0] *= 1.0/norm;
+                s[0] = norm;
+                for (i=1; i < m+1; i++)
+                    s[i] = 0.0;
+
+                for (i=0; i < m && j <= _maxit && norm > target; i++, j++) {
+                    w = 0.0;
+                    // use v[i+1] as temporary vector
+                    v[i+1] = 0.0;
+                    // do Arnoldi algorithm
+                    _A.apply(v[i], v[i+1]);
+                    _W.apply(w, v[i+1]);
+
+                    // orthogonalize against the image of the recycled subspace
+                    for (int k=0; k < nk; k++) {
+                        Bk[k][i] = _sp.dot(C[k], w);
+                        w.axpy(-Bk[k][i], C[k]);
+                    }
+
+                    // modified Gram-Schmidt against the Krylov basis
+                    for (int k=0; k < i+1; k++) {
+                        H[k][i] = _sp.dot(v[k], w);
+                        w.axpy(-H[k][i], v[k]);
+                    }
+                    H[i+1][i] = _sp.norm(w);
+                    if (std::abs(H[i+1][i]) < EPSILON)
+                        DUNE_THROW(Dune::ISTLError,
+                                   "breakdown in recycling GMRes - |w| == 0.0 after "
+                                   << j << " iterations");
+
+                    // normalize new vector
+                    v[i+1] = w; v[i+1] *= 1.0/H[i+1][i];
+
+                    for (int k=0; k < i+2; k++)
+                        Hbar[k][i] = H[k][i];
+
+                    // update QR factorization
+                    for (int k=0; k < i; k++)
+                        applyPlaneRotation(H[k][i], H[k+1][i], cs[k], sn[k]);
+
+                    // compute new givens rotation
+                    generatePlaneRotation(H[i][i], H[i+1][i], cs[i], sn[i]);
+                    // finish updating QR factorization
+                    applyPlaneRotation(H[i][i], H[i+1][i], cs[i], sn[i]);
+                    applyPlaneRotation(s[i], s[i+1], cs[i], sn[i]);
+
+                    // norm of the defect is the last component the vector s
+                    norm = std::abs(s[i+1]);
+                } // end for
+
+                // calculate the update of the solution: the Krylov part
+                // minimizes the residual, the recycled part cancels the
+                // components of the Arnoldi vectors within the range of C
+                std::vector<field_type> y(i);
+                backsolve(i, H, s, y);
+                for (int a=0; a < i; a++)
+                    x.axpy(y[a], v[a]);
+                for (int k=0; k < nk; k++) {
+                    field_type alpha = 0.0;
+                    for (int a=0; a < i; a++)
+                        alpha += Bk[k][a]*y[a];
+                    x.axpy(-alpha, U[k]);
+                }
+
+                if (i > 0 && _recycleSpace.maxSize() > 0)
+                    updateRecycleSpace_(i, Hbar, Bk, v, U, C, w);
+            }
+
+            // calculate the true defect of the current iterate
+            b = b2;
+            _A.applyscaleadd(-1.0, x, b); // b -= Ax;
+            v[0] = 0.0;
+            _W.apply(v[0], b);
+            norm = _sp.norm(v[0]);
+
+            this->convergenceCriterion().update(x, b, norm);
+            if (_verbose > 1)
+                this->convergenceCriterion().print(j - 1);
+            if (this->convergenceCriterion().converged()) {
+                res.converged = true;
+                break;
+            }
+
+            if (_verbose > 0)
+                std::cout << "=== RecyclingGMResSolver::restart" << std::endl;
+
+            projectResidual_(x, v[0], U, C);
+            norm = _sp.norm(v[0]);
+            if (norm < EPSILON)
+                break;
+
+            // the estimated residual was too optimistic. ask for another
+            // order of magnitude in the next cycle.
+            target = std::min(target, 0.1*norm);
+        } //end while
+
+        // postprocess preconditioner
+        _W.post(x);
+
+        // save solver statistics
+        res.iterations = j-1; // it has to be j-1!!!
+        res.reduction = this->convergenceCriterion().accuracy();
+        res.conv_rate = std::pow(res.reduction, 1.0/std::max(res.iterations, 1));
+        res.elapsed = watch.elapsed();
+
+        if (_verbose > 0)
+            this->convergenceCriterion().print(j);
+    }
+
+private :
+    // out = W^-1 A u
+    void applyPreconditionedOperator_(const X& u, X& out, X& tmp)
+    {
+        tmp = 0.0;
+        _A.apply(u, tmp);
+        out = 0.0;
+        _W.apply(out, tmp);
+    }
+
+    // x += U C^T r, r -= C C^T r
+    void projectResidual_(X& x, X& r, const std::vector<X>& U, const std::vector<X>& C)
+    {
+        for (unsigned k = 0; k < C.size(); ++k) {
+            field_type alpha = _sp.dot(C[k], r);
+            x.axpy(alpha, U[k]);
+            r.axpy(-alpha, C[k]);
+        }
+    }
+
+    // orthonormalize C using modified Gram-Schmidt and apply the same
+    // transformations to U so that W^-1 A U = C still holds. vectors which
+    // are numerically linear dependent on the previous ones are dropped.
+    void orthonormalize_(std::vector<X>& U, std::vector<X>& C)
+    {
+        unsigned n = 0;
+        for (unsigned a = 0; a < C.size(); ++a) {
+            real_type origNorm = _sp.norm(C[a]);
+            for (unsigned k = 0; k < n; ++k) {
+                field_type h = _sp.dot(C[k], C[a]);
+                C[a].axpy(-h, C[k]);
+                U[a].axpy(-h, U[k]);
+            }
+
+            real_type norm = _sp.norm(C[a]);
+            if (!std::isfinite(norm) || norm <= 1e-10*origNorm || norm < 1e-80)
+                continue;
+
+            C[a] *= 1.0/norm;
+            U[a] *= 1.0/norm;
+            if (n != a) {
+                C[n] = C[a];
+                U[n] = U[a];
+            }
+            ++n;
+        }
+
+        C.erase(C.begin() + n, C.end());
+        U.erase(U.begin() + n, U.end());
+    }
+
+    // replace the recycled subspace by the directions y = [U V_i] z which
+    // minimize |W^-1 A y|/|y|, i.e., by approximations of the right singular
+    // vectors of the preconditioned operator for its smallest singular
+    // values. since W^-1 A [U V_i] = [C V_{i+1}] G holds and [C V_{i+1}] is
+    // orthonormal, this amounts to the small symmetric generalized eigenvalue
+    // problem G^T G z = theta M z where M is the Gram matrix of [U V_i].
+    //
+    // (the original GCRO-DR method uses harmonic Ritz vectors here, which
+    // requires the solution of a non-symmetric generalized eigenvalue
+    // problem. the singular vectors target the same directions but only
+    // require symmetric dense linear algebra.)
+    void updateRecycleSpace_(int i,
+                             const std::vector<std::vector<field_type> >& Hbar,
+                             const std::vector<std::vector<field_type> >& Bk,
+                             const std::vector<X>& v,
+                             std::vector<X>& U,
+                             std::vector<X>& C,
+                             const X& tmpl)
+    {
+        const int nk = C.size();
+        const int nCols = nk + i;
+        const int nRows = nk + i + 1;
+        const int kNew = std::min(_recycleSpace.maxSize(), nCols);
+
+        // assemble G = [[I, Bk], [0, Hbar]]
+        std::vector<std::vector<real_type> > G(nRows, std::vector<real_type>(nCols, 0.0));
+        for (int a = 0; a < nk; ++a) {
+            G[a][a] = 1.0;
+            for (int c = 0; c < i; ++c)
+                G[a][nk + c] = Bk[a][c];
+        }
+        for (int r = 0; r < i + 1; ++r)
+            for (int c = 0; c < i; ++c)
+                G[nk + r][nk + c] = Hbar[r][c];
+
+        std::vector<std::vector<real_type> > GTG(nCols, std::vector<real_type>(nCols, 0.0));
+        for (int a = 0; a < nCols; ++a)
+            for (int c = a; c < nCols; ++c) {
+                real_type tmp = 0.0;
+                for (int r = 0; r < nRows; ++r)
+                    tmp += G[r][a]*G[r][c];
+                GTG[a][c] = GTG[c][a] = tmp;
+            }
+
+        // Gram matrix of [U V_i]. the Arnoldi vectors are orthonormal, so
+        // only the products involving U need to be computed.
+        std::vector<std::vector<real_type> > L(nCols, std::vector<real_type>(nCols, 0.0));
+        for (int a = 0; a < nk; ++a) {
+            for (int c = a; c < nk; ++c)
+                L[a][c] = L[c][a] = _sp.dot(U[a], U[c]);
+            for (int c = 0; c < i; ++c)
+                L[a][nk + c] = L[nk + c][a] = _sp.dot(U[a], v[c]);
+        }
+        for (int c = 0; c < i; ++c)
+            L[nk + c][nk + c] = 1.0;
+
+        // reduce the problem to a standard one using the Cholesky
+        // factorization M = L L^T: (L^-1 G^T G L^-T) w = theta w, z = L^-T w
+        choleskyFactorization_(L);
+        for (int c = 0; c < nCols; ++c)
+            forwardSubstitution_(L, GTG, c);
+        for (int a = 0; a < nCols; ++a)
+            for (int c = a + 1; c < nCols; ++c)
+                std::swap(GTG[a][c], GTG[c][a]);
+        for (int c = 0; c < nCols; ++c)
+            forwardSubstitution_(L, GTG, c);
+
+        std::vector<real_type> lambda;
+        std::vector<std::vector<real_type> > Z;
+        symmetricEigenDecomposition_(GTG, lambda, Z);
+        for (int c = 0; c < nCols; ++c)
+            backwardSubstitution_(L, Z, c);
+
+        std::vector<int> order(nCols);
+        for (int a = 0; a < nCols; ++a)
+            order[a] = a;
+        std::sort(order.begin(), order.end(),
+                  [&lambda](int a, int c) { return lambda[a] < lambda[c]; });
+
+        // U_new = [U V_i] z and C_new = [C V_{i+1}] G z
+        std::vector<X> newU(kNew, tmpl);
+        std::vector<X> newC(kNew, tmpl);
+        for (int l = 0; l < kNew; ++l) {
+            const int col = order[l];
+
+            newU[l] = 0.0;
+            for (int a = 0; a < nk; ++a)
+                newU[l].axpy(Z[a][col], U[a]);
+            for (int c = 0; c < i; ++c)
+                newU[l].axpy(Z[nk + c][col], v[c]);
+
+            newC[l] = 0.0;
+            for (int r = 0; r < nRows; ++r) {
+                real_type gz = 0.0;
+                for (int a = 0; a < nCols; ++a)
+                    gz += G[r][a]*Z[a][col];
+                if (r < nk)
+                    newC[l].axpy(gz, C[r]);
+                else
+                    newC[l].axpy(gz, v[r - nk]);
+            }
+        }
+
+        orthonormalize_(newU, newC);
+        U.swap(newU);
+        C.swap(newC);
+    }
+
+    // in-place Cholesky factorization of a small symmetric positive definite
+    // matrix. only the lower triangle of the result is used. pivots which are
+    // (numerically) zero are regularized, the affected directions end up with
+    // a negligible weight.
+    static void choleskyFactorization_(std::vector<std::vector<real_type> >& M)
+    {
+        const int n = M.size();
+        for (int c = 0; c < n; ++c) {
+            real_type d = M[c][c];
+            for (int k = 0; k < c; ++k)
+                d -= M[c][k]*M[c][k];
+            d = std::sqrt(std::max<real_type>(d, 1e-14*std::max<real_type>(M[c][c], 1e-80)));
+            M[c][c] = d;
+
+            for (int r = c + 1; r < n; ++r) {
+                real_type tmp = M[r][c];
+                for (int k = 0; k < c; ++k)
+                    tmp -= M[r][k]*M[c][k];
+                M[r][c] = tmp/d;
+            }
+        }
+    }
+
+    // overwrite column c of B by the solution of L y = B[:, c]
+    static void forwardSubstitution_(const std::vector<std::vector<real_type> >& L,
+                                     std::vector<std::vector<real_type> >& B,
+                                     int c)
+    {
+        const int n = L.size();
+        for (int r = 0; r < n; ++r) {
+            real_type tmp = B[r][c];
+            for (int k = 0; k < r; ++k)
+                tmp -= L[r][k]*B[k][c];
+            B[r][c] = tmp/L[r][r];
+        }
+    }
+
+    // overwrite column c of B by the solution of L^T y = B[:, c]
+    static void backwardSubstitution_(const std::vector<std::vector<real_type> >& L,
+                                      std::vector<std::vector<real_type> >& B,
+                                      int c)
+    {
+        const int n = L.size();
+        for (int r = n - 1; r >= 0; --r) {
+            real_type tmp = B[r][c];
+            for (int k = r + 1; k < n; ++k)
+                tmp -= L[k][r]*B[k][c];
+            B[r][c] = tmp/L[r][r];
+        }
+    }
+
+    // eigenvalues and eigenvectors of a small symmetric matrix using the
+    // cyclic Jacobi method. the eigenvectors are the columns of Z.
+    static void symmetricEigenDecomposition_(std::vector<std::vector<real_type> >& M,
+                                             std::vector<real_type>& lambda,
+                                             std::vector<std::vector<real_type> >& Z)
+    {
+        const int n = M.size();
+        Z.assign(n, std::vector<real_type>(n, 0.0));
+        for (int a = 0; a < n; ++a)
+            Z[a][a] = 1.0;
+
+        for (int sweep = 0; sweep < 50; ++sweep) {
+            real_type offDiag = 0.0;
+            real_type diag = 0.0;
+            for (int p = 0; p < n; ++p) {
+                diag += M[p][p]*M[p][p];
+                for (int q = p + 1; q < n; ++q)
+                    offDiag += M[p][q]*M[p][q];
+            }
+            if (offDiag <= 1e-30*diag)
+                break;
+
+            for (int p = 0; p < n; ++p) {
+                for (int q = p + 1; q < n; ++q) {
+                    if (M[p][q] == 0.0)
+                        continue;
+
+                    real_type theta = (M[q][q] - M[p][p])/(2*M[p][q]);
+                    real_type t = 1.0/(std::abs(theta) + std::sqrt(theta*theta + 1.0));
+                    if (theta < 0.0)
+                        t = -t;
+                    real_type c = 1.0/std::sqrt(t*t + 1.0);
+                    real_type s = t*c;
+
+                    for (int k = 0; k < n; ++k) {
+                        real_type mkp = M[k][p];
+                        real_type mkq = M[k][q];
+                        M[k][p] = c*mkp - s*mkq;
+                        M[k][q] = s*mkp + c*mkq;
+                    }
+                    for (int k = 0; k < n; ++k) {
+                        real_type mpk = M[p][k];
+                        real_type mqk = M[q][k];
+                        M[p][k] = c*mpk - s*mqk;
+                        M[q][k] = s*mpk + c*mqk;
+                    }
+                    for (int k = 0; k < n; ++k) {
+                        real_type zkp = Z[k][p];
+                        real_type zkq = Z[k][q];
+                        Z[k][p] = c*zkp - s*zkq;
+                        Z[k][q] = s*zkp + c*zkq;
+                    }
+                }
+            }
+        }
+
+        lambda.resize(n);
+        for (int a = 0; a < n; ++a)
+            lambda[a] = M[a][a];
+    }
+
+    void backsolve(int i,
+                   const std::vector<std::vector<field_type> >& H,
+                   const std::vector<field_type>& s,
+                   std::vector<field_type>& y)
+    {
+        for (int a=i-1; a >=0; a--) {
+            field_type rhs(s[a]);
+            for (int b=a+1; b < i; b++)
+                rhs -= H[a][b]*y[b];
+            y[a] = rhs/H[a][a];
+        }
+    }
+
+    void
+    generatePlaneRotation(field_type& dx, field_type& dy, real_type& cs, field_type& sn)
+    {
+        real_type norm_dx = std::abs(dx);
+        real_type norm_dy = std::abs(dy);
+        if (norm_dy < 1e-15) {
+            cs = 1.0;
+            sn = 0.0;
+        } else if (norm_dx < 1e-15) {
+            cs = 0.0;
+            sn = 1.0;
+        } else if (norm_dy > norm_dx) {
+            real_type temp = norm_dx/norm_dy;
+            cs = 1.0/std::sqrt(1.0 + temp*temp);
+            sn = cs;
+            cs *= temp;
+            sn *= dx/norm_dx;
+            sn *= dy/norm_dy;
+        } else {
+            real_type temp = norm_dy/norm_dx;
+            cs = 1.0/std::sqrt(1.0 + temp*temp);
+            sn = cs;
+            sn *= dy/dx;
+        }
+    }
+
+    void
+    applyPlaneRotation(field_type& dx, field_type& dy, real_type& cs, field_type& sn)
+    {
+        field_type temp = cs * dx + sn * dy;
+        dy = -sn * dx + cs * dy;
+        dx = temp;
+    }
+
+    Dune::LinearOperator<X, X> &_A;
+    Dune::Preconditioner<X, X> &_W;
+    Dune::SeqScalarProduct<X> ssp;
+    Dune::ScalarProduct<X> &_sp;
+    RecycleSpace &_recycleSpace;
+    real_type _reduction;
+    int _restart;
+    int _maxit;
+    int _verbose;
+};
+
 
 /**
  * @brief Generalized preconditioned conjugate gradient solver.
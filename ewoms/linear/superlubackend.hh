@@ -74,6 +74,15 @@ public:
                              "The verbosity level of the linear solver");
     }
 
+    /*!
+     * \brief Returns true if the backend is able to apply the Jacobian matrix without
+     *        an up-to-date assembled matrix.
+     *
+     * Direct solvers always require the assembled matrix.
+     */
+    static bool supportsJacobianFreeNewton()
+    { return false; }
+
     /*!
      * \brief Causes the solve() method to discared the structure of the linear system of
      *        equations the next time it is called.
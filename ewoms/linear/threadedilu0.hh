@@ -0,0 +1,365 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::ThreadedILU0
+ */
+#ifndef EWOMS_THREADED_ILU0_HH
+#define EWOMS_THREADED_ILU0_HH
+
+#include <dune/istl/istlexception.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/common/exceptions.hh>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief The level sets of the lower and upper triangular parts of a sparse matrix.
+ *
+ * The rows of a level only depend on the rows of previous levels. Thus, the rows of
+ * each level can be processed in parallel by triangular solves and by an incomplete LU
+ * factorization. Since the levels only depend on the sparsity pattern of the matrix,
+ * they only need to be computed anew if the pattern changes.
+ */
+class TriangularLevelSchedule
+{
+public:
+    TriangularLevelSchedule()
+        : numRows_(0)
+        , numNonzeros_(0)
+        , checksum_(0)
+    {}
+
+    /*!
+     * \brief Compute the level sets for the sparsity pattern of a matrix if it differs
+     *        from the one for which the schedule was computed last.
+     */
+    template <class Matrix>
+    void update(const Matrix &matrix)
+    {
+        size_t checksum = patternChecksum_(matrix);
+        if (matrix.N() == numRows_
+            && matrix.nonzeroes() == numNonzeros_
+            && checksum == checksum_)
+            return;
+
+        numRows_ = matrix.N();
+        numNonzeros_ = matrix.nonzeroes();
+        checksum_ = checksum;
+
+        std::vector<int> rowLevel(numRows_);
+
+        // the level of a row of the lower triangle is one more than the largest level
+        // of the rows it depends on
+        for (size_t rowIdx = 0; rowIdx < numRows_; ++rowIdx) {
+            int level = 0;
+            const auto &row = matrix[rowIdx];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt && colIt.index() < rowIdx; ++colIt)
+                level = std::max(level, rowLevel[colIt.index()] + 1);
+            rowLevel[rowIdx] = level;
+        }
+        createLevels_(lowerRows_, lowerLevelStart_, rowLevel);
+
+        // the same for the upper triangle, which is processed from the last row to the
+        // first one
+        for (size_t rowIdx = numRows_; rowIdx > 0; --rowIdx) {
+            int level = 0;
+            const auto &row = matrix[rowIdx - 1];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt; ++colIt)
+                if (colIt.index() >= rowIdx)
+                    level = std::max(level, rowLevel[colIt.index()] + 1);
+            rowLevel[rowIdx - 1] = level;
+        }
+        createLevels_(upperRows_, upperLevelStart_, rowLevel);
+    }
+
+    //! The number of levels of the lower triangle
+    size_t numLowerLevels() const
+    { return lowerLevelStart_.size() - 1; }
+
+    //! The rows of the lower triangle sorted by their level
+    const std::vector<int> &lowerRows() const
+    { return lowerRows_; }
+
+    //! The index of the first row of each level of the lower triangle in lowerRows()
+    const std::vector<int> &lowerLevelStart() const
+    { return lowerLevelStart_; }
+
+    //! The number of levels of the upper triangle
+    size_t numUpperLevels() const
+    { return upperLevelStart_.size() - 1; }
+
+    //! The rows of the upper triangle sorted by their level
+    const std::vector<int> &upperRows() const
+    { return upperRows_; }
+
+    //! The index of the first row of each level of the upper triangle in upperRows()
+    const std::vector<int> &upperLevelStart() const
+    { return upperLevelStart_; }
+
+private:
+    template <class Matrix>
+    static size_t patternChecksum_(const Matrix &matrix)
+    {
+        size_t checksum = 0;
+        for (size_t rowIdx = 0; rowIdx < matrix.N(); ++rowIdx) {
+            const auto &row = matrix[rowIdx];
+            const auto &colEndIt = row.end();
+            for (auto colIt = row.begin(); colIt != colEndIt; ++colIt)
+                checksum = checksum*31 + colIt.index();
+        }
+        return checksum;
+    }
+
+    static void createLevels_(std::vector<int> &rows,
+                              std::vector<int> &levelStart,
+                              const std::vector<int> &rowLevel)
+    {
+        int numLevels = 0;
+        for (size_t rowIdx = 0; rowIdx < rowLevel.size(); ++rowIdx)
+            numLevels = std::max(numLevels, rowLevel[rowIdx] + 1);
+
+        // count the rows of each level and compute the offsets using a prefix sum
+        levelStart.assign(numLevels + 1, 0);
+        for (size_t rowIdx = 0; rowIdx < rowLevel.size(); ++rowIdx)
+            ++ levelStart[rowLevel[rowIdx] + 1];
+        for (int levelIdx = 0; levelIdx < numLevels; ++levelIdx)
+            levelStart[levelIdx + 1] += levelStart[levelIdx];
+
+        std::vector<int> nextRow(levelStart.begin(), levelStart.end() - 1);
+        rows.resize(rowLevel.size());
+        for (size_t rowIdx = 0; rowIdx < rowLevel.size(); ++rowIdx)
+            rows[nextRow[rowLevel[rowIdx]]++] = static_cast<int>(rowIdx);
+    }
+
+    size_t numRows_;
+    size_t numNonzeros_;
+    size_t checksum_;
+
+    std::vector<int> lowerRows_;
+    std::vector<int> lowerLevelStart_;
+    std::vector<int> upperRows_;
+    std::vector<int> upperLevelStart_;
+};
+
+/*!
+ * \brief A block ILU(0) preconditioner which uses multiple threads.
+ *
+ * The factorization and the triangular solves are the same as those of
+ * Dune::SeqILU0, but the rows are processed in the order given by a
+ * TriangularLevelSchedule. All rows of a level are processed in parallel.
+ */
+template <class Matrix, class DomainVector, class RangeVector>
+class ThreadedILU0 : public Dune::Preconditioner<DomainVector, RangeVector>
+{
+    typedef typename Matrix::block_type MatrixBlock;
+    typedef typename DomainVector::block_type VectorBlock;
+
+public:
+    typedef DomainVector domain_type;
+    typedef RangeVector range_type;
+    typedef typename DomainVector::field_type field_type;
+
+    enum { category = Dune::SolverCategory::sequential };
+
+    /*!
+     * \brief Create the preconditioner and compute the factorization.
+     *
+     * \param matrix The matrix to be factorized
+     * \param schedule The level sets for the sparsity pattern of the matrix
+     * \param relaxationFactor The factor by which the result is scaled
+     * \param numThreads The number of threads to be used
+     */
+    ThreadedILU0(const Matrix &matrix,
+                 const TriangularLevelSchedule &schedule,
+                 field_type relaxationFactor,
+                 int numThreads)
+        : ilu_(matrix)
+        , schedule_(schedule)
+        , relaxationFactor_(relaxationFactor)
+        , numThreads_(std::max(1, numThreads))
+    { decompose_(); }
+
+    void pre(domain_type &x, range_type &b)
+    {}
+
+    void apply(domain_type &v, const range_type &d)
+    {
+        const auto &lowerRows = schedule_.lowerRows();
+        const auto &lowerLevelStart = schedule_.lowerLevelStart();
+        const auto &upperRows = schedule_.upperRows();
+        const auto &upperLevelStart = schedule_.upperLevelStart();
+        size_t numLowerLevels = schedule_.numLowerLevels();
+        size_t numUpperLevels = schedule_.numUpperLevels();
+        int numRows = ilu_.N();
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads_)
+#endif
+        {
+            // forward substitution with the lower triangle, which has a unit diagonal
+            for (size_t levelIdx = 0; levelIdx < numLowerLevels; ++levelIdx) {
+                int levelBegin = lowerLevelStart[levelIdx];
+                int levelEnd = lowerLevelStart[levelIdx + 1];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int i = levelBegin; i < levelEnd; ++i) {
+                    int rowIdx = lowerRows[i];
+                    VectorBlock rhs(d[rowIdx]);
+                    const auto &row = ilu_[rowIdx];
+                    const auto &colEndIt = row.end();
+                    for (auto colIt = row.begin();
+                         colIt != colEndIt && colIt.index() < unsigned(rowIdx);
+                         ++colIt)
+                        colIt->mmv(v[colIt.index()], rhs);
+                    v[rowIdx] = rhs;
+                }
+            }
+
+            // backward substitution with the upper triangle. the inverses of the
+            // diagonal blocks are stored by the factorization.
+            for (size_t levelIdx = 0; levelIdx < numUpperLevels; ++levelIdx) {
+                int levelBegin = upperLevelStart[levelIdx];
+                int levelEnd = upperLevelStart[levelIdx + 1];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int i = levelBegin; i < levelEnd; ++i) {
+                    int rowIdx = upperRows[i];
+                    VectorBlock rhs(v[rowIdx]);
+                    const auto &row = ilu_[rowIdx];
+                    const auto &diagIt = row.find(rowIdx);
+                    const auto &colEndIt = row.end();
+                    auto colIt = diagIt;
+                    for (++colIt; colIt != colEndIt; ++colIt)
+                        colIt->mmv(v[colIt.index()], rhs);
+                    diagIt->mv(rhs, v[rowIdx]);
+                }
+            }
+
+            // scale the result only after the whole system has been solved. (scaling
+            // the rows within the backward substitution would make the remaining rows
+            // use the relaxed values, which is not what Dune::SeqILU0 does.)
+            if (relaxationFactor_ != 1.0) {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                    v[rowIdx] *= relaxationFactor_;
+            }
+        }
+    }
+
+    void post(domain_type &x)
+    {}
+
+private:
+    void decompose_()
+    {
+        const auto &lowerRows = schedule_.lowerRows();
+        const auto &lowerLevelStart = schedule_.lowerLevelStart();
+        size_t numLowerLevels = schedule_.numLowerLevels();
+
+        int missingDiagonal = 0;
+
+        // a row only depends on the rows of its lower triangle, so the factorization
+        // can use the same levels as the forward substitution
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads_)
+#endif
+        for (size_t levelIdx = 0; levelIdx < numLowerLevels; ++levelIdx) {
+            int levelBegin = lowerLevelStart[levelIdx];
+            int levelEnd = lowerLevelStart[levelIdx + 1];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int i = levelBegin; i < levelEnd; ++i) {
+                int rowIdx = lowerRows[i];
+                auto &row = ilu_[rowIdx];
+                const auto &rowEndIt = row.end();
+
+                auto ijIt = row.begin();
+                for (; ijIt != rowEndIt && ijIt.index() < unsigned(rowIdx); ++ijIt) {
+                    // the diagonal blocks of previous rows have already been inverted
+                    const auto &rowJ = ilu_[ijIt.index()];
+                    auto jjIt = rowJ.find(ijIt.index());
+                    ijIt->rightmultiply(*jjIt);
+
+                    // update the remaining entries of the row
+                    auto jkIt = jjIt;
+                    ++jkIt;
+                    const auto &rowJEndIt = rowJ.end();
+                    auto ikIt = ijIt;
+                    ++ikIt;
+                    while (ikIt != rowEndIt && jkIt != rowJEndIt) {
+                        if (ikIt.index() == jkIt.index()) {
+                            MatrixBlock tmp(*jkIt);
+                            tmp.leftmultiply(*ijIt);
+                            *ikIt -= tmp;
+                            ++ikIt;
+                            ++jkIt;
+                        }
+                        else if (ikIt.index() < jkIt.index())
+                            ++ikIt;
+                        else
+                            ++jkIt;
+                    }
+                }
+
+                if (ijIt == rowEndIt || ijIt.index() != unsigned(rowIdx)) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+                    missingDiagonal = 1;
+                    continue;
+                }
+
+                ijIt->invert();
+            }
+        }
+
+        if (missingDiagonal)
+            DUNE_THROW(Dune::ISTLError, "ILU(0): diagonal entry missing");
+    }
+
+    Matrix ilu_;
+    const TriangularLevelSchedule &schedule_;
+    field_type relaxationFactor_;
+    int numThreads_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,377 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::VectorKernels
+ */
+#ifndef EWOMS_VECTOR_KERNELS_HH
+#define EWOMS_VECTOR_KERNELS_HH
+
+#include <dune/istl/bvector.hh>
+#include <dune/common/fvector.hh>
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+
+//! \cond SKIP
+template <class K, int n, class A>
+std::true_type isFieldBlockVector_(const Dune::BlockVector<Dune::FieldVector<K, n>, A> *);
+std::false_type isFieldBlockVector_(...);
+//! \endcond
+
+/*!
+ * \brief Specifies whether a vector type stores its entries in a contiguous array,
+ *        i.e., if it is (derived from) a Dune::BlockVector of Dune::FieldVectors.
+ */
+template <class Vector>
+struct IsFieldBlockVector
+    : public decltype(isFieldBlockVector_(std::declval<const Vector *>()))
+{};
+
+/*!
+ * \brief Fused vector operations for the Krylov solvers.
+ *
+ * The vector operations of Krylov solvers are limited by the memory bandwidth. Each of
+ * the kernels of this class combines several BLAS-1 operations into a single pass over
+ * the vectors, so the entries which are used by more than one operation only need to
+ * be loaded once.
+ *
+ * For vectors which store their entries contiguously (see IsFieldBlockVector), the
+ * kernels work on the underlying arrays of scalars using loops which can be vectorized
+ * by the compiler. If OpenMP is available, the loops are distributed over the threads
+ * of the process, i.e., the number of threads which was set by the ThreadManager is
+ * used. For all other vector types, the kernels fall back to the operations of the
+ * vectors.
+ *
+ * The kernels which compute scalar products only determine the local contributions of
+ * the rows which are selected by a mask, i.e., the contributions of the other
+ * processes must be added by the caller. If the mask is null, all rows are considered.
+ */
+class VectorKernels
+{
+    // the minimum number of scalars of a vector for which a kernel is run in parallel
+    enum { minParallelSize = 16384 };
+
+public:
+    /*!
+     * \brief Compute \f$ y_1 \leftarrow y_1 + a_1 x_1 \f$ and \f$ y_2 \leftarrow y_2 +
+     *        a_2 x_2 \f$ in a single pass.
+     */
+    template <class Vector, class Scalar>
+    static void axpy2(Vector &y1, Scalar a1, const Vector &x1,
+                      Vector &y2, Scalar a2, const Vector &x2)
+    { axpy2_(y1, a1, x1, y2, a2, x2, IsFieldBlockVector<Vector>()); }
+
+    /*!
+     * \brief Compute \f$ y_1 \leftarrow y_1 + a_1 x_1 \f$ and \f$ y_2 \leftarrow y_2 +
+     *        a_2 x_2 \f$ and return the local part of \f$ (y_2, y_2) \f$.
+     *
+     * This is the update of the solution and of the residual of the Krylov methods
+     * combined with the computation of the norm of the new residual.
+     */
+    template <class Vector, class Scalar>
+    static Scalar axpy2Norm2(Vector &y1, Scalar a1, const Vector &x1,
+                             Vector &y2, Scalar a2, const Vector &x2,
+                             const unsigned char *mask)
+    { return axpy2Norm2_(y1, a1, x1, y2, a2, x2, mask, IsFieldBlockVector<Vector>()); }
+
+    /*!
+     * \brief Compute \f$ y_1 \leftarrow x_1 + b y_1 \f$ and \f$ y_2 \leftarrow x_2 +
+     *        b y_2 \f$ in a single pass.
+     *
+     * This is the update of the recurrences of the search directions.
+     */
+    template <class Vector, class Scalar>
+    static void aypx2(Vector &y1, Scalar b, const Vector &x1,
+                      Vector &y2, const Vector &x2)
+    { aypx2_(y1, b, x1, y2, x2, IsFieldBlockVector<Vector>()); }
+
+    /*!
+     * \brief Compute \f$ z \leftarrow a x + b y + c z \f$ in a single pass.
+     */
+    template <class Vector, class Scalar>
+    static void linearCombination(Vector &z,
+                                  Scalar a, const Vector &x,
+                                  Scalar b, const Vector &y,
+                                  Scalar c)
+    { linearCombination_(z, a, x, b, y, c, IsFieldBlockVector<Vector>()); }
+
+    /*!
+     * \brief Compute the local parts of several scalar products in a single pass.
+     *
+     * \param x The first vector of each scalar product
+     * \param y The second vector of each scalar product
+     * \param result The array to which the results are written
+     * \param numProducts The number of scalar products
+     * \param mask The rows which are considered (all rows if null)
+     */
+    template <class Vector, class Scalar>
+    static void dots(const Vector *const *x,
+                     const Vector *const *y,
+                     Scalar *result,
+                     int numProducts,
+                     const unsigned char *mask)
+    { dots_(x, y, result, numProducts, mask, IsFieldBlockVector<Vector>()); }
+
+private:
+    template <class Vector>
+    static typename Vector::field_type *data_(Vector &v)
+    { return v.size() > 0 ? &v[0][0] : 0; }
+
+    template <class Vector>
+    static const typename Vector::field_type *data_(const Vector &v)
+    { return v.size() > 0 ? &v[0][0] : 0; }
+
+    ////////////////
+    // implementations for contiguous vectors
+    ////////////////
+    template <class Vector, class Scalar>
+    static void axpy2_(Vector &y1, Scalar a1, const Vector &x1,
+                       Vector &y2, Scalar a2, const Vector &x2,
+                       std::true_type)
+    {
+        typedef typename Vector::field_type Field;
+        const int n = static_cast<int>(y1.size()*Vector::block_type::dimension);
+        Field *y1Data = data_(y1);
+        const Field *x1Data = data_(x1);
+        Field *y2Data = data_(y2);
+        const Field *x2Data = data_(x2);
+
+#ifdef _OPENMP
+#pragma omp parallel for if (n > minParallelSize)
+#endif
+        for (int i = 0; i < n; ++i) {
+            y1Data[i] += a1*x1Data[i];
+            y2Data[i] += a2*x2Data[i];
+        }
+    }
+
+    template <class Vector, class Scalar>
+    static void aypx2_(Vector &y1, Scalar b, const Vector &x1,
+                       Vector &y2, const Vector &x2,
+                       std::true_type)
+    {
+        typedef typename Vector::field_type Field;
+        const int n = static_cast<int>(y1.size()*Vector::block_type::dimension);
+        Field *y1Data = data_(y1);
+        const Field *x1Data = data_(x1);
+        Field *y2Data = data_(y2);
+        const Field *x2Data = data_(x2);
+
+#ifdef _OPENMP
+#pragma omp parallel for if (n > minParallelSize)
+#endif
+        for (int i = 0; i < n; ++i) {
+            y1Data[i] = x1Data[i] + b*y1Data[i];
+            y2Data[i] = x2Data[i] + b*y2Data[i];
+        }
+    }
+
+    template <class Vector, class Scalar>
+    static Scalar axpy2Norm2_(Vector &y1, Scalar a1, const Vector &x1,
+                              Vector &y2, Scalar a2, const Vector &x2,
+                              const unsigned char *mask,
+                              std::true_type)
+    {
+        typedef typename Vector::field_type Field;
+        static const int blockSize = Vector::block_type::dimension;
+        const int numRows = static_cast<int>(y1.size());
+        Field *y1Data = data_(y1);
+        const Field *x1Data = data_(x1);
+        Field *y2Data = data_(y2);
+        const Field *x2Data = data_(x2);
+
+        Scalar sum = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sum) if (numRows*blockSize > minParallelSize)
+#endif
+        for (int rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            Scalar rowSum = 0.0;
+            const int offset = rowIdx*blockSize;
+            for (int i = offset; i < offset + blockSize; ++i) {
+                y1Data[i] += a1*x1Data[i];
+                y2Data[i] += a2*x2Data[i];
+                rowSum += y2Data[i]*y2Data[i];
+            }
+
+            // multiply instead of branching to allow vectorization
+            sum += (mask ? mask[rowIdx] : 1)*rowSum;
+        }
+
+        return sum;
+    }
+
+    template <class Vector, class Scalar>
+    static void linearCombination_(Vector &z,
+                                   Scalar a, const Vector &x,
+                                   Scalar b, const Vector &y,
+                                   Scalar c,
+                                   std::true_type)
+    {
+        typedef typename Vector::field_type Field;
+        const int n = static_cast<int>(z.size()*Vector::block_type::dimension);
+        Field *zData = data_(z);
+        const Field *xData = data_(x);
+        const Field *yData = data_(y);
+
+#ifdef _OPENMP
+#pragma omp parallel for if (n > minParallelSize)
+#endif
+        for (int i = 0; i < n; ++i)
+            zData[i] = a*xData[i] + b*yData[i] + c*zData[i];
+    }
+
+    template <class Vector, class Scalar>
+    static void dots_(const Vector *const *x,
+                      const Vector *const *y,
+                      Scalar *result,
+                      int numProducts,
+                      const unsigned char *mask,
+                      std::true_type)
+    {
+        typedef typename Vector::field_type Field;
+        static const int blockSize = Vector::block_type::dimension;
+
+        for (int prodIdx = 0; prodIdx < numProducts; ++prodIdx)
+            result[prodIdx] = 0.0;
+        if (numProducts == 0)
+            return;
+
+        const int numRows = static_cast<int>(x[0]->size());
+        std::vector<const Field *> xData(numProducts);
+        std::vector<const Field *> yData(numProducts);
+        for (int prodIdx = 0; prodIdx < numProducts; ++prodIdx) {
+            xData[prodIdx] = data_(*x[prodIdx]);
+            yData[prodIdx] = data_(*y[prodIdx]);
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel if (numRows*blockSize > minParallelSize)
+#endif
+        {
+            // each thread sums up its rows separately. the partial sums are added
+            // at the end.
+            std::vector<Scalar> threadResult(numProducts, 0.0);
+
+#ifdef _OPENMP
+#pragma omp for
+#endif
+            for (int rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+                const Scalar weight = mask ? mask[rowIdx] : 1;
+                const int offset = rowIdx*blockSize;
+                for (int prodIdx = 0; prodIdx < numProducts; ++prodIdx) {
+                    const Field *xRow = xData[prodIdx] + offset;
+                    const Field *yRow = yData[prodIdx] + offset;
+                    Scalar rowSum = 0.0;
+                    for (int i = 0; i < blockSize; ++i)
+                        rowSum += xRow[i]*yRow[i];
+                    threadResult[prodIdx] += weight*rowSum;
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+            for (int prodIdx = 0; prodIdx < numProducts; ++prodIdx)
+                result[prodIdx] += threadResult[prodIdx];
+        }
+    }
+
+    ////////////////
+    // fallbacks for all other vector types
+    ////////////////
+    template <class Vector, class Scalar>
+    static void axpy2_(Vector &y1, Scalar a1, const Vector &x1,
+                       Vector &y2, Scalar a2, const Vector &x2,
+                       std::false_type)
+    {
+        y1.axpy(a1, x1);
+        y2.axpy(a2, x2);
+    }
+
+    template <class Vector, class Scalar>
+    static void aypx2_(Vector &y1, Scalar b, const Vector &x1,
+                       Vector &y2, const Vector &x2,
+                       std::false_type)
+    {
+        y1 *= b;
+        y1 += x1;
+        y2 *= b;
+        y2 += x2;
+    }
+
+    template <class Vector, class Scalar>
+    static Scalar axpy2Norm2_(Vector &y1, Scalar a1, const Vector &x1,
+                              Vector &y2, Scalar a2, const Vector &x2,
+                              const unsigned char *mask,
+                              std::false_type)
+    {
+        y1.axpy(a1, x1);
+        y2.axpy(a2, x2);
+
+        Scalar sum = 0.0;
+        for (size_t rowIdx = 0; rowIdx < y2.size(); ++rowIdx)
+            if (!mask || mask[rowIdx])
+                sum += y2[rowIdx]*y2[rowIdx];
+        return sum;
+    }
+
+    template <class Vector, class Scalar>
+    static void linearCombination_(Vector &z,
+                                   Scalar a, const Vector &x,
+                                   Scalar b, const Vector &y,
+                                   Scalar c,
+                                   std::false_type)
+    {
+        z *= c;
+        z.axpy(a, x);
+        z.axpy(b, y);
+    }
+
+    template <class Vector, class Scalar>
+    static void dots_(const Vector *const *x,
+                      const Vector *const *y,
+                      Scalar *result,
+                      int numProducts,
+                      const unsigned char *mask,
+                      std::false_type)
+    {
+        for (int prodIdx = 0; prodIdx < numProducts; ++prodIdx) {
+            result[prodIdx] = 0.0;
+            const Vector &xVec = *x[prodIdx];
+            const Vector &yVec = *y[prodIdx];
+            for (size_t rowIdx = 0; rowIdx < xVec.size(); ++rowIdx)
+                if (!mask || mask[rowIdx])
+                    result[prodIdx] += xVec[rowIdx]*yVec[rowIdx];
+        }
+    }
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -189,6 +189,41 @@ public:
         updateErrors_(curSol, curResid);
     }
 
+    /*!
+     * \copydoc ConvergenceCriterion::update(const Vector &, const Vector &, Scalar)
+     */
+    void update(const Vector &curSol, const Vector &curResid, Scalar curResidNorm)
+    { update(curSol, curResid); }
+
+    /*!
+     * \copydoc ConvergenceCriterion::numLocalMaxima()
+     *
+     * The criterion requires the maxima of the weighted residual and of the
+     * fix-point error.
+     */
+    int numLocalMaxima() const
+    { return 2; }
+
+    /*!
+     * \copydoc ConvergenceCriterion::localMaxima()
+     */
+    void localMaxima(const Vector &curSol, const Vector &curResid, Scalar *result) const
+    { localErrors_(result[0], result[1], curSol, curResid); }
+
+    /*!
+     * \copydoc ConvergenceCriterion::update(const Vector &, const Vector &, Scalar, const Scalar *)
+     */
+    void update(const Vector &curSol,
+                const Vector &curResid,
+                Scalar curResidNorm,
+                const Scalar *globalMaxima)
+    {
+        lastResidualError_ = residualError_;
+        residualError_ = globalMaxima[0];
+        fixPointError_ = globalMaxima[1];
+        lastSolVec_ = curSol;
+    }
+
     /*!
      * \copydoc ConvergenceCriterion::converged()
      */
@@ -244,22 +279,32 @@ public:
     }
 
 private:
-    // update the weighted absolute residual
-    void updateErrors_(const Vector &curSol, const Vector &curResid)
+    // compute the process-local weighted maximum of the residual and of the
+    // difference to the last iterative solution
+    void localErrors_(Scalar &residualError,
+                      Scalar &fixPointError,
+                      const Vector &curSol,
+                      const Vector &curResid) const
     {
-        residualError_ = 0.0;
-        fixPointError_ = 0.0;
+        residualError = 0.0;
+        fixPointError = 0.0;
         for (size_t i = 0; i < curResid.size(); ++i) {
             for (size_t j = 0; j < BlockType::dimension; ++j) {
-                residualError_ =
-                    std::max<Scalar>(residualError_,
+                residualError =
+                    std::max<Scalar>(residualError,
                                      residualWeight(i, j)*std::abs(curResid[i][j]));
-                fixPointError_ =
-                    std::max<Scalar>(fixPointError_,
+                fixPointError =
+                    std::max<Scalar>(fixPointError,
                                      std::abs(curSol[i][j] - lastSolVec_[i][j])
                                      /std::max<Scalar>(1.0, curSol[i][j]));
             }
         }
+    }
+
+    // update the weighted absolute residual
+    void updateErrors_(const Vector &curSol, const Vector &curResid)
+    {
+        localErrors_(residualError_, fixPointError_, curSol, curResid);
         lastSolVec_ = curSol;
 
         residualError_ = comm_.max(residualError_);
@@ -136,7 +136,7 @@ public:
             if (upIdx == interiorIdx)
                 evalPhaseFluxes_<Evaluation>(flux, phaseIdx, extQuants, up);
             else
-                evalPhaseFluxes_<Scalar>(flux, phaseIdx, extQuants, up);
+                evalPhaseFluxes_<typename ElementContext::ExteriorEvaluation>(flux, phaseIdx, extQuants, up);
         }
     }
 
@@ -96,6 +96,11 @@ SET_TYPE_PROP(BlackOilModel, ExtensiveQuantities, Ewoms::BlackOilExtensiveQuanti
 //! The indices required by the model
 SET_TYPE_PROP(BlackOilModel, Indices, Ewoms::BlackOilIndices</*PVOffset=*/0>);
 
+//! The CPR preconditioner decouples the pressure switching variable from the remaining
+//! primary variables. Depending on the phases present, it represents the pressure of the
+//! oil or of the gas phase.
+SET_INT_PROP(BlackOilModel, CprPressureIndex, GET_PROP_TYPE(TypeTag, Indices)::pressureSwitchIdx);
+
 //! Set the fluid system to the black-oil fluid system by default
 SET_PROP(BlackOilModel, FluidSystem)
 {
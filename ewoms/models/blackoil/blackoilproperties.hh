@@ -40,6 +40,8 @@ NEW_PROP_TAG(EnableEclipseOutput);
 NEW_PROP_TAG(HeatConductionLaw);
 //! The parameters of the material law for heat conduction
 NEW_PROP_TAG(HeatConductionLawParams);
+//! The index of the primary variable used as the pressure by the CPR preconditioner
+NEW_PROP_TAG(CprPressureIndex);
 }} // namespace Properties, Ewoms
 
 #endif
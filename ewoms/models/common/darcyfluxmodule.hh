@@ -239,8 +239,9 @@ protected:
 
                 // the quantities on the exterior side of the face do not influence the
                 // result for the TPFA scheme, so they can be treated as scalar values.
-                Scalar rhoEx = Toolbox::value(intQuantsEx.fluidState().density(phaseIdx));
-                Scalar pStatEx = - rhoEx*(gEx*distVecEx);
+                // (unless the face-based linearization is used.)
+                auto rhoEx = ElementContext::exteriorValue(intQuantsEx.fluidState().density(phaseIdx));
+                auto pStatEx = - rhoEx*(gEx*distVecEx);
 
                 // compute the hydrostatic gradient between the two control volumes (this
                 // gradient exhibitis the same direction as the vector between the two
@@ -295,7 +296,7 @@ protected:
             if (upstreamDofIdx_[phaseIdx] == interiorDofIdx_)
                 mobility_[phaseIdx] = up.mobility(phaseIdx);
             else
-                mobility_[phaseIdx] = Toolbox::value(up.mobility(phaseIdx));
+                mobility_[phaseIdx] = ElementContext::exteriorValue(up.mobility(phaseIdx));
         }
     }
 
@@ -82,6 +82,7 @@ class DiffusionModule<TypeTag, /*enableDiffusion=*/true>
 {
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
     typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
+    typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
     typedef typename GET_PROP_TYPE(TypeTag, RateVector) RateVector;
     typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
     typedef typename GET_PROP_TYPE(TypeTag, Indices) Indices;
@@ -115,7 +116,7 @@ public:
         for (int phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
             // arithmetic mean of the phase's molar density
             Evaluation rhoMolar = fluidStateI.molarDensity(phaseIdx);
-            rhoMolar += Toolbox::value(fluidStateJ.molarDensity(phaseIdx));
+            rhoMolar += ElementContext::exteriorValue(fluidStateJ.molarDensity(phaseIdx));
             rhoMolar /= 2;
 
             for (int compIdx = 0; compIdx < numComponents; ++compIdx)
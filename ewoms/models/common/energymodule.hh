@@ -615,13 +615,7 @@ protected:
                                     int timeIdx)
     {
         const auto& priVars = context.primaryVars(spaceIdx, timeIdx);
-        Evaluation val;
-        if (timeIdx == 0)
-            val = Toolbox::createVariable(priVars[temperatureIdx], temperatureIdx);
-        else
-            val = Toolbox::createConstant(priVars[temperatureIdx]);
-
-        fluidState.setTemperature(val);
+        fluidState.setTemperature(priVars.makeEvaluation(temperatureIdx, timeIdx));
     }
 
     /*!
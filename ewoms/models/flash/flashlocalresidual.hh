@@ -152,12 +152,12 @@ public:
             }
             else {
                 Evaluation tmp =
-                    Toolbox::value(up.fluidState().molarDensity(phaseIdx))
+                    ElementContext::exteriorValue(up.fluidState().molarDensity(phaseIdx))
                     * extQuants.volumeFlux(phaseIdx);
 
                 for (int compIdx = 0; compIdx < numComponents; ++compIdx) {
                     flux[conti0EqIdx + compIdx] +=
-                        tmp*Toolbox::value(up.fluidState().moleFraction(phaseIdx, compIdx));
+                        tmp*ElementContext::exteriorValue(up.fluidState().moleFraction(phaseIdx, compIdx));
                 }
             }
         }
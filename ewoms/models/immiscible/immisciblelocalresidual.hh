@@ -144,7 +144,7 @@ public:
             if (interiorIdx == upIdx)
                 flux[conti0EqIdx + phaseIdx] += extQuants.volumeFlux(phaseIdx)*rho;
             else
-                flux[conti0EqIdx + phaseIdx] += extQuants.volumeFlux(phaseIdx)*Toolbox::value(rho);
+                flux[conti0EqIdx + phaseIdx] += extQuants.volumeFlux(phaseIdx)*ElementContext::exteriorValue(rho);
         }
 
         EnergyModule::addAdvectiveFlux(flux, elemCtx, scvfIdx, timeIdx);
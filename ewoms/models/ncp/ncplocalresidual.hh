@@ -154,12 +154,12 @@ public:
             }
             else {
                 Evaluation tmp =
-                    Toolbox::value(up.fluidState().molarDensity(phaseIdx))
+                    ElementContext::exteriorValue(up.fluidState().molarDensity(phaseIdx))
                     * extQuants.volumeFlux(phaseIdx);
 
                 for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
                     flux[conti0EqIdx + compIdx] +=
-                        tmp*Toolbox::value(up.fluidState().moleFraction(phaseIdx, compIdx));
+                        tmp*ElementContext::exteriorValue(up.fluidState().moleFraction(phaseIdx, compIdx));
                 }
             }
         }
@@ -76,46 +76,42 @@ private:
     friend class NewtonMethod<TypeTag>;
     friend class ParentType;
 */
-    void preSolve_(const SolutionVector &currentSolution,
-                   const GlobalEqVector &currentResidual)
+    /*!
+     * \copydoc NewtonMethod::residualError_
+     *
+     * For the NCP model, the residuals of the non-linear complementarity functions are
+     * not considered.
+     */
+    Scalar residualError_(const GlobalEqVector &residual) const
     {
-        const auto& constraintsMap = this->model().linearizer().constraintsMap();
-        this->lastError_ = this->error_;
+        const auto& linearizer = this->model().linearizer();
 
         // calculate the error as the maximum weighted tolerance of
         // the solution's residual
-        this->error_ = 0;
-        for (unsigned dofIdx = 0; dofIdx < currentResidual.size(); ++dofIdx) {
+        Scalar error = 0;
+        for (unsigned dofIdx = 0; dofIdx < residual.size(); ++dofIdx) {
             // do not consider auxiliary DOFs for the error
             if (dofIdx >= this->model().numGridDof() || this->model().dofTotalVolume(dofIdx) <= 0.0)
                 continue;
 
             // also do not consider DOFs which are constraint
             if (this->enableConstraints_()) {
-                if (constraintsMap.count(dofIdx) > 0)
+                if (linearizer.isConstraintDof(dofIdx))
                     continue;
             }
 
-            const auto &r = currentResidual[dofIdx];
+            const auto &r = residual[dofIdx];
             for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx) {
                 if (ncp0EqIdx <= eqIdx && eqIdx < Indices::ncp0EqIdx + numPhases)
                     continue;
-                this->error_ =
+                error =
                     std::max(std::abs(r[eqIdx]*this->model().eqWeight(dofIdx, eqIdx)),
-                             this->error_);
+                             error);
             }
         }
 
         // take the other processes into account
-        this->error_ = this->comm_.max(this->error_);
-
-        // make sure that the error never grows beyond the maximum
-        // allowed one
-        if (this->error_ > EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError))
-            OPM_THROW(Opm::NumericalProblem,
-                      "Newton: Error " << this->error_
-                      << " is larger than maximum allowed error of "
-                      << EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError));
+        return this->comm_.max(error);
     }
 
     /*!
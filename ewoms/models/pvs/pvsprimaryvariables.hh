@@ -258,9 +258,7 @@ public:
             return 0.0;
 
         int varIdx = switch0Idx + phaseIdx - 1;
-        if (timeIdx != 0)
-            Toolbox::createConstant((*this)[varIdx]);
-        return Toolbox::createVariable((*this)[varIdx], varIdx);
+        return this->makeEvaluation(varIdx, timeIdx);
     }
 
     /*!
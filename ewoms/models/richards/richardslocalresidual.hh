@@ -91,7 +91,7 @@ public:
         if (interiorIdx == upIdx)
             flux[contiEqIdx] = extQuants.volumeFlux(liquidPhaseIdx)*rho;
         else
-            flux[contiEqIdx] = extQuants.volumeFlux(liquidPhaseIdx)*Toolbox::value(rho);
+            flux[contiEqIdx] = extQuants.volumeFlux(liquidPhaseIdx)*ElementContext::exteriorValue(rho);
     }
 
     /*!
@@ -40,8 +40,10 @@
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpihelper.hh>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 
 #include <unistd.h>
 
@@ -139,6 +141,46 @@ NEW_PROP_TAG(NewtonTargetIterations);
 //! Number of maximum iterations for the Newton method.
 NEW_PROP_TAG(NewtonMaxIterations);
 
+/*!
+ * \brief Specifies whether the Jacobian matrix should only be assembled every few
+ *        iterations.
+ *
+ * The linear solver then applies the Jacobian without the assembled matrix by means of
+ * the directional derivatives of the residual, which are calculated element by
+ * element. The matrix is only used to precondition the linear solver, so it is kept
+ * across time steps. This saves assembly time, but not memory: the Jacobian matrix is
+ * still allocated because the preconditioner is set up from it. This requires support
+ * by the linear solver backend.
+ */
+NEW_PROP_TAG(EnableJacobianFreeNewton);
+
+//! The number of Newton iterations between two assemblies of the Jacobian matrix if
+//! the Jacobian-free Newton-Krylov method is enabled
+NEW_PROP_TAG(JacobianFreeAssemblyInterval);
+
+//! The maximum number of consecutive Newton iterations in which the Jacobian matrix of
+//! a previous iteration is reused (i.e., the modified Newton method is used). If this
+//! is 0, the Jacobian is assembled in every iteration.
+NEW_PROP_TAG(NewtonJacobianReuseIterations);
+
+//! The largest ratio between the errors of two consecutive iterations for which the
+//! Jacobian matrix is reused
+NEW_PROP_TAG(NewtonJacobianReuseMaxErrorRatio);
+
+//! Specifies whether the update of the Newton method should be subject to a
+//! backtracking line search on the error of the residual
+NEW_PROP_TAG(NewtonLineSearch);
+
+//! The maximum number of times the update is halved by the line search
+NEW_PROP_TAG(NewtonMaxLineSearchIterations);
+
+//! Specifies whether the update of the Newton method should be damped if the error
+//! oscillates between iterations
+NEW_PROP_TAG(NewtonDetectOscillations);
+
+//! The smallest relaxation factor applied to the update if oscillations are detected
+NEW_PROP_TAG(NewtonMinRelaxation);
+
 // set default values for the properties
 SET_TYPE_PROP(NewtonMethod, NewtonMethod, Ewoms::NewtonMethod<TypeTag>);
 SET_TYPE_PROP(NewtonMethod, NewtonConvergenceWriter, Ewoms::NullConvergenceWriter<TypeTag>);
@@ -150,6 +192,14 @@ SET_SCALAR_PROP(NewtonMethod, NewtonRawTolerance, 1e-8);
 SET_SCALAR_PROP(NewtonMethod, NewtonMaxError, 1e100);
 SET_INT_PROP(NewtonMethod, NewtonTargetIterations, 10);
 SET_INT_PROP(NewtonMethod, NewtonMaxIterations, 18);
+SET_BOOL_PROP(NewtonMethod, EnableJacobianFreeNewton, false);
+SET_INT_PROP(NewtonMethod, JacobianFreeAssemblyInterval, 3);
+SET_INT_PROP(NewtonMethod, NewtonJacobianReuseIterations, 0);
+SET_SCALAR_PROP(NewtonMethod, NewtonJacobianReuseMaxErrorRatio, 0.5);
+SET_BOOL_PROP(NewtonMethod, NewtonLineSearch, false);
+SET_INT_PROP(NewtonMethod, NewtonMaxLineSearchIterations, 5);
+SET_BOOL_PROP(NewtonMethod, NewtonDetectOscillations, false);
+SET_SCALAR_PROP(NewtonMethod, NewtonMinRelaxation, 0.5);
 } // namespace Properties
 } // namespace Ewoms
 
@@ -192,10 +242,21 @@ public:
         , convergenceWriter_(asImp_())
     {
         lastError_ = 1e100;
+        secondLastError_ = 1e100;
         error_ = 1e100;
+        relaxation_ = 1.0;
+        errorRatio_ = 0.0;
         tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonRawTolerance);
 
         numIterations_ = 0;
+        jacobianAge_ = -1;
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableJacobianFreeNewton)
+            && !LinearSolverBackend::supportsJacobianFreeNewton())
+            OPM_THROW(std::runtime_error,
+                      "The Jacobian-free Newton-Krylov method is not supported by the "
+                      "linear solver backend. Use the ParallelIterativeSolverBackend "
+                      "or disable the EnableJacobianFreeNewton parameter");
     }
 
     /*!
@@ -224,6 +285,36 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxError,
                              "The maximum error tolerated by the Newton "
                              "method to which does not cause an abort");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableJacobianFreeNewton,
+                             "Only assemble the Jacobian matrix every few iterations "
+                             "and apply it using directional derivatives of the "
+                             "residual otherwise (requires the "
+                             "ParallelIterativeSolverBackend)");
+        EWOMS_REGISTER_PARAM(TypeTag, int, JacobianFreeAssemblyInterval,
+                             "The number of Newton iterations between two assemblies "
+                             "of the Jacobian matrix if the Jacobian-free Newton-Krylov "
+                             "method is used");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonJacobianReuseIterations,
+                             "The maximum number of consecutive Newton iterations "
+                             "which reuse the Jacobian matrix of a previous iteration "
+                             "(0: assemble the Jacobian in every iteration)");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonJacobianReuseMaxErrorRatio,
+                             "The largest ratio between the errors of two consecutive "
+                             "Newton iterations for which the Jacobian matrix is "
+                             "reused");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonLineSearch,
+                             "Use a backtracking line search on the error of the "
+                             "residual to determine the step size of the Newton "
+                             "method");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonMaxLineSearchIterations,
+                             "The maximum number of times the update is halved by "
+                             "the line search of the Newton method");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonDetectOscillations,
+                             "Damp the update of the Newton method if the error "
+                             "oscillates between iterations");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMinRelaxation,
+                             "The smallest relaxation factor applied to the update "
+                             "of the Newton method if oscillations are detected");
     }
 
     /*!
@@ -264,6 +355,16 @@ public:
     int numIterations() const
     { return numIterations_; }
 
+    /*!
+     * \brief Returns the error of the most recent solution for which it was
+     *        determined.
+     *
+     * During the linearization of an iteration, this is the error of the solution of
+     * the previous iteration.
+     */
+    Scalar error() const
+    { return error_; }
+
     /*!
      * \brief Set the index of current iteration.
      *
@@ -305,14 +406,16 @@ public:
             clearRemainingLine = blubb;
         }
 
-        SolutionVector &nextSolution = model().solution(/*historyIdx=*/0);
-        SolutionVector currentSolution(nextSolution);
-        GlobalEqVector solutionUpdate(nextSolution.size());
+        // the solution update is stored in a buffer which persists between invocations
+        // of the Newton method
+        GlobalEqVector &solutionUpdate = solutionUpdate_;
+        if (solutionUpdate.size() != model().solution(/*historyIdx=*/0).size())
+            solutionUpdate.resize(model().solution(/*historyIdx=*/0).size());
 
         Linearizer &linearizer = model().linearizer();
 
         // tell the implementation that we begin solving
-        asImp_().begin_(nextSolution);
+        asImp_().begin_(model().solution(/*historyIdx=*/0));
 
         linearizeTime_ = 0.0;
         solveTime_ = 0.0;
@@ -333,8 +436,10 @@ public:
                 prePostProcessTimer.stop();
                 simulator_.addPrePostProcessTime(prePostProcessTimer.realTimeElapsed());
 
-                // make the current solution to the old one
-                currentSolution = nextSolution;
+                // the solution of the last iteration is the current solution of the
+                // model. the next one is assembled in the solution buffer, which is
+                // exchanged with the current solution at the end of the iteration.
+                const SolutionVector &currentSolution = model().solution(/*historyIdx=*/0);
 
                 if (asImp_().verbose_()) {
                     std::cout << "Linearize: r(x^k) = dS/dt + div F - q;   M = grad r"
@@ -342,13 +447,23 @@ public:
                               << std::flush;
                 }
 
-                // do the actual linearization
+                // do the actual linearization. if the Jacobian matrix is not
+                // required, only the residual is evaluated
+                bool assembleJacobian = asImp_().assembleJacobian_();
                 linearizeTimer_.start();
-                asImp_().linearize_();
+                if (assembleJacobian)
+                    asImp_().linearize_();
+                else
+                    asImp_().linearizeResidual_();
                 linearizeTimer_.stop();
                 linearizeTime_ += linearizeTimer_.realTimeElapsed();
                 linearizeTimer_.halt();
 
+                if (assembleJacobian)
+                    jacobianAge_ = 0;
+                else
+                    ++jacobianAge_;
+
                 // notify the implementation of the successful linearization on order to
                 // give it the chance to update the error and thus to terminate the
                 // Newton method without the need of solving the last linearization.
@@ -357,6 +472,8 @@ public:
                 auto& b = linearizer.residual();
                 linearSolver_.prepareRhs(M, b);
                 asImp_().preSolve_(currentSolution,  b);
+                if (EWOMS_GET_PARAM(TypeTag, bool, NewtonDetectOscillations))
+                    asImp_().updateRelaxation_();
                 updateTimer_.stop();
                 updateTime_ += updateTimer_.realTimeElapsed();;
                 updateTimer_.halt();
@@ -373,7 +490,8 @@ public:
 
                 solveTimer_.start();
                 solutionUpdate = 0;
-                linearSolver_.prepareMatrix(M);
+                if (assembleJacobian)
+                    linearSolver_.prepareMatrix(M);
                 bool converged = linearSolver_.solve(solutionUpdate);
                 solveTimer_.stop();
                 solveTime_ += solveTimer_.realTimeElapsed();;
@@ -400,20 +518,45 @@ public:
                 }
 
                 // update the current solution (i.e. uOld) with the delta
-                // (i.e. u). The result is stored in u
+                // (i.e. u). The result is stored in the solution buffer. if this
+                // still contains the solution before the first iteration, the model
+                // needs to keep it in case the update fails.
                 updateTimer_.start();
+                model().retainInitialSolution();
+                SolutionVector &nextSolution = model().solutionBuffer();
                 asImp_().postSolve_(nextSolution,
                                     currentSolution,
                                     b,
                                     solutionUpdate);
+                if (relaxation_ < 1.0) {
+                    solutionUpdate *= relaxation_;
+                    endIterMsg() << ", relaxation=" << relaxation_;
+                }
+                asImp_().writeConvergence_(currentSolution, solutionUpdate);
                 asImp_().update_(nextSolution, currentSolution, solutionUpdate, b);
+
+                // make the next solution the current one of the model. after this, the
+                // solution buffer contains the solution of the last iteration.
+                model().swapSolutionBuffer();
                 updateTimer_.stop();
                 updateTime_ += updateTimer_.realTimeElapsed();
                 updateTimer_.halt();
 
+                // possibly shorten the update if it does not reduce the error
+                // sufficiently. this only requires the residuals of the trial
+                // solutions; the accepted one is linearized in the next iteration.
+                if (EWOMS_GET_PARAM(TypeTag, bool, NewtonLineSearch)) {
+                    linearizeTimer_.start();
+                    asImp_().lineSearch_();
+                    linearizeTimer_.stop();
+                    linearizeTime_ += linearizeTimer_.realTimeElapsed();
+                    linearizeTimer_.halt();
+                }
+
                 // tell the implementation that we're done with this iteration
                 prePostProcessTimer.start();
-                asImp_().endIteration_(nextSolution, currentSolution);
+                asImp_().endIteration_(model().solution(/*historyIdx=*/0),
+                                       model().solutionBuffer());
                 prePostProcessTimer.stop();
                 simulator_.addPrePostProcessTime(prePostProcessTimer.realTimeElapsed());
             }
@@ -565,6 +708,11 @@ protected:
     void begin_(const SolutionVector &u)
     {
         numIterations_ = 0;
+        if (!jacobianFreeNewton_())
+            jacobianAge_ = 0;
+        secondLastError_ = 1e100;
+        errorRatio_ = 0.0;
+        relaxation_ = 1.0;
 
         if (EWOMS_GET_PARAM(TypeTag, bool, NewtonWriteConvergence))
             convergenceWriter_.beginTimeStep();
@@ -585,41 +733,178 @@ protected:
     void linearize_()
     { model().linearizer().linearize(); }
 
+    /*!
+     * \brief Evaluate the residual of the global non-linear system of equations without
+     *        updating the Jacobian matrix.
+     */
+    void linearizeResidual_()
+    { model().linearizer().linearizeResidual(); }
+
+    /*!
+     * \brief Returns true if the Jacobian matrix ought to be assembled in the current
+     *        iteration.
+     *
+     * If the Jacobian-free Newton-Krylov method is used, the matrix is only required to
+     * precondition the linear solver. It is thus only assembled every few iterations,
+     * regardless of the time step, and after the Newton method failed.
+     *
+     * Else, the Jacobian is always assembled in the first iteration of a time step. The
+     * Jacobian of a previous iteration may then be reused for a few iterations (i.e.,
+     * the modified Newton method is used) as long as the error is reduced
+     * sufficiently. If the error stalls, the Jacobian is assembled anew.
+     *
+     * In either case, the Jacobian is assembled if the linearizer is not able to only
+     * evaluate the residual, since it then linearizes the full system anyway.
+     */
+    bool assembleJacobian_() const
+    {
+        if (!model().linearizer().canLinearizeResidualOnly())
+            return true;
+
+        if (jacobianFreeNewton_()) {
+            int interval = std::max(1, EWOMS_GET_PARAM(TypeTag, int, JacobianFreeAssemblyInterval));
+            return jacobianAge_ < 0 || jacobianAge_ >= interval - 1;
+        }
+
+        if (numIterations_ == 0)
+            return true;
+
+        int maxJacobianAge = EWOMS_GET_PARAM(TypeTag, int, NewtonJacobianReuseIterations);
+        if (jacobianAge_ >= maxJacobianAge)
+            return true;
+
+        return errorRatio_ > EWOMS_GET_PARAM(TypeTag, Scalar, NewtonJacobianReuseMaxErrorRatio);
+    }
+
     void preSolve_(const SolutionVector &currentSolution,
                    const GlobalEqVector &currentResidual)
     {
-        const auto& constraintsMap = model().linearizer().constraintsMap();
         lastError_ = error_;
+        error_ = asImp_().residualError_(currentResidual);
+
+        // the ratio of the errors of the current and the last iteration
+        if (numIterations_ > 0 && lastError_ > 0.0)
+            errorRatio_ = error_/lastError_;
+        else
+            errorRatio_ = 0.0;
+
+        // make sure that the error never grows beyond the maximum
+        // allowed one
+        if (error_ > EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError))
+            OPM_THROW(Opm::NumericalProblem,
+                      "Newton: Error " << error_
+                      << " is larger than maximum allowed error of "
+                      << EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError));
+    }
+
+    /*!
+     * \brief Returns the error of a residual.
+     *
+     * For our purposes, the error is defined as the maximum of the weighted residual
+     * over all degrees of freedom of the grid which are not constraint.
+     *
+     * \param residual The residual for which the error ought to be calculated
+     */
+    Scalar residualError_(const GlobalEqVector &residual) const
+    {
+        const auto& linearizer = model().linearizer();
 
         // calculate the error as the maximum weighted tolerance of
         // the solution's residual
-        error_ = 0;
-        for (unsigned dofIdx = 0; dofIdx < currentResidual.size(); ++dofIdx) {
+        Scalar error = 0;
+        for (unsigned dofIdx = 0; dofIdx < residual.size(); ++dofIdx) {
             // do not consider auxiliary DOFs for the error
             if (dofIdx >= model().numGridDof() || model().dofTotalVolume(dofIdx) <= 0.0)
                 continue;
 
             // also do not consider DOFs which are constraint
             if (enableConstraints_()) {
-                if (constraintsMap.count(dofIdx) > 0)
+                if (linearizer.isConstraintDof(dofIdx))
                     continue;
             }
 
-            const auto &r = currentResidual[dofIdx];
+            const auto &r = residual[dofIdx];
             for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx)
-                error_ = std::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), error_);
+                error = std::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), error);
         }
 
         // take the other processes into account
-        error_ = comm_.max(error_);
+        return comm_.max(error);
+    }
 
-        // make sure that the error never grows beyond the maximum
-        // allowed one
-        if (error_ > EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError))
-            OPM_THROW(Opm::NumericalProblem,
-                      "Newton: Error " << error_
-                      << " is larger than maximum allowed error of "
-                      << EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError));
+    /*!
+     * \brief Adapt the relaxation factor of the update if the Newton method oscillates.
+     *
+     * The Newton method is considered to oscillate if the error alternately increases
+     * and decreases while the errors of every second iteration stay roughly the same.
+     * In this case the update gets damped more strongly. If the method does not
+     * oscillate and the error decreases, the damping is relaxed again, so that a
+     * transient oscillation does not slow down the remaining iterations.
+     */
+    void updateRelaxation_()
+    {
+        if (numIterations_ >= 2) {
+            bool oscillates =
+                (error_ - lastError_)*(lastError_ - secondLastError_) < 0.0
+                && std::abs(error_ - secondLastError_) < 0.2*std::max(error_, secondLastError_);
+
+            if (oscillates) {
+                Scalar minRelaxation = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMinRelaxation);
+                relaxation_ = std::max(minRelaxation, relaxation_ - 0.1);
+            }
+            else if (error_ < lastError_)
+                relaxation_ = std::min<Scalar>(1.0, relaxation_ + 0.1);
+        }
+
+        secondLastError_ = lastError_;
+    }
+
+    /*!
+     * \brief Do a backtracking line search along the update of the current iteration.
+     *
+     * When this method is called, the full update has been applied to the solution.
+     * If the error of the residual of this solution is not sufficiently smaller than
+     * the one of the solution on which the update is based, the update is halved until
+     * it is, or until the maximum number of line search iterations is reached. The
+     * residuals of the trial solutions are evaluated by the model into a separate
+     * vector, i.e., neither the residual on which the update is based nor the state of
+     * the linearizer is touched.
+     */
+    void lineSearch_()
+    {
+        int maxLineSearchIterations = EWOMS_GET_PARAM(TypeTag, int, NewtonMaxLineSearchIterations);
+        const GlobalEqVector &currentResidual = model().linearizer().residual();
+        if (trialResidual_.size() != currentResidual.size())
+            trialResidual_.resize(currentResidual.size());
+
+        Scalar lambda = 1.0;
+        for (int lineSearchIter = 0; ; ++lineSearchIter) {
+            // the residual computed by the model already includes the contributions of
+            // the peer processes to the border
+            model().syncOverlap();
+            model().globalResidual(trialResidual_);
+            Scalar trialError = asImp_().residualError_(trialResidual_);
+
+            // accept the step if the error decreases sufficiently
+            if (trialError <= (1.0 - 1e-4*lambda)*error_
+                || lineSearchIter >= maxLineSearchIterations)
+                break;
+
+            // apply half of the last update to the solution of the last iteration,
+            // which is still stored in the solution buffer
+            lambda /= 2;
+            solutionUpdate_ *= 0.5;
+
+            model().swapSolutionBuffer();
+            asImp_().update_(model().solutionBuffer(),
+                             model().solution(/*historyIdx=*/0),
+                             solutionUpdate_,
+                             currentResidual);
+            model().swapSolutionBuffer();
+        }
+
+        if (lambda < 1.0)
+            endIterMsg() << ", line search step=" << lambda;
     }
 
     /*!
@@ -649,6 +934,10 @@ protected:
      * use the standard Newton-Raphson update strategy, i.e.
      * \f[ u^{k+1} = u^k - \Delta u^k \f]
      *
+     * Note that the next solution is not the current solution of the model, i.e., all
+     * of its entries must be written by this method. Before updatePrimaryVariables_()
+     * is called for a degree of freedom, its next value is a copy of its current one.
+     *
      * \param nextSolution The solution vector after the current iteration
      * \param currentSolution The solution vector after the last iteration
      * \param solutionUpdate The delta vector as calculated by solving the linear system
@@ -660,11 +949,7 @@ protected:
                  const GlobalEqVector &solutionUpdate,
                  const GlobalEqVector &currentResidual)
     {
-        const auto& constraintsMap = model().linearizer().constraintsMap();
-
-        // first, write out the current solution to make convergence
-        // analysis possible
-        asImp_().writeConvergence_(currentSolution, solutionUpdate);
+        const auto& linearizer = model().linearizer();
 
         // make sure not to swallow non-finite values at this point
         if (!std::isfinite(solutionUpdate.one_norm()))
@@ -672,12 +957,13 @@ protected:
 
         const auto& numGridDof = model().numGridDof();
         for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
+            nextSolution[dofIdx] = currentSolution[dofIdx];
+
             if (enableConstraints_()) {
-                if (constraintsMap.count(dofIdx) > 0) {
-                    const auto& constraints = constraintsMap.at(dofIdx);
+                if (linearizer.isConstraintDof(dofIdx)) {
                     asImp_().updateConstraintDof_(dofIdx,
                                                   nextSolution[dofIdx],
-                                                  constraints);
+                                                  linearizer.constraints(dofIdx));
                 }
                 else
                     asImp_().updatePrimaryVariables_(dofIdx,
@@ -727,7 +1013,7 @@ protected:
      * \brief Write the convergence behaviour of the newton method to
      *        disk.
      *
-     * This method is called as part of the update proceedure.
+     * This method is called once per iteration before the solution is updated.
      */
     void writeConvergence_(const SolutionVector &currentSolution,
                            const GlobalEqVector &solutionUpdate)
@@ -799,7 +1085,12 @@ protected:
      * This method is called _after_ end_()
      */
     void failed_()
-    { numIterations_ = targetIterations_() * 2; }
+    {
+        numIterations_ = targetIterations_() * 2;
+
+        // do not precondition the next attempt with the matrix of the failed one
+        jacobianAge_ = -1;
+    }
 
     /*!
      * \brief Called if the Newton method was successful.
@@ -819,6 +1110,16 @@ protected:
     static bool enableConstraints_()
     { return GET_PROP_VALUE(TypeTag, EnableConstraints); }
 
+    // returns true if the Jacobian-free Newton-Krylov method is used. the matrix-free
+    // Jacobian only considers the elements of the grid, so constraints and auxiliary
+    // modules require the assembled matrix in every iteration.
+    bool jacobianFreeNewton_() const
+    {
+        return EWOMS_GET_PARAM(TypeTag, bool, EnableJacobianFreeNewton)
+            && !enableConstraints_()
+            && model().numAuxiliaryModules() == 0;
+    }
+
     Simulator &simulator_;
 
     Ewoms::Timer linearizeTimer_;
@@ -833,11 +1134,26 @@ protected:
 
     Scalar error_;
     Scalar lastError_;
+    Scalar secondLastError_;
+    Scalar errorRatio_;
     Scalar tolerance_;
 
+    // the factor by which the update is damped if the Newton method oscillates
+    Scalar relaxation_;
+
     // actual number of iterations done so far
     int numIterations_;
 
+    // the number of iterations since the Jacobian matrix was assembled (-1 if it must
+    // be assembled in the next iteration)
+    int jacobianAge_;
+
+    // the update of the solution calculated by the linear solver
+    GlobalEqVector solutionUpdate_;
+
+    // the residual of the trial solutions of the line search
+    GlobalEqVector trialResidual_;
+
     // the linear solver
     LinearSolverBackend linearSolver_;
 
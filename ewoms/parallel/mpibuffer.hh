@@ -88,7 +88,8 @@ public:
     }
 
     /*!
-     * \brief Wait until the buffer was send to the peer completely.
+     * \brief Wait until the buffer was send to the peer completely or until an
+     *        asyncronous receive operation is finished.
      */
     void wait()
     {
@@ -109,18 +110,53 @@ public:
 #endif // HAVE_MPI
     }
 
+    /*!
+     * \brief Receive a message of a-priori unknown size syncronously
+     *        from a peer rank
+     *
+     * The buffer is resized to the size of the received message.
+     */
+    void receiveAnySize(int peerRank)
+    {
+#if HAVE_MPI
+        MPI_Probe(peerRank, 0, MPI_COMM_WORLD, &mpiStatus_);
+
+        int count;
+        MPI_Get_count(&mpiStatus_, mpiDataType_, &count);
+        if (mpiDataType_ == MPI_BYTE)
+            count /= sizeof(DataType);
+        resize(count);
+
+        MPI_Recv(data_, mpiDataSize_, mpiDataType_, peerRank, 0, // tag
+                 MPI_COMM_WORLD, &mpiStatus_);
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Start receiving the buffer asyncronously from a peer rank
+     *
+     * The buffer must not be accessed before wait() has been called.
+     */
+    void startReceive(int peerRank)
+    {
+#if HAVE_MPI
+        MPI_Irecv(data_, mpiDataSize_, mpiDataType_, peerRank, 0, // tag
+                  MPI_COMM_WORLD, &mpiRequest_);
+#endif // HAVE_MPI
+    }
+
 #if HAVE_MPI
     /*!
      * \brief Returns the current MPI_Request object.
      *
-     * This object is only well defined after the send() method.
+     * This object is only well defined after the send() and startReceive() methods.
      */
     MPI_Request &request()
     { return mpiRequest_; }
     /*!
      * \brief Returns the current MPI_Request object.
      *
-     * This object is only well defined after the send() method.
+     * This object is only well defined after the send() and startReceive() methods.
      */
     const MPI_Request &request() const
     { return mpiRequest_; }
@@ -28,13 +28,130 @@
 #define EWOMS_THREADED_ENTITY_ITERATOR_HH
 
 #include <ewoms/parallel/locks.hh>
+#include <ewoms/common/alignedallocator.hh>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 namespace Ewoms {
 
+/*!
+ * \brief Partitions the entities of a GridView into chunks of consecutive entities.
+ *
+ * Grid iterators can only be incremented, so the first entity of each chunk needs to
+ * be determined by a sequential walk over the grid view. Since this walk is relatively
+ * expensive compared to what is done with the entities in many cases, objects of this
+ * class are supposed to be kept alive as long as the grid does not change and to be
+ * shared by all ThreadedEntityIterator objects.
+ */
+template <class GridView, int codim>
+class ThreadedEntityChunks
+{
+    typedef typename GridView::template Codim<codim>::Iterator EntityIterator;
+
+    // the maximum number of entities per chunk if the chunk size is determined
+    // automatically
+    enum { maxAutoChunkSize = 64 };
+
+public:
+    /*!
+     * \brief Partition the entities of a grid view into chunks.
+     *
+     * \param gridView The grid view over which's entities should be iterated
+     * \param numThreads The maximum number of threads which iterate over the entities
+     * \param chunkSize The number of entities which are handed out to a thread at
+     *                  once. 0 means that a suitable value is determined automatically.
+     */
+    ThreadedEntityChunks(const GridView& gridView, unsigned numThreads, unsigned chunkSize = 0)
+        : gridView_(gridView)
+        , sequentialEnd_(gridView.template end<codim>())
+        , numThreads_(std::max(1u, numThreads))
+    {
+        if (chunkSize == 0) {
+            // aim for about eight chunks per thread to get a decent load balance, but
+            // do not let the chunks become so large that the working set of a chunk
+            // exceeds the CPU caches
+            unsigned n = gridView.size(codim);
+            chunkSize = std::max(1u, std::min<unsigned>(maxAutoChunkSize, n/(8*numThreads_)));
+        }
+        chunkSize_ = chunkSize;
+
+        // remember the first entity of each chunk
+        numEntities_ = 0;
+        EntityIterator it = gridView.template begin<codim>();
+        for (; it != sequentialEnd_; ++it, ++numEntities_) {
+            if (numEntities_ % chunkSize_ == 0)
+                chunkBegin_.push_back(it);
+        }
+    }
+
+    /*!
+     * \brief Returns the grid view which has been partitioned.
+     */
+    const GridView& gridView() const
+    { return gridView_; }
+
+    /*!
+     * \brief Returns the iterator which marks the end of the grid view.
+     */
+    const EntityIterator& end() const
+    { return sequentialEnd_; }
+
+    /*!
+     * \brief Returns the first entity of a given chunk.
+     */
+    const EntityIterator& chunkBegin(unsigned chunkIdx) const
+    { return chunkBegin_[chunkIdx]; }
+
+    /*!
+     * \brief Returns the number of entities of a given chunk.
+     */
+    unsigned chunkLength(unsigned chunkIdx) const
+    { return std::min(chunkSize_, numEntities_ - chunkIdx*chunkSize_); }
+
+    /*!
+     * \brief Returns the maximum number of threads which iterate over the entities.
+     */
+    unsigned numThreads() const
+    { return numThreads_; }
+
+    /*!
+     * \brief Returns the number of entities which are handed to a thread at once.
+     */
+    unsigned chunkSize() const
+    { return chunkSize_; }
+
+    /*!
+     * \brief Returns the number of chunks into which the entities have been partitioned.
+     */
+    unsigned numChunks() const
+    { return chunkBegin_.size(); }
+
+private:
+    GridView gridView_;
+    EntityIterator sequentialEnd_;
+    std::vector<EntityIterator> chunkBegin_;
+
+    unsigned numThreads_;
+    unsigned chunkSize_;
+    unsigned numEntities_;
+};
+
 /*!
  * \brief Provides an STL-iterator like interface to iterate over the enties of a
  *        GridView in OpenMP threaded applications
  *
+ * The entities of the grid view are partitioned into chunks of consecutive entities by
+ * a ThreadedEntityChunks object. Threads then claim whole chunks using an atomic
+ * counter, i.e., no lock needs to be acquired in order to hand out an entity and the
+ * entities which a given thread works on are consecutive in memory in most cases.
+ *
  * ATTENTION: This class must be instantiated in a sequential context!
  */
 template <class GridView, int codim>
@@ -42,50 +159,128 @@ class ThreadedEntityIterator
 {
     typedef typename GridView::template Codim<codim>::Entity Entity;
     typedef typename GridView::template Codim<codim>::Iterator EntityIterator;
+
+    // the per-thread state. we make sure that it occupies a full cache line in order to
+    // avoid false sharing between the threads.
+    struct alignas(64) ThreadState_
+    {
+        // the entity which is currently worked on by the thread
+        EntityIterator it;
+
+        // the number of entities left in the thread's chunk (including the current one)
+        unsigned remaining;
+    };
+
 public:
-    ThreadedEntityIterator(const GridView& gridView)
-        : gridView_(gridView)
-        , sequentialIt_(gridView_.template begin<codim>())
-        , sequentialEnd_(gridView.template end<codim>())
+    typedef ThreadedEntityChunks<GridView, codim> Chunks;
+
+    /*!
+     * \brief Iterate over the entities of a grid view which has already been
+     *        partitioned into chunks.
+     *
+     * \param chunks The partition of the grid view's entities. It can be shared by
+     *               any number of iterators.
+     */
+    explicit ThreadedEntityIterator(std::shared_ptr<const Chunks> chunks)
+        : chunks_(chunks)
+        , nextChunkIdx_(0)
+    {
+        ThreadState_ initialState = { chunks_->end(), /*remaining=*/0 };
+        threadState_.resize(chunks_->numThreads(), initialState);
+    }
+
+    /*!
+     * \brief Partition the entities of a grid view into chunks and iterate over them.
+     *
+     * Since this requires a sequential walk over the grid view, the constructor which
+     * takes an existing partition should be used in performance critical code.
+     *
+     * \param gridView The grid view over which's entities should be iterated
+     * \param numThreads The maximum number of threads which iterate over the entities
+     * \param chunkSize The number of entities which are handed out to a thread at
+     *                  once. 0 means that a suitable value is determined automatically.
+     */
+    ThreadedEntityIterator(const GridView& gridView, unsigned numThreads, unsigned chunkSize = 0)
+        : ThreadedEntityIterator(std::make_shared<Chunks>(gridView, numThreads, chunkSize))
     { }
 
-    ThreadedEntityIterator(const ThreadedEntityIterator &other) = default;
+    ThreadedEntityIterator(const ThreadedEntityIterator &other)
+        : chunks_(other.chunks_)
+        , threadState_(other.threadState_)
+        , nextChunkIdx_(other.nextChunkIdx_.load())
+    { }
 
     // begin iterating over the grid in parallel
     EntityIterator beginParallel()
     {
-        mutex_.lock();
-        auto tmp = sequentialIt_;
-        if (sequentialIt_ != sequentialEnd_)
-            ++sequentialIt_; // make the next thread look at the next element
-        mutex_.unlock();
+        ThreadState_& state = threadState_[threadId_()];
+        claimChunk_(state);
 
-        return tmp;
+        return state.it;
     }
 
     // returns true if the last element was reached
     bool isFinished(const EntityIterator& it) const
-    { return it == sequentialEnd_; }
+    { return it == chunks_->end(); }
 
     // prefix increment: goes to the next element which is not yet worked on by any
     // thread
     EntityIterator increment()
     {
-        mutex_.lock();
-        auto tmp = sequentialIt_;
-        if (sequentialIt_ != sequentialEnd_)
-            ++sequentialIt_;
-        mutex_.unlock();
+        ThreadState_& state = threadState_[threadId_()];
+        if (state.remaining > 1) {
+            // continue with the next entity of the current chunk
+            ++state.it;
+            -- state.remaining;
+        }
+        else
+            // the current chunk is done. get a new one
+            claimChunk_(state);
 
-        return tmp;
+        return state.it;
     }
 
+    /*!
+     * \brief Returns the number of entities which are handed to a thread at once.
+     */
+    unsigned chunkSize() const
+    { return chunks_->chunkSize(); }
+
+    /*!
+     * \brief Returns the number of chunks into which the entities have been partitioned.
+     */
+    unsigned numChunks() const
+    { return chunks_->numChunks(); }
+
 private:
-    GridView gridView_;
-    EntityIterator sequentialIt_;
-    EntityIterator sequentialEnd_;
+    void claimChunk_(ThreadState_& state)
+    {
+        unsigned chunkIdx = nextChunkIdx_.fetch_add(1, std::memory_order_relaxed);
+        if (chunkIdx >= chunks_->numChunks()) {
+            // all chunks have already been handed out
+            state.it = chunks_->end();
+            state.remaining = 0;
+            return;
+        }
+
+        state.it = chunks_->chunkBegin(chunkIdx);
+        state.remaining = chunks_->chunkLength(chunkIdx);
+    }
+
+    static unsigned threadId_()
+    {
+#ifdef _OPENMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    std::shared_ptr<const Chunks> chunks_;
+    std::vector<ThreadState_,
+                Ewoms::aligned_allocator<ThreadState_, alignof(ThreadState_)> > threadState_;
 
-    OmpMutex mutex_;
+    std::atomic<unsigned> nextChunkIdx_;
 };
 } // namespace Ewoms
 
@@ -0,0 +1,116 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Linear systems of equations which are shared by the tests of the linear
+ *        solvers and preconditioners.
+ */
+#ifndef EWOMS_TEST_LINEAR_SYSTEMS_HH
+#define EWOMS_TEST_LINEAR_SYSTEMS_HH
+
+#include <algorithm>
+#include <cmath>
+
+/*!
+ * \brief Assemble the five-point stencil of -Delta u + c grad u on a n x n grid.
+ *
+ * If the matrix has blocks larger than 1x1, the unknowns of a grid cell are coupled by
+ * the diagonal block while the off-diagonal blocks are multiples of the identity.
+ */
+template <class Matrix>
+void createMatrix(Matrix &A, int n, typename Matrix::field_type convection)
+{
+    typedef typename Matrix::field_type Scalar;
+    typedef typename Matrix::block_type MatrixBlock;
+    enum { blockSize = MatrixBlock::rows };
+
+    int N = n*n;
+    A.setSize(N, N, 5*N);
+    A.setBuildMode(Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        int i = row.index()%n;
+        int j = row.index()/n;
+        row.insert(row.index());
+        if (i > 0)
+            row.insert(row.index() - 1);
+        if (i < n - 1)
+            row.insert(row.index() + 1);
+        if (j > 0)
+            row.insert(row.index() - n);
+        if (j < n - 1)
+            row.insert(row.index() + n);
+    }
+
+    MatrixBlock identity(0.0);
+    MatrixBlock diagBlock(0.0);
+    for (int k = 0; k < blockSize; ++k) {
+        identity[k][k] = 1.0;
+        diagBlock[k][k] = 4.0;
+        if (k > 0) {
+            diagBlock[k - 1][k] = 1.0;
+            diagBlock[k][k - 1] = 0.5;
+        }
+    }
+
+    Scalar h = 1.0/(n + 1);
+    for (int rowIdx = 0; rowIdx < N; ++rowIdx) {
+        int i = rowIdx%n;
+        int j = rowIdx/n;
+        A[rowIdx][rowIdx] = diagBlock;
+        if (i > 0) {
+            A[rowIdx][rowIdx - 1] = identity;
+            A[rowIdx][rowIdx - 1] *= -1.0 - convection*h/2;
+        }
+        if (i < n - 1) {
+            A[rowIdx][rowIdx + 1] = identity;
+            A[rowIdx][rowIdx + 1] *= -1.0 + convection*h/2;
+        }
+        if (j > 0) {
+            A[rowIdx][rowIdx - n] = identity;
+            A[rowIdx][rowIdx - n] *= -1.0;
+        }
+        if (j < n - 1) {
+            A[rowIdx][rowIdx + n] = identity;
+            A[rowIdx][rowIdx + n] *= -1.0;
+        }
+    }
+}
+
+/*!
+ * \brief Returns the maximum norm of the difference of two block vectors.
+ */
+template <class Vector>
+typename Vector::field_type maxDifference(const Vector &x, const Vector &y)
+{
+    typedef typename Vector::field_type Scalar;
+    typedef typename Vector::block_type VectorBlock;
+
+    Scalar result = 0.0;
+    for (unsigned i = 0; i < x.size(); ++i)
+        for (unsigned k = 0; k < VectorBlock::dimension; ++k)
+            result = std::max<Scalar>(result, std::abs(x[i][k] - y[i][k]));
+    return result;
+}
+
+#endif
@@ -64,6 +64,8 @@ NEW_PROP_TAG(MaxDepth);
 NEW_PROP_TAG(Temperature);
 // The width of producer/injector wells as a fraction of the width of the spatial domain
 NEW_PROP_TAG(WellWidth);
+// The prefix of the name of the simulation
+NEW_PROP_TAG(SimulationName);
 
 // Set the grid type
 SET_TYPE_PROP(ReservoirBaseProblem, Grid, Dune::YaspGrid<2>);
@@ -100,6 +102,7 @@ SET_BOOL_PROP(ReservoirBaseProblem, EnableConstraints, true);
 // set the defaults for some problem specific properties
 SET_SCALAR_PROP(ReservoirBaseProblem, MaxDepth, 2500);
 SET_SCALAR_PROP(ReservoirBaseProblem, Temperature, 293.15);
+SET_STRING_PROP(ReservoirBaseProblem, SimulationName, "reservoir");
 
 //! The default for the end time of the simulation [s].
 //!
@@ -383,13 +386,19 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, WellWidth,
                              "The width of producer/injector wells as a fraction of the width"
                              " of the spatial domain");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, SimulationName,
+                             "The name of the simulation used for the output "
+                             "files");
     }
 
     /*!
      * \copydoc FvBaseProblem::name
      */
     std::string name() const
-    { return std::string("reservoir_") + Model::name() + "_" + Model::discretizationName(); }
+    {
+        return EWOMS_GET_PARAM(TypeTag, std::string, SimulationName)
+            + "_" + Model::name() + "_" + Model::discretizationName();
+    }
 
     /*!
      * \copydoc FvBaseProblem::endEpisode
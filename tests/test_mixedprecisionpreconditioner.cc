@@ -0,0 +1,186 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This test makes sure that the preconditioners which are applied in single
+ *        precision (FloatSSOR, FloatILU0 and FloatILUn) approximate their double
+ *        precision counterparts and that they can be used to solve linear systems to
+ *        a tolerance below the precision of their own floating point type.
+ *
+ * The linear systems are discretizations of a convection-diffusion equation on a
+ * structured 2D grid.
+ */
+#include "config.h"
+
+#include "linearsystems.hh"
+
+#include <ewoms/linear/mixedprecisionpreconditioner.hh>
+#include <ewoms/linear/solvers.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+typedef double Scalar;
+typedef Dune::FieldVector<Scalar, 1> VectorBlock;
+typedef Dune::FieldMatrix<Scalar, 1, 1> MatrixBlock;
+typedef Dune::BlockVector<VectorBlock> Vector;
+typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+
+typedef Ewoms::Linear::MixedPrecisionPreconditioner<Matrix, Vector, Vector,
+                                                    Dune::SeqSSOR> FloatSSOR;
+typedef Ewoms::Linear::MixedPrecisionPreconditioner<Matrix, Vector, Vector,
+                                                    Dune::SeqILU0> FloatILU0;
+typedef Ewoms::Linear::MixedPrecisionPreconditioner<Matrix, Vector, Vector,
+                                                    Dune::SeqILUn> FloatILUn;
+
+// function prototypes
+template <class Preconditioner, class FloatPreconditioner>
+bool comparePreconditioners(const std::string &name,
+                            Preconditioner &prec,
+                            FloatPreconditioner &floatPrec,
+                            Operator &op);
+bool testSSOR();
+bool testILU0();
+bool testILUn();
+
+// apply the double and the single precision variants of a preconditioner to the same
+// defect, compare the results and solve a linear system using the single precision one
+template <class Preconditioner, class FloatPreconditioner>
+bool comparePreconditioners(const std::string &name,
+                            Preconditioner &prec,
+                            FloatPreconditioner &floatPrec,
+                            Operator &op)
+{
+    int N = op.getmat().N();
+
+    Vector d(N);
+    for (int i = 0; i < N; ++i)
+        d[i] = std::sin(0.1*i);
+
+    Vector x1(N), d1(d);
+    x1 = 0.0;
+    prec.pre(x1, d1);
+    prec.apply(x1, d1);
+    prec.post(x1);
+
+    Vector x2(N), d2(d);
+    x2 = 0.0;
+    floatPrec.pre(x2, d2);
+    floatPrec.apply(x2, d2);
+    floatPrec.post(x2);
+
+    // the difference must be in the order of the precision of float
+    Scalar diff = maxDifference(x1, x2);
+    std::cout << name << ": maximum difference " << diff << "\n";
+    if (diff > 1e-4*x1.infinity_norm()) {
+        std::cerr << name << ": results of the single and of the double precision "
+                  << "preconditioner differ too much\n";
+        return false;
+    }
+
+    // the exact solution
+    Vector xExact(N);
+    for (int i = 0; i < N; ++i)
+        xExact[i] = std::sin(0.1*i) + 1.0;
+
+    Vector b(N);
+    op.getmat().mv(xExact, b);
+
+    // the preconditioner is only an approximation of the inverse of the matrix, so its
+    // precision does not limit the precision of the solution
+    Vector x(N);
+    x = 0.0;
+    Dune::InverseOperatorResult res;
+    Ewoms::BiCGSTABSolver<Vector> solver(op, floatPrec, 1e-10, 1000, 0);
+    solver.apply(x, b, res);
+
+    if (!res.converged) {
+        std::cerr << name << ": linear solver did not converge\n";
+        return false;
+    }
+
+    Scalar err = maxDifference(x, xExact);
+    if (err > 1e-5) {
+        std::cerr << name << ": solution is wrong (error " << err << ")\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool testSSOR()
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    Operator op(A);
+    Dune::SeqSSOR<Matrix, Vector, Vector> prec(A, 1, 1.0);
+    FloatSSOR floatPrec(A, 1, 1.0);
+
+    return comparePreconditioners("FloatSSOR", prec, floatPrec, op);
+}
+
+bool testILU0()
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    Operator op(A);
+    Dune::SeqILU0<Matrix, Vector, Vector> prec(A, 1.0);
+    FloatILU0 floatPrec(A, 1.0);
+
+    return comparePreconditioners("FloatILU0", prec, floatPrec, op);
+}
+
+bool testILUn()
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    Operator op(A);
+    Dune::SeqILUn<Matrix, Vector, Vector> prec(A, 1, 1.0);
+    FloatILUn floatPrec(A, 1, 1.0);
+
+    return comparePreconditioners("FloatILUn", prec, floatPrec, op);
+}
+
+int main(int argc, char **argv)
+{
+    // initialize MPI, finalize is done automatically on exit
+    Dune::MPIHelper::instance(argc, argv);
+
+    bool success = true;
+    success = testSSOR() && success;
+    success = testILU0() && success;
+    success = testILUn() && success;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This test makes sure that the pipelined Krylov solvers yield the same
+ *        results as their classic counterparts.
+ *
+ * The linear systems are discretizations of the Poisson equation and of a
+ * convection-diffusion equation on a structured 2D grid. In addition, it is
+ * tested that folding the global maxima of the weighted residual criterion into
+ * the reductions of the scalar products does not change the convergence
+ * behaviour.
+ */
+#include "config.h"
+
+#include "linearsystems.hh"
+
+#include <ewoms/linear/solvers.hh>
+#include <ewoms/linear/fusedscalarproduct.hh>
+#include <ewoms/linear/weightedresidreductioncriterion.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+
+typedef double Scalar;
+typedef Dune::FieldVector<Scalar, 1> VectorBlock;
+typedef Dune::FieldMatrix<Scalar, 1, 1> MatrixBlock;
+typedef Dune::BlockVector<VectorBlock> Vector;
+typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+typedef Dune::CollectiveCommunication<Dune::MPIHelper::MPICommunicator> Comm;
+
+// a sequential scalar product which supports the fused reductions
+class SeqFusedScalarProduct : public Ewoms::Linear::FusedScalarProduct<Vector>
+{
+public:
+    enum { category = Dune::SolverCategory::sequential };
+
+    Scalar dot(const Vector &x, const Vector &y)
+    { return x*y; }
+
+    Scalar norm(const Vector &x)
+    { return x.two_norm(); }
+};
+
+// function prototypes
+bool compareSolvers(const std::string &name,
+                    Ewoms::InverseOperator<Vector, Vector> &solver,
+                    Ewoms::InverseOperator<Vector, Vector> &pipelinedSolver,
+                    const Operator &op,
+                    int maxIterationDifference);
+bool testCG();
+bool testBiCGSTAB();
+bool testFoldedCriterion();
+
+// solve the same system with both solvers and compare the results
+bool compareSolvers(const std::string &name,
+                    Ewoms::InverseOperator<Vector, Vector> &solver,
+                    Ewoms::InverseOperator<Vector, Vector> &pipelinedSolver,
+                    const Operator &op,
+                    int maxIterationDifference)
+{
+    int N = op.getmat().N();
+
+    // the exact solution
+    Vector xExact(N);
+    for (int i = 0; i < N; ++i)
+        xExact[i] = std::sin(0.1*i) + 1.0;
+
+    Vector b(N);
+    op.getmat().mv(xExact, b);
+
+    Vector x1(N), b1(b);
+    x1 = 0.0;
+    Dune::InverseOperatorResult res1;
+    solver.apply(x1, b1, res1);
+
+    Vector x2(N), b2(b);
+    x2 = 0.0;
+    Dune::InverseOperatorResult res2;
+    pipelinedSolver.apply(x2, b2, res2);
+
+    std::cout << name << ": " << res1.iterations << " iterations (classic), "
+              << res2.iterations << " iterations (pipelined)\n";
+
+    if (!res1.converged || !res2.converged) {
+        std::cerr << name << ": linear solver did not converge\n";
+        return false;
+    }
+
+    if (std::abs(res1.iterations - res2.iterations) > maxIterationDifference) {
+        std::cerr << name << ": number of iterations differs too much\n";
+        return false;
+    }
+
+    Scalar diff = maxDifference(x1, x2);
+    Scalar err = maxDifference(x2, xExact);
+    if (diff > 1e-5 || err > 1e-5) {
+        std::cerr << name << ": solutions differ (difference " << diff
+                  << ", error " << err << ")\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool testCG()
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/0.0);
+    Operator op(A);
+    Dune::SeqJac<Matrix, Vector, Vector> prec(A, 1, 1.0);
+
+    Ewoms::CGSolver<Vector> cg(op, prec, 1e-10, 1000, 0);
+    Ewoms::PipelinedCGSolver<Vector> pcg(op, prec, 1e-10, 1000, 0);
+
+    // the pipelined CG is mathematically equivalent to CG, so the number of
+    // iterations must be almost the same
+    return compareSolvers("CG", cg, pcg, op, /*maxIterationDifference=*/2);
+}
+
+bool testBiCGSTAB()
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    Operator op(A);
+    Dune::SeqILU0<Matrix, Vector, Vector> prec(A, 1.0);
+
+    Ewoms::BiCGSTABSolver<Vector> bicgstab(op, prec, 1e-10, 1000, 0);
+    Ewoms::PipelinedBiCGSTABSolver<Vector> pbicgstab(op, prec, 1e-10, 1000, 0);
+
+    // BiCGSTAB counts half iterations and is less robust against rounding errors
+    return compareSolvers("BiCGSTAB", bicgstab, pbicgstab, op, /*maxIterationDifference=*/5);
+}
+
+bool testFoldedCriterion()
+{
+    typedef Ewoms::WeightedResidualReductionCriterion<Vector, Comm> Criterion;
+
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    Operator op(A);
+    Dune::SeqILU0<Matrix, Vector, Vector> prec(A, 1.0);
+    Comm comm = Dune::MPIHelper::getCollectiveCommunication();
+
+    // the criterion does its own communication
+    Dune::SeqScalarProduct<Vector> seqSp;
+    Ewoms::PipelinedBiCGSTABSolver<Vector> solver(op, seqSp, prec, 1e-10, 1000, 0);
+    solver.setConvergenceCriterion(std::make_shared<Criterion>(comm, Vector(), 0.0, 1e-10));
+
+    // the maxima of the criterion are determined by the reductions of the solver
+    SeqFusedScalarProduct fusedSp;
+    Ewoms::PipelinedBiCGSTABSolver<Vector> foldedSolver(op, fusedSp, prec, 1e-10, 1000, 0);
+    foldedSolver.setConvergenceCriterion(std::make_shared<Criterion>(comm, Vector(), 0.0, 1e-10));
+
+    if (!compareSolvers("folded criterion", solver, foldedSolver, op, /*maxIterationDifference=*/0))
+        return false;
+
+    // the same for the solvers which update the criterion after the reduction
+    Ewoms::BiCGSTABSolver<Vector> solver2(op, seqSp, prec, 1e-10, 1000, 0);
+    solver2.setConvergenceCriterion(std::make_shared<Criterion>(comm, Vector(), 0.0, 1e-10));
+
+    Ewoms::BiCGSTABSolver<Vector> foldedSolver2(op, fusedSp, prec, 1e-10, 1000, 0);
+    foldedSolver2.setConvergenceCriterion(std::make_shared<Criterion>(comm, Vector(), 0.0, 1e-10));
+
+    return compareSolvers("folded criterion", solver2, foldedSolver2, op, /*maxIterationDifference=*/0);
+}
+
+int main(int argc, char **argv)
+{
+    // initialize MPI, finalize is done automatically on exit
+    Dune::MPIHelper::instance(argc, argv);
+
+    bool success = true;
+    success = testCG() && success;
+    success = testBiCGSTAB() && success;
+    success = testFoldedCriterion() && success;
+
+    return success ? 0 : 1;
+}
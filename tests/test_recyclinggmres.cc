@@ -0,0 +1,182 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This test makes sure that the GMRes solver which recycles a deflation subspace
+ *        solves a sequence of slowly changing linear systems correctly and that it does
+ *        not need more iterations for this than the restarted GMRes solver.
+ *
+ * The linear systems are discretizations of a convection-diffusion equation on a
+ * structured 2D grid whose convection velocity slightly changes from one system to the
+ * next, which is similar to the sequence of systems of a Newton method.
+ */
+#include "config.h"
+
+#include "linearsystems.hh"
+
+#include <ewoms/linear/solvers.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <cmath>
+#include <iostream>
+
+typedef double Scalar;
+typedef Dune::FieldVector<Scalar, 1> VectorBlock;
+typedef Dune::FieldMatrix<Scalar, 1, 1> MatrixBlock;
+typedef Dune::BlockVector<VectorBlock> Vector;
+typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+
+// function prototypes
+bool solve(Ewoms::InverseOperator<Vector, Vector> &solver,
+           const Operator &op,
+           int &numIterations);
+bool testSequence();
+bool testClearedSpace();
+
+// solve a system with a known solution and check the result
+bool solve(Ewoms::InverseOperator<Vector, Vector> &solver,
+           const Operator &op,
+           int &numIterations)
+{
+    int N = op.getmat().N();
+
+    // the exact solution
+    Vector xExact(N);
+    for (int i = 0; i < N; ++i)
+        xExact[i] = std::sin(0.1*i) + 1.0;
+
+    Vector b(N);
+    op.getmat().mv(xExact, b);
+
+    Vector x(N);
+    x = 0.0;
+    Dune::InverseOperatorResult res;
+    solver.apply(x, b, res);
+    numIterations = res.iterations;
+
+    if (!res.converged) {
+        std::cerr << "linear solver did not converge\n";
+        return false;
+    }
+
+    Scalar err = maxDifference(x, xExact);
+    if (err > 1e-5) {
+        std::cerr << "solution is wrong (error " << err << ")\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool testSequence()
+{
+    static const int numSystems = 5;
+    static const int restart = 10;
+
+    Ewoms::GMResRecycleSpace<Vector> recycleSpace(/*maxSize=*/5);
+
+    int totalIterations = 0;
+    int totalRecyclingIterations = 0;
+    for (int systemIdx = 0; systemIdx < numSystems; ++systemIdx) {
+        Matrix A;
+        createMatrix(A, /*n=*/50, /*convection=*/20.0 + systemIdx);
+        Operator op(A);
+        Dune::SeqILU0<Matrix, Vector, Vector> prec(A, 1.0);
+
+        // the solvers are re-created for each system as it is done by the linear
+        // solver backend
+        int numIterations;
+        Ewoms::RestartedGMResSolver<Vector> gmres(op, prec, 1e-10, restart, 1000, 0);
+        if (!solve(gmres, op, numIterations))
+            return false;
+        totalIterations += numIterations;
+
+        int numRecyclingIterations;
+        Ewoms::RecyclingGMResSolver<Vector> recyclingGMRes(op, prec, recycleSpace,
+                                                          1e-10, restart, 1000, 0);
+        if (!solve(recyclingGMRes, op, numRecyclingIterations))
+            return false;
+        totalRecyclingIterations += numRecyclingIterations;
+
+        std::cout << "system " << systemIdx << ": " << numIterations
+                  << " iterations (restarted), " << numRecyclingIterations
+                  << " iterations (recycling)\n";
+
+        if (recycleSpace.size() != recycleSpace.maxSize()) {
+            std::cerr << "the recycled subspace has not been filled\n";
+            return false;
+        }
+    }
+
+    // the whole point of recycling the subspace is to avoid the stagnation of the
+    // restarted method
+    if (totalRecyclingIterations > totalIterations) {
+        std::cerr << "the recycling GMRes solver needs more iterations than the "
+                  << "restarted one (" << totalRecyclingIterations << " vs. "
+                  << totalIterations << ")\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool testClearedSpace()
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    Operator op(A);
+    Dune::SeqILU0<Matrix, Vector, Vector> prec(A, 1.0);
+
+    // a subspace which has been recycled from a different system must be discarded if
+    // the structure of the matrix changes. make sure that the solver still works with
+    // an empty recycle space afterwards.
+    Ewoms::GMResRecycleSpace<Vector> recycleSpace(/*maxSize=*/5);
+    int numIterations;
+    Ewoms::RecyclingGMResSolver<Vector> solver(op, prec, recycleSpace, 1e-10, 10, 1000, 0);
+    if (!solve(solver, op, numIterations))
+        return false;
+
+    recycleSpace.clear();
+    return solve(solver, op, numIterations);
+}
+
+int main(int argc, char **argv)
+{
+    // initialize MPI, finalize is done automatically on exit
+    Dune::MPIHelper::instance(argc, argv);
+
+    bool success = true;
+    success = testSequence() && success;
+    success = testClearedSpace() && success;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This test makes sure that the ILU(0) preconditioner which uses multiple
+ *        threads yields the same results as Dune::SeqILU0.
+ *
+ * The matrix is the discretization of a convection-diffusion equation for two
+ * coupled unknowns on a structured 2D grid.
+ */
+#include "config.h"
+
+#include "linearsystems.hh"
+
+#include <ewoms/linear/threadedilu0.hh>
+#include <ewoms/linear/solvers.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <cmath>
+#include <iostream>
+
+typedef double Scalar;
+typedef Dune::FieldVector<Scalar, 2> VectorBlock;
+typedef Dune::FieldMatrix<Scalar, 2, 2> MatrixBlock;
+typedef Dune::BlockVector<VectorBlock> Vector;
+typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+typedef Ewoms::Linear::ThreadedILU0<Matrix, Vector, Vector> ThreadedILU0;
+
+// function prototypes
+bool testApply(int numThreads, Scalar relaxationFactor);
+bool testSolve(int numThreads);
+
+// apply both preconditioners to the same defect and compare the corrections
+bool testApply(int numThreads, Scalar relaxationFactor)
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    int N = A.N();
+
+    Dune::SeqILU0<Matrix, Vector, Vector> seqIlu(A, relaxationFactor);
+
+    Ewoms::Linear::TriangularLevelSchedule schedule;
+    schedule.update(A);
+    ThreadedILU0 threadedIlu(A, schedule, relaxationFactor, numThreads);
+
+    Vector d(N);
+    for (int i = 0; i < N; ++i) {
+        d[i][0] = std::sin(0.1*i);
+        d[i][1] = std::cos(0.3*i);
+    }
+
+    Vector x1(N), d1(d);
+    x1 = 0.0;
+    seqIlu.pre(x1, d1);
+    seqIlu.apply(x1, d1);
+    seqIlu.post(x1);
+
+    Vector x2(N), d2(d);
+    x2 = 0.0;
+    threadedIlu.pre(x2, d2);
+    threadedIlu.apply(x2, d2);
+    threadedIlu.post(x2);
+
+    // the operations are done in the same order for each row, so only rounding errors
+    // are tolerated
+    Scalar diff = maxDifference(x1, x2);
+    std::cout << numThreads << " threads, relaxation factor " << relaxationFactor
+              << ": maximum difference " << diff << "\n";
+    if (diff > 1e-12*x1.infinity_norm()) {
+        std::cerr << "results of the threaded and of the sequential ILU(0) differ\n";
+        return false;
+    }
+
+    return true;
+}
+
+// use the preconditioner for a Krylov solver
+bool testSolve(int numThreads)
+{
+    Matrix A;
+    createMatrix(A, /*n=*/50, /*convection=*/20.0);
+    int N = A.N();
+    Operator op(A);
+
+    Ewoms::Linear::TriangularLevelSchedule schedule;
+    schedule.update(A);
+    ThreadedILU0 prec(A, schedule, 1.0, numThreads);
+
+    Vector xExact(N);
+    for (int i = 0; i < N; ++i)
+        xExact[i] = std::sin(0.1*i) + 1.0;
+
+    Vector b(N);
+    A.mv(xExact, b);
+
+    Vector x(N);
+    x = 0.0;
+    Dune::InverseOperatorResult res;
+    Ewoms::BiCGSTABSolver<Vector> solver(op, prec, 1e-10, 1000, 0);
+    solver.apply(x, b, res);
+
+    if (!res.converged) {
+        std::cerr << "linear solver did not converge\n";
+        return false;
+    }
+
+    Scalar err = maxDifference(x, xExact);
+    if (err > 1e-5) {
+        std::cerr << "solution is wrong (error " << err << ")\n";
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // initialize MPI, finalize is done automatically on exit
+    Dune::MPIHelper::instance(argc, argv);
+
+    bool success = true;
+    success = testApply(/*numThreads=*/1, /*relaxationFactor=*/1.0) && success;
+    success = testApply(/*numThreads=*/4, /*relaxationFactor=*/1.0) && success;
+    success = testApply(/*numThreads=*/4, /*relaxationFactor=*/0.9) && success;
+    success = testSolve(/*numThreads=*/4) && success;
+
+    return success ? 0 : 1;
+}